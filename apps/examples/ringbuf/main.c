@@ -40,10 +40,10 @@
 #include "pal/pal.h"
 #include "state.h"
 
-static void ticker_cb(void* param) {
+static uint32_t ticker_cb(void* param, uint32_t ticks) {
     struct am_timer* timer = param;
 
-    am_timer_tick_iterator_init(timer);
+    am_timer_tick_iterator_init_x(timer, ticks);
     struct am_timer_event* fired = NULL;
     while ((fired = am_timer_tick_iterator_next(timer)) != NULL) {
         void* owner = AM_CAST(struct am_timer_event_x*, fired)->ctx;
@@ -53,6 +53,12 @@ static void ticker_cb(void* param) {
             am_ao_publish(&fired->event);
         }
     }
+    return am_timer_get_next_deadline(timer);
+}
+
+static void timer_arm_cb(void* ctx) {
+    const int* ticker = ctx;
+    am_ticker_notify(*ticker);
 }
 
 static void test_ringbuf_threading(void) {
@@ -72,6 +78,15 @@ static void test_ringbuf_threading(void) {
 
     am_ao_global_init(/*cfg=*/NULL, /*sub=*/NULL, /*nsub=*/0);
 
+    /* the ticker sleeps till the next timer event is due */
+    int ticker = am_ticker_create(&(struct am_ticker_cfg){
+        .timebase = AM_TIMEBASE_DEFAULT,
+        .tickless_cb = ticker_cb,
+        .ctx = &timer,
+        .priority_hint = AM_AO_PRIO_MIN
+    });
+    am_timer_register_arm_cb(&timer, timer_arm_cb, &ticker);
+
     ringbuf_reader_init(&ringbuf, &timer, data, (int)sizeof(data));
     ringbuf_writer_init(&ringbuf, &timer, data, (int)sizeof(data));
 
@@ -99,12 +114,6 @@ static void test_ringbuf_threading(void) {
         /*init_event=*/NULL
     );
 
-    int ticker = am_ticker_create(&(struct am_ticker_cfg){
-        .timebase = AM_TIMEBASE_DEFAULT,
-        .ticker_cb = ticker_cb,
-        .ctx = &timer,
-        .priority_hint = AM_AO_PRIO_MIN
-    });
     am_ticker_start(ticker);
 
     while (am_ao_get_cnt() > 0) {
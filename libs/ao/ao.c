@@ -30,6 +30,7 @@
 
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "common/compiler.h"
@@ -39,6 +40,7 @@
 #include "event/event_async.h"
 #include "event/event_queue.h"
 #include "pal/pal.h"
+#include "trace/trace.h"
 #include "ao/state.h"
 
 #include "ao/ao.h"
@@ -50,8 +52,26 @@ bool am_ao_event_queue_is_empty(struct am_ao* ao) {
     return am_event_queue_is_empty(&ao->event_queue);
 }
 
-bool am_ao_publish_exclude_x(
-    const struct am_event* event, const struct am_ao* ao, int margin
+/**
+ * Publish event to all subscribed active objects.
+ *
+ * @param event        the event to publish
+ * @param ao           do not post the event to this active object.
+ *                     Can be NULL.
+ * @param margin       the number of free event queue slots to be available
+ *                     in each subscribed active object after the event
+ *                     is pushed to their event queues
+ * @param all_or_none  deliver the event to all subscribed active objects
+ *                     or to none of them
+ *
+ * @retval true   the event was delivered to all subscribed active objects
+ * @retval false  at least one delivery of the event has failed
+ */
+static bool am_ao_publish_exclude_policy(
+    const struct am_event* event,
+    const struct am_ao* ao,
+    int margin,
+    bool all_or_none
 ) {
     AM_ASSERT(event);
     AM_ASSERT(AM_EVENT_HAS_USER_ID(event));
@@ -61,12 +81,31 @@ bool am_ao_publish_exclude_x(
 
     struct am_event_queue_policy policy = {
         .lifo = 0,
+        .all_or_none = all_or_none,
         .margin = margin,
         .exclude_id = ao ? ao->prio.ao : AM_EVENT_PUBLISHER_ID_NONE
     };
+    AM_TRACE(AM_TRACE_PUBLISH, AM_TRACE_PRIO_NONE, event);
+
     return am_event_async_publish(event, policy);
 }
 
+bool am_ao_publish_exclude_x(
+    const struct am_event* event, const struct am_ao* ao, int margin
+) {
+    return am_ao_publish_exclude_policy(
+        event, ao, margin, /*all_or_none=*/false
+    );
+}
+
+bool am_ao_publish_all_or_none(
+    const struct am_event* event, const struct am_ao* ao, int margin
+) {
+    return am_ao_publish_exclude_policy(
+        event, ao, margin, /*all_or_none=*/true
+    );
+}
+
 void am_ao_publish_exclude(
     const struct am_event* event, const struct am_ao* ao
 ) {
@@ -81,6 +120,40 @@ void am_ao_publish(const struct am_event* event) {
     am_ao_publish_exclude_x(event, /*ao=*/NULL, /*margin=*/0);
 }
 
+/**
+ * Post event to active object event queue.
+ *
+ * Lock-free event queues (see am_ao_set_event_queue_mpsc()) are
+ * accessed directly. Otherwise the event is posted via
+ * the asynchronous event handler of the active object.
+ *
+ * @param ao      the event is posted to this active object
+ * @param event   the event to post
+ * @param policy  the event queue handling policy
+ *
+ * @retval true   the event was posted
+ * @retval false  the event was not posted
+ */
+static bool am_ao_post_event(
+    struct am_ao* ao,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+) {
+    /* the event might be handled and freed right after the post */
+    AM_TRACE(AM_TRACE_POST, ao->prio.ao, event);
+
+    if (!ao->mpsc) {
+        return am_event_async_post(/*dest_id=*/ao->prio.ao, event, policy);
+    }
+    AM_ASSERT(event->id >= AM_EVT_USER);
+
+    enum am_rc rc = am_event_queue_push(&ao->event_queue, event, policy);
+    if (AM_RC_QUEUE_WAS_EMPTY == rc) {
+        am_ao_notify(ao);
+    }
+    return AM_RC_ERR != rc;
+}
+
 bool am_ao_post_fifo_x(
     struct am_ao* ao, const struct am_event* event, int margin
 ) {
@@ -92,7 +165,7 @@ bool am_ao_post_fifo_x(
 
     struct am_event_queue_policy policy = {.lifo = 0, .margin = margin};
 
-    return am_event_async_post(/*dest_id=*/ao->prio.ao, event, policy);
+    return am_ao_post_event(ao, event, policy);
 }
 
 void am_ao_post_fifo(struct am_ao* ao, const struct am_event* event) {
@@ -111,7 +184,7 @@ bool am_ao_post_lifo_x(
 
     struct am_event_queue_policy policy = {.lifo = 1, .margin = margin};
 
-    return am_event_async_post(/*dest_id=*/ao->prio.ao, event, policy);
+    return am_ao_post_event(ao, event, policy);
 }
 
 void am_ao_post_lifo(struct am_ao* ao, const struct am_event* event) {
@@ -119,6 +192,277 @@ void am_ao_post_lifo(struct am_ao* ao, const struct am_event* event) {
     AM_ASSERT(posted);
 }
 
+bool am_ao_post_x(
+    struct am_ao* ao,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+) {
+    AM_ASSERT(ao);
+    AM_ASSERT(AM_ATOMIC_LOAD_N(&ao->init_called));
+    AM_ASSERT(AM_ATOMIC_LOAD_N(&ao->running));
+    AM_ASSERT(event);
+    AM_ASSERT(policy.margin >= 0);
+    AM_ASSERT(!policy.coalesce || !ao->mpsc);
+
+    policy.all_or_none = 0;
+    policy.exclude_id = AM_EVENT_PUBLISHER_ID_NONE;
+
+    return am_ao_post_event(ao, event, policy);
+}
+
+int am_ao_post_fifo_many(
+    struct am_ao* ao,
+    const struct am_event* events[],
+    int nevents,
+    int margin,
+    bool all_or_none
+) {
+    AM_ASSERT(ao);
+    AM_ASSERT(AM_ATOMIC_LOAD_N(&ao->init_called));
+    AM_ASSERT(AM_ATOMIC_LOAD_N(&ao->running));
+    AM_ASSERT(events);
+    AM_ASSERT(nevents > 0);
+    AM_ASSERT(margin >= 0);
+
+    for (int i = 0; i < nevents; ++i) {
+        AM_ASSERT(events[i]);
+        AM_ASSERT(events[i]->id >= AM_EVT_USER);
+        /* the event might be handled and freed right after the post */
+        AM_TRACE(AM_TRACE_POST, ao->prio.ao, events[i]);
+    }
+    const struct am_event_queue_policy policy = {
+        .margin = margin, .all_or_none = all_or_none
+    };
+    int nposted = 0;
+
+    if (ao->mpsc) {
+        enum am_rc rc = am_event_queue_push_many(
+            &ao->event_queue, events, nevents, policy, &nposted
+        );
+        if (AM_RC_QUEUE_WAS_EMPTY == rc) {
+            am_ao_notify(ao);
+        }
+        return nposted;
+    }
+
+    struct am_ao_state* me = &am_ao_state_;
+    me->crit_enter();
+    enum am_rc rc = am_event_queue_push_many_unsafe(
+        &ao->event_queue, events, nevents, policy, &nposted
+    );
+    if (AM_RC_QUEUE_WAS_EMPTY == rc) {
+        am_ao_notify_unsafe(ao);
+    }
+    me->crit_exit();
+
+    return nposted;
+}
+
+/**
+ * Get the index of deferred event in deferred events store.
+ *
+ * @param defer  the deferred events store
+ * @param i      the deferred event number starting from the oldest one
+ *
+ * @return the index in am_ao_defer::events
+ */
+static int am_ao_defer_index(const struct am_ao_defer* defer, int i) {
+    unsigned ind = (unsigned)defer->rd + (unsigned)i;
+    return (int)(ind % (unsigned)defer->capacity);
+}
+
+void am_ao_defer_init(
+    struct am_ao_defer* defer, const struct am_event* events[], int nevents
+) {
+    AM_ASSERT(defer);
+    AM_ASSERT(events);
+    AM_ASSERT(nevents > 0);
+
+    memset(defer, 0, sizeof(*defer));
+    defer->events = events;
+    defer->capacity = nevents;
+}
+
+bool am_ao_defer(struct am_ao_defer* defer, const struct am_event* event) {
+    AM_ASSERT(defer);
+    AM_ASSERT(defer->events);
+    AM_ASSERT(event);
+
+    if (defer->nbusy == defer->capacity) {
+        return false;
+    }
+    am_event_inc_ref_cnt(event);
+
+    defer->events[am_ao_defer_index(defer, defer->nbusy)] = event;
+    ++defer->nbusy;
+
+    return true;
+}
+
+bool am_ao_recall(struct am_ao* ao, struct am_ao_defer* defer) {
+    AM_ASSERT(ao);
+    AM_ASSERT(defer);
+    AM_ASSERT(defer->events);
+
+    if (!defer->nbusy) {
+        return false;
+    }
+    const struct am_event_queue_policy policy = {.lifo = 1};
+
+    struct am_ao_state* me = &am_ao_state_;
+    me->crit_enter();
+    enum am_rc rc = am_event_queue_push_move_unsafe(
+        &ao->event_queue, defer->events[defer->rd], policy
+    );
+    if (AM_RC_QUEUE_WAS_EMPTY == rc) {
+        am_ao_notify_unsafe(ao);
+    }
+    me->crit_exit();
+
+    if (AM_RC_ERR == rc) {
+        return false;
+    }
+    defer->rd = am_ao_defer_index(defer, 1);
+    --defer->nbusy;
+
+    return true;
+}
+
+/**
+ * Drop recalled events from deferred events store.
+ *
+ * The recalled events are marked with NULL.
+ * The order of the remaining events is kept.
+ *
+ * @param defer      the deferred events store
+ * @param nrecalled  the number of recalled events
+ */
+static void am_ao_defer_compact(
+    struct am_ao_defer* defer, unsigned nrecalled
+) {
+    unsigned nbusy = (unsigned)defer->nbusy;
+    /* the oldest events are recalled most often */
+    while (nrecalled && !defer->events[defer->rd]) {
+        defer->rd = am_ao_defer_index(defer, 1);
+        --nbusy;
+        --nrecalled;
+    }
+    if (!nrecalled) {
+        defer->nbusy = (int)nbusy;
+        return;
+    }
+    unsigned n = 0;
+    for (unsigned i = 0; i < nbusy; ++i) {
+        const struct am_event* e =
+            defer->events[am_ao_defer_index(defer, (int)i)];
+        if (e) {
+            defer->events[am_ao_defer_index(defer, (int)n)] = e;
+            ++n;
+        }
+    }
+    defer->nbusy = (int)n;
+}
+
+/**
+ * Recall deferred events.
+ *
+ * The oldest deferred events with the given ID, which fit the event queue,
+ * are pushed to the front of the event queue from the newest to
+ * the oldest. So, the recalled events keep their order.
+ *
+ * @param ao     the active object
+ * @param defer  the deferred events store
+ * @param id     the ID of events to recall or -1 to recall all events
+ *
+ * @return the number of recalled events
+ */
+static int am_ao_recall_x(struct am_ao* ao, struct am_ao_defer* defer, int id) {
+    AM_ASSERT(ao);
+    AM_ASSERT(defer);
+    AM_ASSERT(defer->events);
+
+    /* unsigned counts keep gcc -Wstrict-overflow quiet */
+    const unsigned nbusy = (unsigned)defer->nbusy;
+    unsigned nmatch = nbusy;
+    if (id >= 0) {
+        nmatch = 0;
+        for (unsigned i = 0; i < nbusy; ++i) {
+            int ind = am_ao_defer_index(defer, (int)i);
+            nmatch += (defer->events[ind]->id == id) ? 1U : 0U;
+        }
+    }
+    if (!nmatch) {
+        return 0;
+    }
+    const struct am_event_queue_policy policy = {.lifo = 1};
+    struct am_event_queue* queue = &ao->event_queue;
+    unsigned nrecalled = 0;
+    bool was_empty = false;
+
+    struct am_ao_state* me = &am_ao_state_;
+    me->crit_enter();
+
+    const unsigned nfree =
+        (unsigned)am_event_queue_get_lane_nfree_unsafe(queue, /*lane=*/0);
+    unsigned nskip = (nmatch > nfree) ? (nmatch - nfree) : 0U;
+    /* from the newest to the oldest deferred event */
+    for (unsigned i = nbusy; i-- > 0U;) {
+        const struct am_event** e =
+            &defer->events[am_ao_defer_index(defer, (int)i)];
+        if ((id >= 0) && ((*e)->id != id)) {
+            continue;
+        }
+        if (nskip) {
+            --nskip; /* the newest events do not fit the queue */
+            continue;
+        }
+        enum am_rc rc = am_event_queue_push_move_unsafe(queue, *e, policy);
+        if (AM_RC_ERR == rc) {
+            break;
+        }
+        was_empty = was_empty || (AM_RC_QUEUE_WAS_EMPTY == rc);
+        *e = NULL;
+        ++nrecalled;
+    }
+    if (was_empty) {
+        am_ao_notify_unsafe(ao);
+    }
+
+    me->crit_exit();
+
+    am_ao_defer_compact(defer, nrecalled);
+
+    return (int)nrecalled;
+}
+
+int am_ao_recall_all(struct am_ao* ao, struct am_ao_defer* defer) {
+    return am_ao_recall_x(ao, defer, /*id=*/-1);
+}
+
+int am_ao_recall_id(struct am_ao* ao, struct am_ao_defer* defer, int id) {
+    AM_ASSERT(id >= AM_EVT_USER);
+    return am_ao_recall_x(ao, defer, id);
+}
+
+int am_ao_defer_get_nbusy(const struct am_ao_defer* defer) {
+    AM_ASSERT(defer);
+    return defer->nbusy;
+}
+
+int am_ao_defer_flush(struct am_ao_defer* defer) {
+    AM_ASSERT(defer);
+
+    struct am_ao_state* me = &am_ao_state_;
+    int n = defer->nbusy;
+    for (int i = 0; i < n; ++i) {
+        const struct am_event* e = defer->events[am_ao_defer_index(defer, i)];
+        am_event_free(me->alloc, e);
+    }
+    defer->rd = defer->nbusy = 0;
+
+    return n;
+}
+
 void am_ao_subscribe(const struct am_ao* ao, int event) {
     AM_ASSERT(ao);
     AM_ASSERT(AM_AO_PRIO_IS_VALID(ao->prio));
@@ -156,14 +500,155 @@ void am_ao_init(
     ao->init_called = true;
 }
 
+void am_ao_set_event_queue_mpsc(struct am_ao* ao) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->init_called);
+    AM_ASSERT(!AM_ATOMIC_LOAD_N(&ao->running));
+
+    ao->mpsc = true;
+}
+
+void am_ao_set_event_queue_lanes(
+    struct am_ao* ao,
+    struct am_event_queue_lane lanes[],
+    const int nevents[],
+    int nlanes
+) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->init_called);
+    AM_ASSERT(!AM_ATOMIC_LOAD_N(&ao->running));
+    AM_ASSERT(lanes);
+    AM_ASSERT(nevents);
+    AM_ASSERT(nlanes > 0);
+
+    ao->lanes = lanes;
+    ao->nlane_events = nevents;
+    ao->nlanes = nlanes;
+}
+
+void am_ao_set_stats(
+    struct am_ao* ao, struct am_ao_stats* stats, uint32_t stamps[], int nstamps
+) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->init_called);
+    AM_ASSERT(!AM_ATOMIC_LOAD_N(&ao->running));
+    AM_ASSERT(stats);
+
+    am_ao_set_event_stamps(ao, stamps, nstamps);
+
+    memset(stats, 0, sizeof(*stats));
+    ao->stats = stats;
+}
+
+void am_ao_set_event_stamps(struct am_ao* ao, uint32_t stamps[], int nstamps) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->init_called);
+    AM_ASSERT(!AM_ATOMIC_LOAD_N(&ao->running));
+    AM_ASSERT(stamps);
+    AM_ASSERT(nstamps > 0);
+
+    ao->stamps = stamps;
+    ao->nstamps = nstamps;
+}
+
+uint32_t am_ao_get_event_age(const struct am_ao* ao) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->stamps);
+
+    return ao->event_age;
+}
+
+void am_ao_get_stats(const struct am_ao* ao, struct am_ao_stats* stats) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->stats);
+    AM_ASSERT(stats);
+
+    struct am_ao_state* me = &am_ao_state_;
+    me->crit_enter();
+    *stats = *ao->stats;
+    me->crit_exit();
+}
+
+void am_ao_reset_stats(struct am_ao* ao) {
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->stats);
+
+    struct am_ao_state* me = &am_ao_state_;
+    me->crit_enter();
+    memset(ao->stats, 0, sizeof(*ao->stats));
+    me->crit_exit();
+}
+
+/**
+ * The default time source of active object statistics and event ages.
+ *
+ * Milliseconds are too coarse to tell apart the run times and queueing
+ * delays of typical event handlers.
+ *
+ * @return current time [us]
+ */
+static uint32_t am_ao_get_time_us(void) {
+    return am_time_get_ticks(AM_TIMEBASE_US);
+}
+
+/**
+ * Get histogram bucket of active object statistics.
+ *
+ * @param d  the duration
+ *
+ * @return the bucket index
+ */
+static int am_ao_stats_bucket(uint32_t d) {
+    if (!d) {
+        return 0;
+    }
+    int i = 64 - AM_CLZLL((unsigned long long)d);
+    return AM_MIN(i, AM_AO_STATS_NBUCKETS - 1);
+}
+
+void am_ao_dispatch(struct am_ao* ao, const struct am_event* event) {
+    AM_ATOMIC_STORE_N(&ao->last_event, event->id);
+    AM_TRACE(AM_TRACE_DISPATCH_BEGIN, ao->prio.ao, event);
+
+    if (AM_LIKELY(!ao->stamps)) {
+        ao->user_event_handler(ao->ctx, event);
+        AM_TRACE(AM_TRACE_DISPATCH_END, ao->prio.ao, event);
+        AM_ATOMIC_STORE_N(&ao->last_event, AM_EVT_EMPTY);
+        return;
+    }
+
+    struct am_ao_state* me = &am_ao_state_;
+    /* the event handler might stop the AO and deinit the event queue */
+    uint32_t post = am_event_queue_get_stamp_unsafe(&ao->event_queue);
+    struct am_ao_stats* stats = ao->stats;
+    uint32_t start = me->get_time();
+    uint32_t wait = start - post;
+    ao->event_age = wait;
+
+    ao->user_event_handler(ao->ctx, event);
+    AM_TRACE(AM_TRACE_DISPATCH_END, ao->prio.ao, event);
+
+    uint32_t run = stats ? (me->get_time() - start) : 0;
+    AM_ATOMIC_STORE_N(&ao->last_event, AM_EVT_EMPTY);
+    if (!stats) {
+        return;
+    }
+
+    me->crit_enter();
+    ++stats->run[am_ao_stats_bucket(run)];
+    ++stats->wait[am_ao_stats_bucket(wait)];
+    stats->run_max = AM_MAX(stats->run_max, run);
+    stats->wait_max = AM_MAX(stats->wait_max, wait);
+    ++stats->nevents;
+    me->crit_exit();
+}
+
 void am_ao_global_init(
     const struct am_ao_cfg* cfg, struct am_event_subscribe_list* sub, int nsub
 ) {
     struct am_ao_state* me = &am_ao_state_;
     memset(me, 0, sizeof(*me));
 
-    am_ao_global_init_();
-
     AM_ATOMIC_STORE_N(&me->init_complete, false);
 
     if (cfg) {
@@ -171,6 +656,7 @@ void am_ao_global_init(
         me->crit_exit = cfg->crit_exit;
         me->on_idle = cfg->on_idle;
         me->alloc = cfg->alloc;
+        me->get_time = cfg->get_time;
     } else {
         me->crit_enter = am_crit_enter;
         me->crit_exit = am_crit_exit;
@@ -178,13 +664,17 @@ void am_ao_global_init(
         me->alloc = NULL;
     }
 
-    me->running_ao_prio = AM_AO_PRIO_INVALID;
+    if (!me->get_time) {
+        me->get_time = am_ao_get_time_us;
+    }
 
     am_event_register_crit(me->crit_enter, me->crit_exit);
     am_event_async_global_init(sub, nsub, cfg ? cfg->alloc : NULL);
+
+    am_ao_global_init_(cfg);
 }
 
-void am_ao_global_deinit(void) {}
+void am_ao_global_deinit(void) { am_ao_global_deinit_(); }
 
 void am_ao_crash_dump_event_queues_unsafe(
     int num,
@@ -254,5 +744,16 @@ bool am_ao_event_handler_unsafe(
     if (AM_RC_QUEUE_WAS_EMPTY == rc) {
         am_ao_notify_unsafe(ao);
     }
-    return true;
+    return AM_RC_ERR != rc;
+}
+
+bool am_ao_event_check_unsafe(void* ctx, struct am_event_queue_policy policy) {
+    AM_ASSERT(ctx);
+    AM_ASSERT(policy.margin >= 0);
+
+    const struct am_ao* ao = ctx;
+    int nfree =
+        am_event_queue_get_lane_nfree_unsafe(&ao->event_queue, policy.lane);
+
+    return nfree > policy.margin;
 }
@@ -34,6 +34,7 @@
 #define AM_AO_H_INCLUDED
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "common/macros.h"
 #include "event/event_common.h"
@@ -41,15 +42,34 @@
 #include "pal/pal.h"
 
 #ifndef AM_AO_NUM_MAX
-/** The maximum number of active objects. */
+/**
+ * The maximum number of active objects.
+ *
+ * Must not exceed #AM_EVT_HANDLERS_NUM_MAX.
+ * Preemptive AO port also requires it not to exceed #AM_TASK_NUM_MAX.
+ */
 #define AM_AO_NUM_MAX 64
 #endif
 
+#ifndef AM_AO_THREADS_NUM_MAX
+/** The maximum number of AO scheduler threads. */
+#define AM_AO_THREADS_NUM_MAX 16
+#endif
+
+#ifndef AM_AO_STATS_NBUCKETS
+/**
+ * The number of buckets of active object statistics histograms.
+ *
+ * See struct am_ao_stats for details.
+ */
+#define AM_AO_STATS_NBUCKETS 32
+#endif
+
 struct am_ao_prio;
 
 /** Invalid AO priority. */
 #define AM_AO_PRIO_INVALID \
-    (struct am_ao_prio){.ao = (unsigned char)-1, .task = (unsigned char)-1}
+    (struct am_ao_prio){.ao = (unsigned short)-1, .task = (unsigned short)-1}
 /** The minimum AO priority level. */
 #define AM_AO_PRIO_MIN 0
 /** The maximum AO priority level. */
@@ -71,27 +91,78 @@ struct am_ao_prio;
  * @retval false  the priority is invalid.
  */
 #define AM_AO_PRIO_IS_VALID(prio) \
-    (((prio).ao <= AM_AO_PRIO_MAX) && ((prio).task <= AM_AO_PRIO_MAX))
+    (((prio).ao <= AM_AO_PRIO_MAX) && ((prio).task < AM_TASK_NUM_MAX))
 
-AM_ASSERT_STATIC(AM_AO_NUM_MAX <= AM_TASK_NUM_MAX);
 AM_ASSERT_STATIC(AM_AO_NUM_MAX <= AM_EVT_HANDLERS_NUM_MAX);
+AM_ASSERT_STATIC(AM_AO_NUM_MAX < 0xFFFF);
+AM_ASSERT_STATIC(AM_TASK_NUM_MAX < 0xFFFF);
 
 /** AO priorities. */
 struct am_ao_prio {
     /**
      * Define the priority of active object.
-     * Used by AO library. Valid range [0, #AM_TASK_NUM_MAX[.
+     * Used by AO library. Valid range [0, #AM_AO_NUM_MAX[.
      * Must be unique for different active objects.
      * Used by both cooperative and preemptive ports of active objects.
      */
-    unsigned ao : 8;
+    unsigned ao : 16;
     /**
      * Define the priority of the task, which runs active object.
      * Used by PAL library. Valid range [0, #AM_TASK_NUM_MAX[.
      * More than one active object may have same task priority.
-     * Only used by preemptive port of active objects.
+     * Used by preemptive port of active objects.
+     * Cooperative port with more than one scheduler thread uses it to
+     * select the thread running the active object
+     * (see am_ao_cfg::nthreads).
+     * Not used by thread pool port.
      */
-    unsigned task : 8;
+    unsigned task : 16;
+};
+
+/**
+ * Active object statistics.
+ *
+ * The histograms have log2 buckets. The bucket 0 counts zero durations.
+ * The bucket i > 0 counts durations d with 2^(i-1) <= d < 2^i.
+ * The last bucket also counts all longer durations.
+ * The durations are in the units of am_ao_cfg::get_time().
+ */
+struct am_ao_stats {
+    /** event handler run time histogram */
+    uint32_t run[AM_AO_STATS_NBUCKETS];
+    /** event queueing delay (post to dispatch) histogram */
+    uint32_t wait[AM_AO_STATS_NBUCKETS];
+    uint32_t run_max;  /**< the longest event handler run time */
+    uint32_t wait_max; /**< the longest event queueing delay */
+    uint32_t nevents;  /**< the number of handled events */
+};
+
+/**
+ * Blocking post statistics of active object.
+ *
+ * See am_ao_post_fifo_wait() and am_ao_get_post_wait_stats() for details.
+ */
+struct am_ao_post_wait_stats {
+    /** the number of posts, which blocked the producer */
+    uint32_t nblocked;
+    /** the number of blocked posts, which timed out */
+    uint32_t ntimeouts;
+    /** the total time the producers were blocked [ms] */
+    uint32_t blocked_ms;
+    /** the longest time a producer was blocked by one post [ms] */
+    uint32_t blocked_ms_max;
+};
+
+/**
+ * Deferred events store of active object.
+ *
+ * See am_ao_defer_init(), am_ao_defer() and am_ao_recall() for details.
+ */
+struct am_ao_defer {
+    const struct am_event** events; /**< the deferred events */
+    int capacity;                   /**< the store capacity */
+    int rd;                         /**< the index of the oldest event */
+    int nbusy;                      /**< the number of deferred events */
 };
 
 /** Active object event handler */
@@ -106,6 +177,7 @@ struct am_ao {
     struct am_event_queue event_queue; /**< event queue */
     int last_event;                    /**< last processed event */
     int task_id;                       /**< task handle */
+    int shard;                         /**< scheduler thread index */
     /** AO priority */
     struct am_ao_prio prio;
     /** User AO init event */
@@ -114,6 +186,22 @@ struct am_ao {
     bool init_called;
     /** am_ao_start() call was made for the AO */
     bool running;
+    /** lock-free event queue (see am_ao_set_event_queue_mpsc()) */
+    bool mpsc;
+    /** statistics or NULL (see am_ao_set_stats()) */
+    struct am_ao_stats* stats;
+    /** event queue push time stamps (see am_ao_set_event_stamps()) */
+    uint32_t* stamps;
+    /** the number of event queue push time stamps */
+    int nstamps;
+    /** the age of the event being dispatched (see am_ao_get_event_age()) */
+    uint32_t event_age;
+    /** event queue lanes or NULL (see am_ao_set_event_queue_lanes()) */
+    struct am_event_queue_lane* lanes;
+    /** the number of event queue slots of each lane */
+    const int* nlane_events;
+    /** the number of event queue lanes */
+    int nlanes;
 };
 
 /** Active object library state configuration. */
@@ -129,6 +217,9 @@ struct am_ao_cfg {
      *
      * Do not post or publish events from this callback.
      *
+     * Cooperative port with more than one scheduler thread only calls
+     * the callback from the scheduler thread 0 (see am_ao_cfg::nthreads).
+     *
      * Please read the article called
      * "Use an MCU's low-power modes in foreground/background systems"
      * by Miro Samek for more information about the reasoning of the approach.
@@ -142,6 +233,88 @@ struct am_ao_cfg {
 
     /** Event memory allocator. */
     struct am_event_alloc* alloc;
+
+    /**
+     * The number of scheduler threads.
+     *
+     * Cooperative port of active objects:
+     * each scheduler thread owns a shard of active objects with
+     * its own set of ready active objects and runs them
+     * in the order of their priorities.
+     * An active object is always run by the same scheduler thread,
+     * which preserves the run-to-completion semantics.
+     * The thread is selected by am_ao_start() as
+     * am_ao_prio::task modulo the number of scheduler threads.
+     *
+     * The thread 0 is the one calling am_ao_run_all().
+     * The remaining threads are created by am_ao_global_init()
+     * and run till am_ao_global_deinit() call.
+     *
+     * With several scheduler threads the ready set of each shard is
+     * guarded by its own PAL mutex (see #AM_PAL_MUTEX_NUM_MAX).
+     * The event queues and the event allocator are still guarded by
+     * the critical section (am_ao_cfg::crit_enter(),
+     * am_ao_cfg::crit_exit()). The scheduler threads only enter it to
+     * pop events from event queues, which are not lock-free, and to
+     * free events. Use lock-free event queues
+     * (am_ao_set_event_queue_mpsc()) and atomic event reference counters
+     * (AM_EVENT_REF_COUNTER_ATOMIC) to avoid it on the hot path.
+     * The single scheduler thread guards its ready set with
+     * the critical section.
+     *
+     * Valid range [0, #AM_AO_THREADS_NUM_MAX]. 0 is same as 1.
+     *
+     * Thread pool port of active objects:
+     * the number of worker threads created by am_ao_global_init().
+     * Each worker has its own set of ready active objects guarded by
+     * its own PAL mutex (see #AM_PAL_MUTEX_NUM_MAX) and runs the highest
+     * priority active object of it. A worker with empty ready set
+     * steals the highest priority active object from the ready sets
+     * of other workers. A notified active object is made ready to run
+     * in the ready set of the worker, which ran it last time.
+     * An active object is never run by two workers at once.
+     * The workers run till am_ao_global_deinit() call.
+     * The event queues, which are not lock-free, and the event
+     * allocator are still guarded by the critical section
+     * (am_ao_cfg::crit_enter(), am_ao_cfg::crit_exit()).
+     * 0 means am_get_cpu_count() limited to #AM_AO_THREADS_NUM_MAX.
+     *
+     * Not used by preemptive port of active objects.
+     */
+    int nthreads;
+
+    /**
+     * The maximum number of events dispatched to the same active object
+     * per scheduling decision.
+     *
+     * Only used by cooperative port of active objects.
+     * Once the highest priority ready active object is selected,
+     * the scheduler dispatches up to this number of events to it
+     * without rescheduling. The batch ends earlier, if the active object
+     * event queue becomes empty or a higher priority active object
+     * becomes ready to run. The latter check is done after
+     * each dispatched event.
+     *
+     * Batching amortizes the scheduling overhead over several events
+     * under bursty load.
+     *
+     * 0 is same as 1.
+     */
+    int nbatch;
+
+    /**
+     * Time source of active object statistics and event ages
+     * (see am_ao_set_stats() and am_ao_set_event_stamps()).
+     *
+     * Any monotonic free running counter like CPU cycle counter.
+     * The wrap around of the counter is handled.
+     * If not set, am_time_get_ticks() of #AM_TIMEBASE_US is used,
+     * which counts microseconds with posix and libuv PALs and CPU cycles
+     * with Zephyr PAL. FreeRTOS PAL counts kernel ticks, which are
+     * usually too coarse. Set a finer clock (like CPU cycle counter)
+     * in this case.
+     */
+    uint32_t (*get_time)(void);
 };
 
 #ifdef __cplusplus
@@ -215,6 +388,39 @@ bool am_ao_publish_exclude_x(
     const struct am_event* event, const struct am_ao* ao, int margin
 );
 
+/**
+ * Publish @p event to either all subscribed active objects or none of them.
+ *
+ * Same as am_ao_publish_exclude_x() except the @p event is delivered
+ * only, if all subscribed active objects except the active object @p ao
+ * can accommodate it with @p margin free event queue slots left.
+ * Otherwise the @p event is not delivered to any of them.
+ *
+ * The check and the delivery are done in one critical section.
+ * Lock-free posting of static events to active objects in MPSC mode
+ * (see am_ao_set_event_queue_mpsc()) bypasses the critical section and so
+ * might still take the checked event queue slots meanwhile.
+ *
+ * There are limitations to what application code can do with the event after
+ * calling this function. Please consult the
+ * <a href="https://amast.readthedocs.io/event.html">Event Ownership Diagram</a>
+ * to understand the limitations.
+ *
+ * @param event   the event to publish
+ * @param ao      do not post the event to this active object even
+ *                if it is subscribed to the event. Can be NULL.
+ * @param margin  the number of free event queue slots to be available in each
+ *                subscribed active object after the event is pushed
+ *                to their event queues
+ *
+ * @retval true   the event was delivered to all subscribed active objects
+ *                except the active object @p ao
+ * @retval false  the event was not delivered
+ */
+bool am_ao_publish_all_or_none(
+    const struct am_event* event, const struct am_ao* ao, int margin
+);
+
 /**
  * Publish @p event to all subscribed active objects except the given one.
  *
@@ -364,6 +570,53 @@ bool am_ao_post_fifo_x(
  */
 void am_ao_post_fifo(struct am_ao* ao, const struct am_event* event);
 
+/**
+ * Post @p event to the back of active object's event queue with backpressure.
+ *
+ * Same as am_ao_post_fifo_x() with zero margin except, if the event
+ * queue of the active object is full, then the calling task is blocked
+ * until the active object takes an event from its event queue or
+ * @p timeout_ms expires.
+ *
+ * Tries to free the @p event synchronously, if it was not posted.
+ *
+ * Only supported by the preemptive AO port.
+ * Must not be called from interrupt service routines (ISR) and
+ * by the active object @p ao itself.
+ *
+ * Use am_ao_get_post_wait_stats() to check how often and how long
+ * the producers were blocked.
+ *
+ * There are limitations to what application code can do with the event after
+ * calling this function. Please consult the
+ * <a href="https://amast.readthedocs.io/event.html">Event Ownership Diagram</a>
+ * to understand the limitations.
+ *
+ * @param ao          the event is posted to this active object
+ * @param event       the event to post
+ * @param timeout_ms  the longest time to wait for a free event queue slot [ms]
+ *
+ * @retval true   the event was posted
+ * @retval false  the timeout expired or the active object was stopped
+ */
+bool am_ao_post_fifo_wait(
+    struct am_ao* ao, const struct am_event* event, uint32_t timeout_ms
+);
+
+/**
+ * Get blocking post statistics of active object.
+ *
+ * Only supported by the preemptive AO port.
+ *
+ * Thread safe.
+ *
+ * @param ao     the active object
+ * @param stats  the statistics snapshot is copied here
+ */
+void am_ao_get_post_wait_stats(
+    const struct am_ao* ao, struct am_ao_post_wait_stats* stats
+);
+
 /**
  * Post @p event to the front of AO event queue (eXtended version).
  *
@@ -415,6 +668,187 @@ bool am_ao_post_lifo_x(
  */
 void am_ao_post_lifo(struct am_ao* ao, const struct am_event* event);
 
+/**
+ * Post @p event to active object's event queue with event queue policy.
+ *
+ * Generalization of am_ao_post_fifo_x() and am_ao_post_lifo_x().
+ * The event queue policy fields lifo, margin, coalesce and lane are used.
+ * See am_ao_set_event_queue_lanes() for event queue lanes.
+ *
+ * If policy.coalesce is set and an event with the same ID is already in
+ * the event queue, then the queued event is replaced with @p event in place
+ * and freed. This keeps the event queue depth bounded for high rate
+ * "latest value" events, where only the newest event matters.
+ * Coalescing is not supported for lock-free event queues
+ * (see am_ao_set_event_queue_mpsc()).
+ *
+ * Tries to free the @p event synchronously, if it was not posted.
+ *
+ * There are limitations to what application code can do with the event after
+ * calling this function. Please consult the
+ * <a href="https://amast.readthedocs.io/event.html">Event Ownership Diagram</a>
+ * to understand the limitations.
+ *
+ * @param ao      the event is posted to this active object
+ * @param event   the event to post
+ * @param policy  the event queue handling policy
+ *
+ * @retval true   the event was posted or replaced the queued event
+ * @retval false  the event was not posted
+ */
+bool am_ao_post_x(
+    struct am_ao* ao,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+);
+
+/**
+ * Post several events to the back of active object's event queue.
+ *
+ * The events are placed to the event queue in one go and keep their order.
+ * This is cheaper than posting the events one by one with
+ * am_ao_post_fifo_x(), as the critical section is entered once
+ * and the active object is notified once.
+ *
+ * Guarantees availability of @p margin free slots in destination event queue
+ * after the events were delivered to the active object.
+ *
+ * The leading events, which fit the event queue, are posted.
+ * If @p all_or_none is true, then either all events are posted or
+ * none of them.
+ *
+ * Crashes with assert, if @p margin is 0 and not all events were posted.
+ *
+ * Tries to free the events synchronously, which were not posted.
+ *
+ * Thread safe.
+ *
+ * There are limitations to what application code can do with the events
+ * after calling this function. Please consult the
+ * <a href="https://amast.readthedocs.io/event.html">Event Ownership Diagram</a>
+ * to understand the limitations.
+ *
+ * @param ao           the events are posted to this active object
+ * @param events       the events to post
+ * @param nevents      the number of events in @p events
+ * @param margin       the number of free event queue slots to be available
+ *                     after the events were posted
+ * @param all_or_none  post either all events or none of them
+ *
+ * @return the number of posted events
+ */
+int am_ao_post_fifo_many(
+    struct am_ao* ao,
+    const struct am_event* events[],
+    int nevents,
+    int margin,
+    bool all_or_none
+);
+
+/**
+ * Initialize deferred events store.
+ *
+ * The store is owned by one active object. Only this active object
+ * is allowed to defer events to the store and recall events from it.
+ * An active object might own several stores.
+ *
+ * @param defer    the store to initialize
+ * @param events   the array of deferred event pointers
+ * @param nevents  the number of elements in @p events
+ */
+void am_ao_defer_init(
+    struct am_ao_defer* defer, const struct am_event* events[], int nevents
+);
+
+/**
+ * Defer the event being handled by active object.
+ *
+ * Appends @p event to the store and takes one reference of @p event.
+ * The event is not copied.
+ * Use am_ao_recall(), am_ao_recall_all() or am_ao_recall_id()
+ * to recall the deferred events to the event queue of the active object.
+ *
+ * Must only be called by the active object owning the store.
+ *
+ * @param defer  the deferred events store
+ * @param event  the event to defer
+ *
+ * @retval true   the event was deferred
+ * @retval false  the store is full, the event was not deferred
+ */
+bool am_ao_defer(struct am_ao_defer* defer, const struct am_event* event);
+
+/**
+ * Recall the oldest deferred event.
+ *
+ * Moves the oldest deferred event from the store to the front of
+ * the event queue of active object @p ao. The event is neither copied
+ * nor is its reference counter updated. The reference taken by
+ * am_ao_defer() is moved to the event queue.
+ *
+ * Must only be called by the active object @p ao owning the store.
+ *
+ * @param ao     the active object
+ * @param defer  the deferred events store
+ *
+ * @retval true   the event was recalled
+ * @retval false  the store is empty or the event queue is full
+ */
+bool am_ao_recall(struct am_ao* ao, struct am_ao_defer* defer);
+
+/**
+ * Recall all deferred events.
+ *
+ * Same as am_ao_recall() except all deferred events are moved to
+ * the front of the event queue of active object @p ao.
+ * The deferred events keep their order and are handled before
+ * the events already queued.
+ *
+ * If the event queue does not have enough free slots, then only
+ * the oldest deferred events are recalled. The rest stay in the store.
+ *
+ * @param ao     the active object
+ * @param defer  the deferred events store
+ *
+ * @return the number of recalled events
+ */
+int am_ao_recall_all(struct am_ao* ao, struct am_ao_defer* defer);
+
+/**
+ * Recall all deferred events with the given ID.
+ *
+ * Same as am_ao_recall_all() except only the events with
+ * @p id are recalled. Other deferred events stay in the store
+ * in their order.
+ *
+ * @param ao     the active object
+ * @param defer  the deferred events store
+ * @param id     the ID of events to recall
+ *
+ * @return the number of recalled events
+ */
+int am_ao_recall_id(struct am_ao* ao, struct am_ao_defer* defer, int id);
+
+/**
+ * Get the number of deferred events.
+ *
+ * @param defer  the deferred events store
+ *
+ * @return the number of deferred events
+ */
+int am_ao_defer_get_nbusy(const struct am_ao_defer* defer);
+
+/**
+ * Free all deferred events.
+ *
+ * Must only be called by the active object owning the store.
+ *
+ * @param defer  the deferred events store
+ *
+ * @return the number of freed events
+ */
+int am_ao_defer_flush(struct am_ao_defer* defer);
+
 /**
  * Active object initialization.
  *
@@ -444,6 +878,10 @@ void am_ao_init(
  * beginning from the lowest priority active objects because they tend
  * to have bigger event queues.
  *
+ * Cooperative port with more than one scheduler thread assigns
+ * the active object to the scheduler thread
+ * am_ao_prio::task % am_ao_cfg::nthreads.
+ *
  * @param ao          the active object to start
  * @param prio        priority
  * @param queue       the active object's event queue
@@ -475,6 +913,9 @@ void am_ao_start(
  * The active object is expected to release all allocated
  * resources before calling this function.
  *
+ * Posting to the active object with lock-free event queue must be
+ * over by the time of the call (see am_ao_set_event_queue_mpsc()).
+ *
  * @param ao  the active object to stop
  */
 void am_ao_stop(struct am_ao* ao);
@@ -494,6 +935,11 @@ void am_ao_global_init(
 
 /**
  * Active object library state de-initialization.
+ *
+ * Stops the scheduler threads of the cooperative port and
+ * the worker threads of the thread pool port created by
+ * am_ao_global_init() (see am_ao_cfg::nthreads).
+ * The threads are joined by am_pal_global_deinit().
  */
 void am_ao_global_deinit(void);
 
@@ -531,14 +977,21 @@ void am_ao_unsubscribe_all(const struct am_ao* ao);
 /**
  * Run all active objects.
  *
- * Blocks for preemptive AO library build and returns when all active objects
- * were stopped.
+ * Blocks for preemptive and thread pool AO library builds and returns
+ * when all active objects were stopped.
  *
  * What follows only applies to cooperative library build of AO.
  *
  * Executes initial transition of all newly started active objects.
  *
- * Non blocking and returns after dispatching zero or one event.
+ * Non blocking and returns after dispatching zero or one event to the highest
+ * priority ready active object. Can dispatch up to am_ao_cfg::nbatch
+ * events to the same active object, if configured.
+ *
+ * If more than one scheduler thread is configured with
+ * am_ao_cfg::nthreads, then the function only dispatches events
+ * to active objects run by the scheduler thread 0. Other active objects
+ * are run by dedicated scheduler threads concurrently.
  *
  * The function is expected to be called repeatedly to dispatch
  * events to active objects.
@@ -546,13 +999,155 @@ void am_ao_unsubscribe_all(const struct am_ao* ao);
  * If no events were dispatched (the function returned false),
  * then the event processor is in idle state.
  *
- * @retval true   dispatched one event
+ * @retval true   dispatched one or more events
  * @retval false  dispatched no events.
  *                Call am_ao_get_cnt() to make sure there are still
  *                running active objects available.
  */
 bool am_ao_run_all(void);
 
+/**
+ * Make active object event queue lock-free.
+ *
+ * Switches the event queue of the active object to lock-free
+ * multi-producer single-consumer mode (see am_event_queue_set_mpsc()).
+ *
+ * Then am_ao_post_fifo_x(), am_ao_post_fifo(), am_ao_post_lifo_x(),
+ * am_ao_post_lifo() and am_ao_post_fifo_many() calls to the active
+ * object do not enter the critical section for statically allocated
+ * events unless the active object event queue was empty. For other events
+ * the critical section is only entered to increment the event reference
+ * counter unless AM_EVENT_REF_COUNTER_ATOMIC is defined.
+ *
+ * Useful for active objects receiving events from many producers
+ * running in parallel.
+ *
+ * The producers post to the lock-free event queue without holding
+ * any lock. So, the application must make sure that no producer posts
+ * to the active object, while it stops itself with am_ao_stop().
+ * The post includes the notification of the active object, which
+ * follows the push of the event to the event queue.
+ *
+ * Must be called after am_ao_init() and before am_ao_start().
+ *
+ * @param ao  the active object
+ */
+void am_ao_set_event_queue_mpsc(struct am_ao* ao);
+
+/**
+ * Split active object event queue into priority lanes.
+ *
+ * The event queue of the active object is split into @p nlanes lanes
+ * (see am_event_queue_set_lanes()). The events posted with
+ * am_ao_post_x() to a higher lane (am_event_queue_policy::lane)
+ * are dispatched before the events queued in lower lanes.
+ * Other posting and publishing APIs use the lane 0.
+ *
+ * Use am_event_queue_get_lane_nfree_min() to check the lanes usage.
+ *
+ * Not supported for lock-free event queues
+ * (see am_ao_set_event_queue_mpsc()).
+ *
+ * Must be called after am_ao_init() and before am_ao_start().
+ *
+ * @param ao       the active object
+ * @param lanes    the lanes storage
+ * @param nevents  the number of event queue slots of each lane.
+ *                 The sum must be equal to the event queue size
+ *                 given to am_ao_start().
+ * @param nlanes   the number of elements in @p lanes and @p nevents
+ */
+void am_ao_set_event_queue_lanes(
+    struct am_ao* ao,
+    struct am_event_queue_lane lanes[],
+    const int nevents[],
+    int nlanes
+);
+
+/**
+ * Enable push time stamps of active object events.
+ *
+ * The time of every post to the active object is stored alongside
+ * the event in @p stamps, so the 4 bytes event header stays intact.
+ * The age of the event being dispatched is then available to
+ * the active object event handler with am_ao_get_event_age().
+ *
+ * Must be called after am_ao_init() and before am_ao_start().
+ *
+ * @param ao       the active object
+ * @param stamps   the storage of event queue push time stamps
+ * @param nstamps  the number of elements in @p stamps.
+ *                 Must be equal to the event queue size
+ *                 given to am_ao_start().
+ */
+void am_ao_set_event_stamps(struct am_ao* ao, uint32_t stamps[], int nstamps);
+
+/**
+ * Get the age of the event being dispatched to active object.
+ *
+ * The age is the time the event spent in the active object
+ * event queue from the post till the dispatch, in the units of
+ * am_ao_cfg::get_time(). Could be used to check queueing delay
+ * SLOs or to drop stale events:
+ *
+ * @code{.c}
+ * if (am_ao_get_event_age(&me->ao) > MAX_AGE) {
+ *     return;
+ * }
+ * @endcode
+ *
+ * Must only be called from the event handler of the active object.
+ * Requires push time stamps to be enabled with am_ao_set_event_stamps()
+ * or am_ao_set_stats().
+ *
+ * @param ao  the active object
+ *
+ * @return the event age
+ */
+uint32_t am_ao_get_event_age(const struct am_ao* ao);
+
+/**
+ * Enable statistics of active object.
+ *
+ * Then every event dispatched to the active object updates @p stats
+ * with the event handler run time and the time the event spent
+ * in the active object event queue.
+ * Use am_ao_get_stats() to take a snapshot of the statistics and
+ * am_ao_reset_stats() to reset them.
+ * Also enables push time stamps (see am_ao_set_event_stamps()).
+ *
+ * Must be called after am_ao_init() and before am_ao_start().
+ *
+ * @param ao       the active object
+ * @param stats    the statistics storage
+ * @param stamps   the storage of event queue push time stamps
+ * @param nstamps  the number of elements in @p stamps.
+ *                 Must be equal to the event queue size
+ *                 given to am_ao_start().
+ */
+void am_ao_set_stats(
+    struct am_ao* ao, struct am_ao_stats* stats, uint32_t stamps[], int nstamps
+);
+
+/**
+ * Take a snapshot of active object statistics.
+ *
+ * Thread safe.
+ *
+ * @param ao     the active object
+ * @param stats  the snapshot is copied here
+ */
+void am_ao_get_stats(const struct am_ao* ao, struct am_ao_stats* stats);
+
+/**
+ * Reset active object statistics.
+ *
+ * Thread safe.
+ *
+ * @param ao  the active object
+ */
+void am_ao_reset_stats(struct am_ao* ao);
+
 /**
  * Check if active object event queue is empty.
  *
@@ -0,0 +1,163 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Cooperative AO scheduler dispatch overhead benchmark.
+ *
+ * The producer AO posts bursts of events to the consumer AO,
+ * which has an empty event handler. So the measured time is dominated
+ * by the dispatch overhead of the scheduler.
+ *
+ * The maximum number of events dispatched to the same active object
+ * per scheduling decision (am_ao_cfg::nbatch) is given as
+ * the first command line argument. Defaults to 1.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_BURST AM_EVT_USER
+#define AM_EVT_DATA (AM_EVT_USER + 1)
+#define AM_EVT_DONE (AM_EVT_USER + 2)
+
+/** The number of events in one burst */
+#define BENCH_BURST 64
+/** The number of bursts */
+#define BENCH_NBURSTS 50000
+
+static const struct am_event m_burst = {.id = AM_EVT_BURST};
+static const struct am_event m_data = {.id = AM_EVT_DATA};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+static struct am_ao m_producer;
+static struct am_ao m_consumer;
+static int m_nbursts;
+
+static const struct am_event* m_queue_producer[1];
+static const struct am_event* m_queue_consumer[BENCH_BURST + 1];
+
+static void producer_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    am_ao_post_fifo((struct am_ao*)ctx, &m_burst);
+}
+
+static void producer_handler(void* ctx, const struct am_event* event) {
+    (void)ctx;
+    AM_ASSERT(AM_EVT_BURST == event->id);
+    if (BENCH_NBURSTS == m_nbursts) {
+        am_ao_post_fifo(&m_consumer, &m_done);
+        am_ao_stop(&m_producer);
+        return;
+    }
+    ++m_nbursts;
+    for (int i = 0; i < BENCH_BURST; ++i) {
+        am_ao_post_fifo(&m_consumer, &m_data);
+    }
+    /* ask for the next burst, once all data is consumed */
+    am_ao_post_fifo(&m_consumer, &m_burst);
+}
+
+static void consumer_handler(void* ctx, const struct am_event* event) {
+    (void)ctx;
+    switch (event->id) {
+    case AM_EVT_DATA:
+        break;
+    case AM_EVT_BURST:
+        am_ao_post_fifo(&m_producer, &m_burst);
+        break;
+    case AM_EVT_DONE:
+        am_ao_stop(&m_consumer);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int nbatch = (argc > 1) ? atoi(argv[1]) : 1;
+
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .on_idle = am_on_idle,
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .nbatch = nbatch
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    am_ao_init(
+        &m_consumer, /*init_handler=*/NULL, consumer_handler, &m_consumer
+    );
+    am_ao_start(
+        &m_consumer,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_LOW, .task = AM_AO_PRIO_LOW},
+        /*queue=*/m_queue_consumer,
+        /*queue_size=*/AM_COUNTOF(m_queue_consumer),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"consumer",
+        /*init_event=*/NULL
+    );
+
+    am_ao_init(&m_producer, producer_init, producer_handler, &m_producer);
+    am_ao_start(
+        &m_producer,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_HIGH, .task = AM_AO_PRIO_HIGH},
+        /*queue=*/m_queue_producer,
+        /*queue_size=*/AM_COUNTOF(m_queue_producer),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"producer",
+        /*init_event=*/NULL
+    );
+
+    uint32_t start_ms = am_time_get_ms();
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    const uint32_t elapsed_ms = am_time_get_ms() - start_ms;
+    const uint64_t nevents = (uint64_t)BENCH_NBURSTS * (BENCH_BURST + 2);
+    am_printf(
+        "nbatch=%d: %u ns/event\n",
+        nbatch,
+        (unsigned)(elapsed_ms * 1000000ULL / nevents)
+    );
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
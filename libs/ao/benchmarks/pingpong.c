@@ -0,0 +1,193 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Active object event queue ping-pong benchmark.
+ *
+ * The client AO keeps BENCH_NFLIGHT PING events in flight to the server AO,
+ * which replies with PONG events. Reports the time per event.
+ *
+ * The event queue size of both AOs is given as the first command line
+ * argument. Defaults to 8. Power of two sizes use mask arithmetic for
+ * event queue indices. The second argument enables lock-free event queues
+ * (see am_ao_set_event_queue_mpsc()), if not 0. Defaults to 0.
+ *
+ * Building with AM_EVENT_QUEUE_CACHE_LINE_SIZE set to the cache line size
+ * places the read and write indices of the event queues to different
+ * cache lines.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_START AM_EVT_USER
+#define AM_EVT_PING (AM_EVT_USER + 1)
+#define AM_EVT_PONG (AM_EVT_USER + 2)
+#define AM_EVT_STOP (AM_EVT_USER + 3)
+
+/** The maximum event queue size */
+#define BENCH_QUEUE_SIZE_MAX 64
+/** The number of PING events in flight */
+#define BENCH_NFLIGHT 4
+/** The number of PING events */
+#define BENCH_NPINGS 500000
+
+static const struct am_event m_start = {.id = AM_EVT_START};
+static const struct am_event m_ping = {.id = AM_EVT_PING};
+static const struct am_event m_pong = {.id = AM_EVT_PONG};
+static const struct am_event m_stop = {.id = AM_EVT_STOP};
+
+static struct client {
+    struct am_ao ao;
+    int nsent;
+    int nrecv;
+} m_client;
+
+static struct am_ao m_server;
+
+static const struct am_event* m_queue_client[BENCH_QUEUE_SIZE_MAX];
+static const struct am_event* m_queue_server[BENCH_QUEUE_SIZE_MAX];
+
+static void client_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct client* me = (struct client*)ctx;
+    am_ao_post_fifo(&me->ao, &m_start);
+}
+
+static void client_handler(void* ctx, const struct am_event* event) {
+    struct client* me = (struct client*)ctx;
+    switch (event->id) {
+    case AM_EVT_START:
+        for (int i = 0; i < BENCH_NFLIGHT; ++i) {
+            am_ao_post_fifo(&m_server, &m_ping);
+        }
+        me->nsent = BENCH_NFLIGHT;
+        break;
+    case AM_EVT_PONG:
+        if (++me->nrecv == BENCH_NPINGS) {
+            am_ao_post_fifo(&m_server, &m_stop);
+            am_ao_stop(&me->ao);
+            break;
+        }
+        if (me->nsent < BENCH_NPINGS) {
+            am_ao_post_fifo(&m_server, &m_ping);
+            ++me->nsent;
+        }
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+static void server_handler(void* ctx, const struct am_event* event) {
+    struct client* client = (struct client*)ctx;
+    switch (event->id) {
+    case AM_EVT_PING:
+        am_ao_post_fifo(&client->ao, &m_pong);
+        break;
+    case AM_EVT_STOP:
+        am_ao_stop(&m_server);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int queue_size = (argc > 1) ? atoi(argv[1]) : 8;
+    bool mpsc = (argc > 2) && (0 != atoi(argv[2]));
+    AM_ASSERT(queue_size > BENCH_NFLIGHT);
+    AM_ASSERT(queue_size <= BENCH_QUEUE_SIZE_MAX);
+
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .on_idle = am_on_idle,
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    am_ao_init(&m_server, /*init_handler=*/NULL, server_handler, &m_client);
+    if (mpsc) {
+        am_ao_set_event_queue_mpsc(&m_server);
+    }
+    am_ao_start(
+        &m_server,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_LOW, .task = AM_AO_PRIO_LOW},
+        /*queue=*/m_queue_server,
+        /*queue_size=*/queue_size,
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"server",
+        /*init_event=*/NULL
+    );
+
+    struct client* me = &m_client;
+    am_ao_init(&me->ao, client_init, client_handler, me);
+    if (mpsc) {
+        am_ao_set_event_queue_mpsc(&me->ao);
+    }
+    am_ao_start(
+        &me->ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_HIGH, .task = AM_AO_PRIO_HIGH},
+        /*queue=*/m_queue_client,
+        /*queue_size=*/queue_size,
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"client",
+        /*init_event=*/NULL
+    );
+
+    uint32_t start_ms = am_time_get_ms();
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    const uint32_t elapsed_ms = am_time_get_ms() - start_ms;
+    const uint64_t nevents = 2ULL * BENCH_NPINGS;
+    am_printf(
+        "%s queue_size=%d mpsc=%d: %u ns/event\n",
+        argv[0],
+        queue_size,
+        mpsc,
+        (unsigned)(elapsed_ms * 1000000ULL / nevents)
+    );
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Event publishing cost benchmark.
+ *
+ * Measures the cost of am_ao_publish() depending on the number of
+ * subscribed active objects. The subscribed active objects have empty
+ * event handlers and are run outside of the measured time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_PUB AM_EVT_USER
+#define AM_EVT_DONE (AM_EVT_USER + 1)
+#define AM_AO_EVT_PUB_MAX (AM_EVT_DONE + 1)
+
+/** The maximum number of subscribed active objects */
+#define BENCH_NSUBS_MAX 32
+/** The number of events published before the subscribers are run */
+#define BENCH_BURST 256
+/** The number of bursts per subscriber count */
+#define BENCH_NBURSTS 2000
+
+static const struct am_event m_pub = {.id = AM_EVT_PUB};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+static struct am_ao m_subs[BENCH_NSUBS_MAX];
+static const struct am_event* m_queue_subs[BENCH_NSUBS_MAX][BENCH_BURST];
+
+static void sub_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    am_ao_subscribe((struct am_ao*)ctx, AM_EVT_DONE);
+}
+
+static void sub_handler(void* ctx, const struct am_event* event) {
+    switch (event->id) {
+    case AM_EVT_PUB:
+        break;
+    case AM_EVT_DONE:
+        am_ao_stop((struct am_ao*)ctx);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    static struct am_event_subscribe_list sub[AM_AO_EVT_PUB_MAX];
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter, .crit_exit = am_crit_exit
+    };
+    am_ao_global_init(&cfg, sub, AM_COUNTOF(sub));
+
+    for (int i = 0; i < BENCH_NSUBS_MAX; ++i) {
+        am_ao_init(&m_subs[i], sub_init, sub_handler, &m_subs[i]);
+        am_ao_start(
+            &m_subs[i],
+            (struct am_ao_prio){.ao = (unsigned short)i, .task = 0},
+            /*queue=*/m_queue_subs[i],
+            /*queue_size=*/AM_COUNTOF(m_queue_subs[i]),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"sub",
+            /*init_event=*/NULL
+        );
+    }
+    am_ao_run_all();
+
+    int nsubs = 0;
+    for (int n = 1; n <= BENCH_NSUBS_MAX; n *= 2) {
+        for (; nsubs < n; ++nsubs) {
+            am_ao_subscribe(&m_subs[nsubs], AM_EVT_PUB);
+        }
+        uint32_t elapsed_ms = 0;
+        for (int i = 0; i < BENCH_NBURSTS; ++i) {
+            uint32_t start_ms = am_time_get_ms();
+            for (int j = 0; j < BENCH_BURST; ++j) {
+                am_ao_publish(&m_pub);
+            }
+            elapsed_ms += am_time_get_ms() - start_ms;
+
+            /* dispatch the published events */
+            while (am_ao_run_all()) {}
+        }
+        const uint64_t npublishes = (uint64_t)BENCH_NBURSTS * BENCH_BURST;
+        am_printf(
+            "nsubs=%d: %u ns/publish\n",
+            n,
+            (unsigned)(elapsed_ms * 1000000ULL / npublishes)
+        );
+    }
+
+    am_ao_publish(&m_done);
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Active object event throughput benchmark.
+ *
+ * Runs several pairs of active objects. In every pair the client AO
+ * keeps a fixed number of PING events in flight to the server AO,
+ * which replies with PONG events.
+ * Reports the number of events handled by all active objects per second.
+ *
+ * The same source is built for every AO port so the results can be
+ * compared directly.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_START AM_EVT_USER
+#define AM_EVT_PING (AM_EVT_USER + 1)
+#define AM_EVT_PONG (AM_EVT_USER + 2)
+#define AM_EVT_STOP (AM_EVT_USER + 3)
+
+/** The number of client/server AO pairs */
+#define BENCH_NPAIRS 4
+/** The number of PING events in flight per pair */
+#define BENCH_NFLIGHT 8
+/** The number of PING events per pair */
+#define BENCH_NPINGS 200000
+
+#ifndef BENCH_NTHREADS
+/** The number of scheduler threads (see am_ao_cfg::nthreads) */
+#define BENCH_NTHREADS 0
+#endif
+
+static const struct am_event m_start = {.id = AM_EVT_START};
+static const struct am_event m_ping = {.id = AM_EVT_PING};
+static const struct am_event m_pong = {.id = AM_EVT_PONG};
+static const struct am_event m_stop = {.id = AM_EVT_STOP};
+
+struct client {
+    struct am_ao ao;
+    struct am_ao* server;
+    int nsent;
+    int nrecv;
+};
+
+static struct client m_clients[BENCH_NPAIRS];
+static struct am_ao m_servers[BENCH_NPAIRS];
+
+static const struct am_event* m_queue_clients[BENCH_NPAIRS][BENCH_NFLIGHT + 1];
+static const struct am_event* m_queue_servers[BENCH_NPAIRS][BENCH_NFLIGHT + 1];
+
+static void client_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct client* me = (struct client*)ctx;
+    am_ao_post_fifo(&me->ao, &m_start);
+}
+
+static void client_handler(void* ctx, const struct am_event* event) {
+    struct client* me = (struct client*)ctx;
+    switch (event->id) {
+    case AM_EVT_START:
+        for (int i = 0; i < BENCH_NFLIGHT; ++i) {
+            am_ao_post_fifo(me->server, &m_ping);
+        }
+        me->nsent = BENCH_NFLIGHT;
+        break;
+    case AM_EVT_PONG:
+        if (++me->nrecv == BENCH_NPINGS) {
+            am_ao_post_fifo(me->server, &m_stop);
+            am_ao_stop(&me->ao);
+            break;
+        }
+        if (me->nsent < BENCH_NPINGS) {
+            am_ao_post_fifo(me->server, &m_ping);
+            ++me->nsent;
+        }
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+static void server_handler(void* ctx, const struct am_event* event) {
+    struct client* client = (struct client*)ctx;
+    switch (event->id) {
+    case AM_EVT_PING:
+        am_ao_post_fifo(&client->ao, &m_pong);
+        break;
+    case AM_EVT_STOP:
+        am_ao_stop(client->server);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc;
+
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .on_idle = am_on_idle,
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .nthreads = BENCH_NTHREADS
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    for (int i = 0; i < BENCH_NPAIRS; ++i) {
+        struct client* client = &m_clients[i];
+        struct am_ao* server = &m_servers[i];
+        client->server = server;
+
+        am_ao_init(server, /*init_handler=*/NULL, server_handler, client);
+        am_ao_start(
+            server,
+            (struct am_ao_prio){
+                .ao = (unsigned char)(2 * i), .task = (unsigned char)(2 * i)
+            },
+            /*queue=*/m_queue_servers[i],
+            /*queue_size=*/AM_COUNTOF(m_queue_servers[i]),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"server",
+            /*init_event=*/NULL
+        );
+
+        am_ao_init(&client->ao, client_init, client_handler, client);
+        am_ao_start(
+            &client->ao,
+            (struct am_ao_prio){
+                .ao = (unsigned char)(2 * i + 1),
+                .task = (unsigned char)(2 * i + 1)
+            },
+            /*queue=*/m_queue_clients[i],
+            /*queue_size=*/AM_COUNTOF(m_queue_clients[i]),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"client",
+            /*init_event=*/NULL
+        );
+    }
+
+    uint32_t start_ms = am_time_get_ms();
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    uint32_t elapsed_ms = am_time_get_ms() - start_ms;
+    elapsed_ms = AM_MAX(elapsed_ms, 1U);
+
+    /* every PING is answered with PONG */
+    const uint64_t nevents = 2ULL * BENCH_NPAIRS * BENCH_NPINGS;
+    am_printf(
+        "%s: %u events/s (%u ms)\n",
+        argv[0],
+        (unsigned)(nevents * 1000U / elapsed_ms),
+        (unsigned)elapsed_ms
+    );
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
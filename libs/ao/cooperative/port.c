@@ -25,6 +25,7 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "bit/bit.h"
@@ -38,43 +39,105 @@
 #include "ao/ao.h"
 #include "state.h"
 
-static struct am_bit_u64 am_ready_aos_ = {0};
-
-void am_ao_global_init_(void) {
-    memset(&am_ready_aos_, 0, sizeof(am_ready_aos_));
+/** Scheduler thread priority. */
+#define AM_AO_SHARD_TASK_PRIO (AM_TASK_NUM_MAX / 2)
+
+/** Scheduler thread and the shard of active objects it runs. */
+struct am_ao_shard {
+    /** ready to run active objects of the shard (see am_bitmap_set()) */
+    uint64_t ready_aos[AM_BITMAP_NWORDS(AM_AO_NUM_MAX)];
+    /**
+     * The mutex guarding ready_aos, if there are several shards.
+     * The only shard guards ready_aos with the critical section.
+     */
+    int mutex;
+    /** the task running the shard */
+    int task_id;
+    /** the priority of the currently running AO */
+    struct am_ao_prio running_ao_prio;
+};
+
+static struct am_ao_shard am_shards_[AM_AO_THREADS_NUM_MAX];
+static int am_nshards_ = 1;
+/** the scheduler threads are asked to stop (see am_ao_global_deinit_()) */
+static bool am_shards_stop_;
+static int am_nbatch_ = 1;
+
+static struct am_ao_shard* am_ao_get_own_shard(void) {
+    if (1 == am_nshards_) {
+        return &am_shards_[0];
+    }
+    int task_id = am_task_get_own_id();
+    for (int i = 0; i < am_nshards_; ++i) {
+        if (am_shards_[i].task_id == task_id) {
+            return &am_shards_[i];
+        }
+    }
+    AM_ASSERT(0);
+    return NULL;
 }
 
-static bool am_ao_handle(void* ctx, const struct am_event* event) {
-    AM_ASSERT(ctx);
-    AM_ASSERT(event);
+static void am_ao_handle(struct am_ao* ao, const struct am_event* event) {
+    struct am_ao_shard* shard = &am_shards_[ao->shard];
+    shard->running_ao_prio = ao->prio;
 
-    struct am_ao* ao = ctx;
-    struct am_ao_state* me = &am_ao_state_;
-    AM_ATOMIC_STORE_N(&ao->last_event, event->id);
-    me->running_ao_prio = ao->prio;
+    am_ao_dispatch(ao, event);
 
-    ao->user_event_handler(ao->ctx, event);
+    shard->running_ao_prio = AM_AO_PRIO_INVALID;
+}
 
-    me->running_ao_prio = AM_AO_PRIO_INVALID;
-    AM_ATOMIC_STORE_N(&ao->last_event, AM_EVT_EMPTY);
+/**
+ * Mark active object of shard ready to run.
+ *
+ * Called from critical section or by the scheduler thread of the shard.
+ *
+ * @param shard  the shard
+ * @param prio   the active object priority
+ */
+static void am_ao_shard_set_ready(struct am_ao_shard* shard, int prio) {
+    if (1 == am_nshards_) {
+        am_bitmap_set(shard->ready_aos, AM_AO_NUM_MAX, prio);
+        return;
+    }
+    am_mutex_lock(shard->mutex);
+    am_bitmap_set(shard->ready_aos, AM_AO_NUM_MAX, prio);
+    am_mutex_unlock(shard->mutex);
+}
 
-    return true;
+/**
+ * Mark active object of shard not ready to run.
+ *
+ * Called from critical section.
+ *
+ * @param shard  the shard
+ * @param prio   the active object priority
+ */
+static void am_ao_shard_clear_ready(struct am_ao_shard* shard, int prio) {
+    if (1 == am_nshards_) {
+        am_bitmap_clear(shard->ready_aos, AM_AO_NUM_MAX, prio);
+        return;
+    }
+    am_mutex_lock(shard->mutex);
+    am_bitmap_clear(shard->ready_aos, AM_AO_NUM_MAX, prio);
+    am_mutex_unlock(shard->mutex);
 }
 
-bool am_ao_run_all(void) {
+/**
+ * Run one active object of the only shard.
+ *
+ * @retval true   an active object was run
+ * @retval false  no active objects are ready to run
+ */
+static bool am_ao_run_single(void) {
     struct am_ao_state* me = &am_ao_state_;
+    struct am_ao_shard* shard = &am_shards_[0];
 
-    bool was_init_complete = AM_ATOMIC_EXCHANGE_N(&me->init_complete, true);
-    if (!was_init_complete) {
-        am_task_init_wait();
-    }
-
-    bool dispatched = false;
-    do {
-        me->crit_enter();
+    me->crit_enter();
 
-        if (am_bit_u64_is_empty(&am_ready_aos_)) {
-            AM_ASSERT(!dispatched);
+    struct am_ao* ao = NULL;
+    const struct am_event* event = NULL;
+    for (;;) {
+        if (am_bitmap_is_empty(shard->ready_aos, AM_AO_NUM_MAX)) {
             if (me->on_idle) {
                 /*
                  * We intentionally do not call me->crit_exit() before
@@ -84,31 +147,257 @@ bool am_ao_run_all(void) {
                 me->on_idle();
             }
             me->crit_exit();
-            break;
+            return false;
         }
 
-        int msb = am_bit_u64_msb(&am_ready_aos_);
-        struct am_ao* ao = me->aos[msb];
+        int msb = am_bitmap_msb(shard->ready_aos, AM_AO_NUM_MAX);
+        ao = me->aos[msb];
         AM_ASSERT(ao);
         AM_ASSERT(ao->prio.ao == msb);
 
-        if (am_event_queue_is_empty_unsafe(&ao->event_queue)) {
-            am_bit_u64_clear(&am_ready_aos_, ao->prio.ao);
-            me->crit_exit();
-            continue;
+        /*
+         * The pop from lock-free event queue may fail even if the queue
+         * is not empty: the push of the front event may be incomplete.
+         * The producer completing the push notifies the active object
+         * again in this case (see am_event_queue_set_mpsc()).
+         */
+        event = am_event_queue_pop_front_unsafe(&ao->event_queue);
+        if (event) {
+            break;
         }
+        am_bitmap_clear(shard->ready_aos, AM_AO_NUM_MAX, ao->prio.ao);
+    }
 
+    /*
+     * Dispatch up to am_nbatch_ events to the active object
+     * without rescheduling. Stop earlier, if higher priority
+     * active object becomes ready to run.
+     */
+    for (int n = 1;; ++n) {
         me->crit_exit();
 
-        enum am_rc rc = am_event_queue_pop_front_with_cb(
-            &ao->event_queue, am_ao_handle, ao
+        const int id = event->id;
+        am_ao_handle(ao, event);
+        /*
+         * Event was freed / corrupted ?
+         * See am_event_queue_pop_front_with_cb() for details.
+         */
+        AM_ASSERT(id == event->id); /* cppcheck-suppress knownArgument */
+
+        me->crit_enter();
+
+        if (!am_event_is_static(event)) {
+            am_event_free_unsafe(me->alloc, event);
+        }
+        if (n >= am_nbatch_) {
+            break;
+        }
+        if (!AM_ATOMIC_LOAD_N(&ao->running)) {
+            break; /* the active object stopped itself */
+        }
+        if (am_bitmap_msb(shard->ready_aos, AM_AO_NUM_MAX) != ao->prio.ao) {
+            break; /* preempted by higher priority active object */
+        }
+        event = am_event_queue_pop_front_unsafe(&ao->event_queue);
+        if (!event) {
+            break;
+        }
+    }
+
+    me->crit_exit();
+
+    return true;
+}
+
+/**
+ * Wait till active objects of shard are ready to run.
+ *
+ * @param shard  the shard
+ */
+static void am_ao_shard_idle(struct am_ao_shard* shard) {
+    if (shard != &am_shards_[0]) {
+        am_task_wait(shard->task_id);
+        return;
+    }
+    struct am_ao_state* me = &am_ao_state_;
+    if (!me->on_idle) {
+        return;
+    }
+    /*
+     * Other tasks only make active objects of the shard ready
+     * from critical section. So, the shard stays idle till
+     * me->on_idle() is called from the same critical section.
+     */
+    me->crit_enter();
+    am_mutex_lock(shard->mutex);
+    bool idle = am_bitmap_is_empty(shard->ready_aos, AM_AO_NUM_MAX);
+    am_mutex_unlock(shard->mutex);
+    if (idle) {
+        me->on_idle();
+    }
+    me->crit_exit();
+}
+
+/**
+ * Check if higher priority active object of shard is ready to run.
+ *
+ * @param shard  the shard
+ * @param prio   the priority of the running active object
+ *
+ * @retval true   higher priority active object is ready to run
+ * @retval false  no higher priority active objects are ready to run
+ */
+static bool am_ao_shard_is_preempted(struct am_ao_shard* shard, int prio) {
+    am_mutex_lock(shard->mutex);
+    bool preempted = !am_bitmap_is_empty(shard->ready_aos, AM_AO_NUM_MAX) &&
+                     (am_bitmap_msb(shard->ready_aos, AM_AO_NUM_MAX) > prio);
+    am_mutex_unlock(shard->mutex);
+    return preempted;
+}
+
+/**
+ * Run one active object of shard, if there are several shards.
+ *
+ * The ready active objects of the shard are guarded by the mutex of
+ * the shard. The critical section is only entered to pop events from
+ * event queues, which are not lock-free, and to free events.
+ *
+ * @param shard  the shard
+ *
+ * @retval true   an active object was run
+ * @retval false  no active objects are ready to run
+ */
+static bool am_ao_run_shard(struct am_ao_shard* shard) {
+    struct am_ao_state* me = &am_ao_state_;
+
+    struct am_ao* ao = NULL;
+    const struct am_event* event = NULL;
+    do {
+        am_mutex_lock(shard->mutex);
+        if (am_bitmap_is_empty(shard->ready_aos, AM_AO_NUM_MAX)) {
+            am_mutex_unlock(shard->mutex);
+            am_ao_shard_idle(shard);
+            return false;
+        }
+        int msb = am_bitmap_msb(shard->ready_aos, AM_AO_NUM_MAX);
+        /*
+         * Cleared before the event queue is popped. So, the push to
+         * the event queue emptied by the pop makes it ready again.
+         */
+        am_bitmap_clear(shard->ready_aos, AM_AO_NUM_MAX, msb);
+        am_mutex_unlock(shard->mutex);
+
+        /* only this scheduler thread stops the active object */
+        ao = me->aos[msb];
+        AM_ASSERT(ao);
+        AM_ASSERT(ao->prio.ao == msb);
+
+        /*
+         * The pop from lock-free event queue may fail even if the queue
+         * is not empty: the push of the front event may be incomplete.
+         * The producer completing the push notifies the active object
+         * again in this case (see am_event_queue_set_mpsc()).
+         */
+        event = am_event_queue_pop_front(&ao->event_queue);
+    } while (!event);
+
+    for (int n = 1;; ++n) {
+        const int id = event->id;
+        am_ao_handle(ao, event);
+        /*
+         * Event was freed / corrupted ?
+         * See am_event_queue_pop_front_with_cb() for details.
+         */
+        AM_ASSERT(id == event->id); /* cppcheck-suppress knownArgument */
+
+        am_event_free(me->alloc, event);
+
+        if (!AM_ATOMIC_LOAD_N(&ao->running)) {
+            return true; /* the active object stopped itself */
+        }
+        if (n >= am_nbatch_) {
+            break;
+        }
+        if (am_ao_shard_is_preempted(shard, ao->prio.ao)) {
+            break;
+        }
+        event = am_event_queue_pop_front(&ao->event_queue);
+        if (!event) {
+            break;
+        }
+    }
+    if (!am_event_queue_is_empty(&ao->event_queue)) {
+        am_ao_shard_set_ready(shard, ao->prio.ao);
+    }
+
+    return true;
+}
+
+static void am_ao_shard_task(void* param) {
+    AM_ASSERT(param);
+
+    struct am_ao_shard* shard = (struct am_ao_shard*)param;
+
+    /*
+     * Active objects may be started after all other active objects
+     * of the shard were stopped. So, the scheduler thread keeps running
+     * till am_ao_global_deinit() call even if there are no running
+     * active objects.
+     */
+    while (!AM_ATOMIC_LOAD_N(&am_shards_stop_)) {
+        am_ao_run_shard(shard);
+    }
+}
+
+void am_ao_global_init_(const struct am_ao_cfg* cfg) {
+    memset(am_shards_, 0, sizeof(am_shards_));
+
+    am_nshards_ = (cfg && (cfg->nthreads > 1)) ? cfg->nthreads : 1;
+    AM_ASSERT(am_nshards_ <= AM_AO_THREADS_NUM_MAX);
+    am_nbatch_ = (cfg && (cfg->nbatch > 1)) ? cfg->nbatch : 1;
+    AM_ATOMIC_STORE_N(&am_shards_stop_, false);
+
+    for (int i = 0; i < am_nshards_; ++i) {
+        am_shards_[i].running_ao_prio = AM_AO_PRIO_INVALID;
+        /* the mutexes are destroyed by am_pal_global_deinit() */
+        am_shards_[i].mutex = (am_nshards_ > 1) ? am_mutex_create() : 0;
+    }
+    am_shards_[0].task_id = am_task_get_own_id();
+
+    for (int i = 1; i < am_nshards_; ++i) {
+        am_shards_[i].task_id = am_task_create(
+            "ao_shard",
+            AM_AO_SHARD_TASK_PRIO,
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*init=*/NULL,
+            /*entry=*/am_ao_shard_task,
+            /*flags=*/AM_TASK_FLAG_WAIT_INIT,
+            /*arg=*/&am_shards_[i]
         );
-        AM_ASSERT(AM_RC_OK == rc);
+    }
+}
+
+void am_ao_global_deinit_(void) {
+    AM_ATOMIC_STORE_N(&am_shards_stop_, true);
+    /* the scheduler threads are joined by am_pal_global_deinit() */
+    for (int i = 1; i < am_nshards_; ++i) {
+        am_task_notify(am_shards_[i].task_id);
+    }
+}
 
-        dispatched = true;
-    } while (!dispatched);
+bool am_ao_run_all(void) {
+    struct am_ao_state* me = &am_ao_state_;
 
-    return dispatched;
+    bool was_init_complete = AM_ATOMIC_EXCHANGE_N(&me->init_complete, true);
+    if (!was_init_complete) {
+        am_task_init_wait();
+    }
+
+    if (1 == am_nshards_) {
+        return am_ao_run_single();
+    }
+    return am_ao_run_shard(&am_shards_[0]);
 }
 
 void am_ao_start(
@@ -132,27 +421,46 @@ void am_ao_start(
 
     struct am_ao_state* me = &am_ao_state_;
     am_event_queue_init(&ao->event_queue, queue, queue_size, me->alloc);
+    if (ao->mpsc) {
+        am_event_queue_set_mpsc(&ao->event_queue);
+    }
+    if (ao->lanes) {
+        am_event_queue_set_lanes(
+            &ao->event_queue, ao->lanes, ao->nlane_events, ao->nlanes
+        );
+    }
+    if (ao->stamps) {
+        am_event_queue_set_stamps(
+            &ao->event_queue, ao->stamps, ao->nstamps, me->get_time
+        );
+    }
 
     ao->prio = prio;
     ao->name = name;
-    ao->task_id = am_task_get_own_id();
+    ao->shard = (int)prio.task % am_nshards_;
+    ao->task_id = am_shards_[ao->shard].task_id;
 
+    /* scheduler threads of other shards may be reading me->aos[] */
+    me->crit_enter();
     AM_ASSERT(NULL == me->aos[prio.ao]);
     me->aos[prio.ao] = ao;
-    ++me->aos_cnt;
+    me->crit_exit();
+    AM_ATOMIC_FETCH_ADD(&me->aos_cnt, 1);
 
     AM_ATOMIC_STORE_N(&ao->running, true);
 
-    me->running_ao_prio = prio;
+    struct am_ao_shard* shard = am_ao_get_own_shard();
+    struct am_ao_prio running_ao_prio = shard->running_ao_prio;
+    shard->running_ao_prio = prio;
 
-    am_event_async_register_with_id(
-        am_ao_event_handler_unsafe, ao, ao->prio.ao
+    am_event_async_register_with_id_x(
+        am_ao_event_handler_unsafe, am_ao_event_check_unsafe, ao, ao->prio.ao
     );
 
     if (ao->user_init_handler) {
         ao->user_init_handler(ao->ctx, init_event);
     }
-    me->running_ao_prio = AM_AO_PRIO_INVALID;
+    shard->running_ao_prio = running_ao_prio;
 }
 
 void am_ao_stop(struct am_ao* ao) {
@@ -169,10 +477,10 @@ void am_ao_stop(struct am_ao* ao) {
 
     am_event_queue_flush_unsafe(&ao->event_queue);
     am_event_queue_deinit(&ao->event_queue);
-    am_bit_u64_clear(&am_ready_aos_, ao->prio.ao);
+    am_ao_shard_clear_ready(&am_shards_[ao->shard], ao->prio.ao);
 
     me->aos[ao->prio.ao] = NULL;
-    --me->aos_cnt;
+    AM_ATOMIC_FETCH_ADD(&me->aos_cnt, -1);
     ao->init_called = false;
 
     AM_ATOMIC_STORE_N(&ao->running, false);
@@ -180,13 +488,22 @@ void am_ao_stop(struct am_ao* ao) {
     me->crit_exit();
 
     am_event_async_unregister(ao->prio.ao);
+
+    if (0 == AM_ATOMIC_LOAD_N(&me->aos_cnt)) {
+        /* let other scheduler threads see it */
+        for (int i = 0; i < am_nshards_; ++i) {
+            if (i != ao->shard) {
+                am_task_notify(am_shards_[i].task_id);
+            }
+        }
+    }
 }
 
 void am_ao_notify_unsafe(const struct am_ao* ao) {
     if (AM_TASK_ID_NONE == ao->task_id) {
         return;
     }
-    am_bit_u64_set(&am_ready_aos_, ao->prio.ao);
+    am_ao_shard_set_ready(&am_shards_[ao->shard], ao->prio.ao);
     am_task_notify(ao->task_id);
 }
 
@@ -200,7 +517,7 @@ void am_ao_notify(const struct am_ao* ao) {
 }
 
 int am_ao_get_own_prio(void) {
-    const struct am_ao_state* me = &am_ao_state_;
-    AM_ASSERT(AM_AO_PRIO_IS_VALID(me->running_ao_prio));
-    return me->running_ao_prio.ao;
+    const struct am_ao_shard* shard = am_ao_get_own_shard();
+    AM_ASSERT(AM_AO_PRIO_IS_VALID(shard->running_ao_prio));
+    return shard->running_ao_prio.ao;
 }
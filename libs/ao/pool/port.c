@@ -0,0 +1,565 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Source: https://github.com/adel-mamin/amast
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * Active object (AO) library thread pool port.
+ *
+ * A fixed pool of worker threads runs all active objects.
+ * Every worker owns a set of ready active objects ordered by AO
+ * priorities and guarded by the mutex of the worker. A worker always
+ * runs the highest priority active object of its ready set.
+ * A worker with empty ready set steals the highest priority ready
+ * active object from the ready sets of other workers.
+ *
+ * An active object made ready to run is put to the ready set of
+ * the worker, which ran it last time. An active object is removed
+ * from the ready set while being run. So it is never run by two
+ * workers at once.
+ *
+ * The event queues, which are not lock-free, and the event allocator
+ * are still guarded by the critical section (am_ao_cfg::crit_enter(),
+ * am_ao_cfg::crit_exit()).
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bit/bit.h"
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "common/types.h"
+#include "event/event_common.h"
+#include "event/event_async.h"
+#include "event/event_queue.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+#include "state.h"
+
+/** Worker thread priority. */
+#define AM_AO_WORKER_TASK_PRIO (AM_TASK_NUM_MAX / 2)
+
+/** Active object scheduling state. */
+enum am_ao_sched {
+    AM_AO_SCHED_IDLE = 0, /**< no events to handle */
+    AM_AO_SCHED_READY,    /**< in the ready set of a worker */
+    AM_AO_SCHED_RUNNING,  /**< is run by a worker */
+    AM_AO_SCHED_NOTIFIED  /**< is run by a worker and was notified */
+};
+
+/** Worker thread of the pool. */
+struct am_ao_worker {
+    /** ready to run active objects of the worker (see am_bitmap_set()) */
+    uint64_t ready_aos[AM_BITMAP_NWORDS(AM_AO_NUM_MAX)];
+    /** the mutex guarding ready_aos */
+    int mutex;
+    /** the task running the worker */
+    int task_id;
+    /** the priority of the currently running AO */
+    struct am_ao_prio running_ao_prio;
+    /** the currently running AO stopped itself (see am_ao_stop()) */
+    bool ao_stopped;
+    /** the worker waits for ready active objects */
+    bool idle;
+};
+
+static struct am_ao_worker am_workers_[AM_AO_THREADS_NUM_MAX];
+static int am_nworkers_;
+/** the number of workers waiting for ready active objects */
+static int am_nidle_workers_;
+/** the workers are asked to stop (see am_ao_global_deinit_()) */
+static bool am_workers_stop_;
+/** the scheduling states of active objects (see enum am_ao_sched) */
+static unsigned char am_ao_sched_[AM_AO_NUM_MAX];
+
+/** The workers indexed by their tasks (see am_ao_task_index()) */
+static struct am_ao_worker* am_task_workers_[AM_TASK_NUM_MAX + 1];
+
+/** The priority of AO run by non worker task (init handlers) */
+static struct am_ao_prio am_ao_running_prio_;
+
+/**
+ * Map task ID to the index of am_task_workers_[] array.
+ *
+ * @param task_id  the task ID
+ *
+ * @return the index
+ */
+static int am_ao_task_index(int task_id) {
+    const int index = (AM_TASK_ID_MAIN == task_id) ? 0 : task_id;
+    AM_ASSERT((index >= 0) && (index < AM_COUNTOF(am_task_workers_)));
+    return index;
+}
+
+static struct am_ao_worker* am_ao_get_own_worker(void) {
+    return am_task_workers_[am_ao_task_index(am_task_get_own_id())];
+}
+
+/**
+ * Wake up idle worker.
+ *
+ * @param worker  the worker to wake up, if it is idle.
+ *                Otherwise any other idle worker is woken up.
+ */
+static void am_ao_wake(struct am_ao_worker* worker) {
+    if (0 == AM_ATOMIC_LOAD_N(&am_nidle_workers_)) {
+        return;
+    }
+    if (AM_ATOMIC_EXCHANGE_N(&worker->idle, false)) {
+        am_task_notify(worker->task_id);
+        return;
+    }
+    for (int i = 0; i < am_nworkers_; ++i) {
+        struct am_ao_worker* w = &am_workers_[i];
+        /* the load avoids cache line ping-pong of busy workers */
+        if (AM_ATOMIC_LOAD_N(&w->idle) &&
+            AM_ATOMIC_EXCHANGE_N(&w->idle, false)) {
+            am_task_notify(w->task_id);
+            return;
+        }
+    }
+}
+
+/**
+ * Put active object to the ready set of the worker, which ran it last.
+ *
+ * The active object must be in #AM_AO_SCHED_READY state.
+ *
+ * @param ao  the active object
+ */
+static void am_ao_enqueue(const struct am_ao* ao) {
+    struct am_ao_worker* worker = &am_workers_[ao->shard];
+    am_mutex_lock(worker->mutex);
+    am_bitmap_set(worker->ready_aos, AM_AO_NUM_MAX, ao->prio.ao);
+    am_mutex_unlock(worker->mutex);
+
+    am_ao_wake(worker);
+}
+
+/**
+ * Take the highest priority active object from the ready set of worker.
+ *
+ * @param worker  the worker to run the active object
+ * @param owner   the worker owning the ready set
+ *
+ * @return the active object or NULL, if the ready set is empty
+ */
+static struct am_ao* am_ao_take(
+    struct am_ao_worker* worker, struct am_ao_worker* owner
+) {
+    am_mutex_lock(owner->mutex);
+    if (am_bitmap_is_empty(owner->ready_aos, AM_AO_NUM_MAX)) {
+        am_mutex_unlock(owner->mutex);
+        return NULL;
+    }
+    int msb = am_bitmap_msb(owner->ready_aos, AM_AO_NUM_MAX);
+    am_bitmap_clear(owner->ready_aos, AM_AO_NUM_MAX, msb);
+    bool more = !am_bitmap_is_empty(owner->ready_aos, AM_AO_NUM_MAX);
+    am_mutex_unlock(owner->mutex);
+
+    struct am_ao* ao = am_ao_state_.aos[msb];
+    AM_ASSERT(ao);
+    AM_ASSERT(AM_AO_SCHED_READY == AM_ATOMIC_LOAD_N(&am_ao_sched_[msb]));
+    ao->shard = (int)(worker - am_workers_);
+    ao->task_id = worker->task_id;
+    AM_ATOMIC_STORE_N(&am_ao_sched_[msb], AM_AO_SCHED_RUNNING);
+
+    /* let another worker steal the next ready active object */
+    if (more) {
+        am_ao_wake(owner);
+    }
+    return ao;
+}
+
+/**
+ * Take active object to run from own ready set or steal it.
+ *
+ * @param worker  the worker
+ *
+ * @return the active object or NULL, if all ready sets are empty
+ */
+static struct am_ao* am_ao_dequeue(struct am_ao_worker* worker) {
+    struct am_ao* ao = am_ao_take(worker, worker);
+    const int index = (int)(worker - am_workers_);
+    for (int i = 1; !ao && (i < am_nworkers_); ++i) {
+        ao = am_ao_take(worker, &am_workers_[(index + i) % am_nworkers_]);
+    }
+    return ao;
+}
+
+/**
+ * Check if active object keeps running after handling of event.
+ *
+ * The active object keeps running, if the ready set of the worker
+ * has no higher priority active objects. Otherwise the active object
+ * is put to the ready set.
+ *
+ * @param worker  the worker running the active object
+ * @param ao      the active object with non empty event queue
+ *
+ * @retval true   the active object keeps running
+ * @retval false  the active object was put to the ready set
+ */
+static bool am_ao_keep_running(
+    struct am_ao_worker* worker, const struct am_ao* ao
+) {
+    am_mutex_lock(worker->mutex);
+    bool keep = am_bitmap_is_empty(worker->ready_aos, AM_AO_NUM_MAX) ||
+                (am_bitmap_msb(worker->ready_aos, AM_AO_NUM_MAX) < ao->prio.ao);
+    if (!keep) {
+        AM_ATOMIC_STORE_N(&am_ao_sched_[ao->prio.ao], AM_AO_SCHED_READY);
+        am_bitmap_set(worker->ready_aos, AM_AO_NUM_MAX, ao->prio.ao);
+    }
+    am_mutex_unlock(worker->mutex);
+    return keep;
+}
+
+/**
+ * Make active object idle once it has no events to handle.
+ *
+ * The active object is put to the ready set instead,
+ * if it was notified while running.
+ *
+ * @param ao  the active object run by the worker
+ */
+static void am_ao_idle(const struct am_ao* ao) {
+    unsigned char* sched = &am_ao_sched_[ao->prio.ao];
+    unsigned char state = AM_AO_SCHED_RUNNING;
+    if (AM_ATOMIC_COMPARE_EXCHANGE_N(sched, &state, AM_AO_SCHED_IDLE)) {
+        return;
+    }
+    AM_ASSERT(AM_AO_SCHED_NOTIFIED == state);
+    AM_ATOMIC_STORE_N(sched, AM_AO_SCHED_READY);
+    am_ao_enqueue(ao);
+}
+
+/**
+ * Dispatch events to active object.
+ *
+ * Must be called from critical section.
+ * Returns from critical section.
+ *
+ * @param worker  the worker running the active object
+ * @param ao      the active object taken by the worker
+ */
+static void am_ao_run(struct am_ao_worker* worker, struct am_ao* ao) {
+    struct am_ao_state* me = &am_ao_state_;
+
+    for (;;) {
+        /*
+         * The pop from lock-free event queue may fail even if the queue
+         * is not empty: the push of the front event may be incomplete.
+         * The producer completing the push notifies the active object
+         * again in this case (see am_event_queue_set_mpsc()).
+         */
+        const struct am_event* event =
+            am_event_queue_pop_front_unsafe(&ao->event_queue);
+        if (!event) {
+            am_ao_idle(ao);
+            return;
+        }
+        me->crit_exit();
+
+        worker->running_ao_prio = ao->prio;
+        const int id = event->id;
+        am_ao_dispatch(ao, event);
+        /* event was freed / corrupted ? */
+        AM_ASSERT(id == event->id);
+        worker->running_ao_prio = AM_AO_PRIO_INVALID;
+
+        me->crit_enter();
+        if (!am_event_is_static(event)) {
+            am_event_free_unsafe(me->alloc, event);
+        }
+        /*
+         * The AO might have stopped itself. It might have been
+         * started again by now, so the AO state is not checked.
+         */
+        if (worker->ao_stopped) {
+            worker->ao_stopped = false;
+            return;
+        }
+        if (am_event_queue_is_empty_unsafe(&ao->event_queue)) {
+            am_ao_idle(ao);
+            return;
+        }
+        if (!am_ao_keep_running(worker, ao)) {
+            am_ao_wake(worker);
+            return;
+        }
+    }
+}
+
+static void am_ao_worker_task(void* param) {
+    AM_ASSERT(param);
+
+    struct am_ao_worker* worker = (struct am_ao_worker*)param;
+    struct am_ao_state* me = &am_ao_state_;
+
+    /*
+     * The critical section is held between the events to save
+     * the lock operations per event. The ready sets are still
+     * accessed under the mutexes of the workers, as active objects
+     * with lock-free event queues are notified outside of it.
+     */
+    me->crit_enter();
+    /*
+     * Active objects may be started after all active objects
+     * were stopped. So, the worker keeps running till
+     * am_ao_global_deinit() call even if there are no running
+     * active objects.
+     */
+    while (!AM_ATOMIC_LOAD_N(&am_workers_stop_)) {
+        struct am_ao* ao = am_ao_dequeue(worker);
+        if (!ao) {
+            AM_ATOMIC_STORE_N(&worker->idle, true);
+            AM_ATOMIC_FETCH_ADD(&am_nidle_workers_, 1);
+            /* an active object might have become ready meanwhile */
+            ao = am_ao_dequeue(worker);
+            if (!ao) {
+                me->crit_exit();
+                am_task_wait(worker->task_id);
+                me->crit_enter();
+            }
+            AM_ATOMIC_FETCH_ADD(&am_nidle_workers_, -1);
+            AM_ATOMIC_STORE_N(&worker->idle, false);
+            if (!ao) {
+                continue;
+            }
+        }
+        am_ao_run(worker, ao);
+    }
+    me->crit_exit();
+}
+
+void am_ao_global_init_(const struct am_ao_cfg* cfg) {
+    memset(am_workers_, 0, sizeof(am_workers_));
+    memset(am_ao_sched_, 0, sizeof(am_ao_sched_));
+    memset(am_task_workers_, 0, sizeof(am_task_workers_));
+    am_ao_running_prio_ = AM_AO_PRIO_INVALID;
+    AM_ATOMIC_STORE_N(&am_workers_stop_, false);
+    AM_ATOMIC_STORE_N(&am_nidle_workers_, 0);
+
+    am_nworkers_ = (cfg && cfg->nthreads) ? cfg->nthreads : am_get_cpu_count();
+    am_nworkers_ = AM_MIN(am_nworkers_, AM_AO_THREADS_NUM_MAX);
+    AM_ASSERT(am_nworkers_ > 0);
+
+    for (int i = 0; i < am_nworkers_; ++i) {
+        struct am_ao_worker* worker = &am_workers_[i];
+        worker->running_ao_prio = AM_AO_PRIO_INVALID;
+        /* the mutexes are destroyed by am_pal_global_deinit() */
+        worker->mutex = am_mutex_create();
+        worker->task_id = am_task_create(
+            "ao_worker",
+            AM_AO_WORKER_TASK_PRIO,
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*init=*/NULL,
+            /*entry=*/am_ao_worker_task,
+            /*flags=*/AM_TASK_FLAG_WAIT_INIT,
+            /*arg=*/worker
+        );
+        am_task_workers_[am_ao_task_index(worker->task_id)] = worker;
+    }
+}
+
+void am_ao_global_deinit_(void) {
+    AM_ATOMIC_STORE_N(&am_workers_stop_, true);
+    /* the workers are joined by am_pal_global_deinit() */
+    for (int i = 0; i < am_nworkers_; ++i) {
+        am_task_notify(am_workers_[i].task_id);
+    }
+}
+
+bool am_ao_run_all(void) {
+    struct am_ao_state* me = &am_ao_state_;
+    bool was_init_complete = AM_ATOMIC_EXCHANGE_N(&me->init_complete, true);
+    if (!was_init_complete) {
+        am_task_init_wait();
+    }
+
+    /* wait all AOs to complete */
+    am_task_wait(AM_TASK_ID_MAIN);
+
+    return false;
+}
+
+void am_ao_start(
+    struct am_ao* ao,
+    struct am_ao_prio prio,
+    const struct am_event* queue[],
+    int queue_size,
+    void* stack,
+    int stack_size,
+    const char* name,
+    const struct am_event* init_event
+) {
+    (void)stack;
+    (void)stack_size;
+
+    AM_ASSERT(ao);
+    AM_ASSERT(ao->init_called);
+    AM_ASSERT(AM_AO_PRIO_IS_VALID(prio));
+    AM_ASSERT(queue);
+    AM_ASSERT(queue_size > 0);
+
+    struct am_ao_state* me = &am_ao_state_;
+    am_event_queue_init(&ao->event_queue, queue, queue_size, me->alloc);
+    if (ao->mpsc) {
+        am_event_queue_set_mpsc(&ao->event_queue);
+    }
+    if (ao->lanes) {
+        am_event_queue_set_lanes(
+            &ao->event_queue, ao->lanes, ao->nlane_events, ao->nlanes
+        );
+    }
+    if (ao->stamps) {
+        am_event_queue_set_stamps(
+            &ao->event_queue, ao->stamps, ao->nstamps, me->get_time
+        );
+    }
+
+    ao->prio = prio;
+    ao->name = name;
+    /* the worker running the AO is set every time the AO is run */
+    ao->shard = 0;
+    ao->task_id = am_workers_[0].task_id;
+
+    me->crit_enter();
+    AM_ASSERT(NULL == me->aos[prio.ao]);
+    me->aos[prio.ao] = ao;
+    AM_ATOMIC_STORE_N(&am_ao_sched_[prio.ao], AM_AO_SCHED_IDLE);
+    me->crit_exit();
+
+    AM_ATOMIC_FETCH_ADD(&me->aos_cnt, 1);
+    AM_ATOMIC_STORE_N(&ao->running, true);
+
+    am_event_async_register_with_id_x(
+        am_ao_event_handler_unsafe, am_ao_event_check_unsafe, ao, ao->prio.ao
+    );
+
+    struct am_ao_worker* worker = am_ao_get_own_worker();
+    struct am_ao_prio* running_ao_prio =
+        worker ? &worker->running_ao_prio : &am_ao_running_prio_;
+    struct am_ao_prio running_ao_prio_prev = *running_ao_prio;
+    *running_ao_prio = prio;
+
+    if (ao->user_init_handler) {
+        ao->user_init_handler(ao->ctx, init_event);
+    }
+    *running_ao_prio = running_ao_prio_prev;
+}
+
+void am_ao_stop(struct am_ao* ao) {
+    AM_ASSERT(ao);
+    AM_ASSERT(AM_AO_PRIO_IS_VALID(ao->prio));
+    struct am_ao_state* me = &am_ao_state_;
+    AM_ASSERT(AM_ATOMIC_LOAD_N(&me->aos_cnt));
+    /* check API description */
+    AM_ASSERT(am_ao_get_own_prio() == ao->prio.ao);
+
+    if (am_event_async_is_pubsub_enabled()) {
+        am_ao_unsubscribe_all(ao);
+    }
+
+    me->crit_enter();
+
+    am_event_queue_flush_unsafe(&ao->event_queue);
+    am_event_queue_deinit(&ao->event_queue);
+
+    /* the AO is only in a ready set, if it is stopped by non worker task */
+    struct am_ao_worker* owner = &am_workers_[ao->shard];
+    am_mutex_lock(owner->mutex);
+    am_bitmap_clear(owner->ready_aos, AM_AO_NUM_MAX, ao->prio.ao);
+    am_mutex_unlock(owner->mutex);
+    AM_ATOMIC_STORE_N(&am_ao_sched_[ao->prio.ao], AM_AO_SCHED_IDLE);
+
+    me->aos[ao->prio.ao] = NULL;
+    AM_ATOMIC_FETCH_ADD(&me->aos_cnt, -1);
+    ao->init_called = false;
+
+    AM_ATOMIC_STORE_N(&ao->running, false);
+
+    struct am_ao_worker* worker = am_ao_get_own_worker();
+    if (worker) {
+        worker->ao_stopped = true;
+    }
+
+    me->crit_exit();
+
+    am_event_async_unregister(ao->prio.ao);
+
+    if (0 == AM_ATOMIC_LOAD_N(&me->aos_cnt)) {
+        am_task_notify(/*task_id=*/AM_TASK_ID_MAIN);
+    }
+}
+
+void am_ao_notify_unsafe(const struct am_ao* ao) {
+    unsigned char* sched = &am_ao_sched_[ao->prio.ao];
+    unsigned char state = AM_ATOMIC_LOAD_N(sched);
+    for (;;) {
+        switch (state) {
+        case AM_AO_SCHED_IDLE:
+            if (AM_ATOMIC_COMPARE_EXCHANGE_N(
+                    sched, &state, AM_AO_SCHED_READY
+                )) {
+                am_ao_enqueue(ao);
+                return;
+            }
+            break;
+        case AM_AO_SCHED_RUNNING:
+            /*
+             * The worker running the AO puts it to the ready set
+             * once the AO has finished handling of the current event.
+             */
+            if (AM_ATOMIC_COMPARE_EXCHANGE_N(
+                    sched, &state, AM_AO_SCHED_NOTIFIED
+                )) {
+                return;
+            }
+            break;
+        default:
+            return; /* the AO is to be run already */
+        }
+    }
+}
+
+void am_ao_notify(const struct am_ao* ao) {
+    AM_ASSERT(ao);
+
+    /* the ready sets are guarded by the mutexes of the workers */
+    am_ao_notify_unsafe(ao);
+}
+
+int am_ao_get_own_prio(void) {
+    const struct am_ao_worker* worker = am_ao_get_own_worker();
+    const struct am_ao_prio* prio =
+        worker ? &worker->running_ao_prio : &am_ao_running_prio_;
+    AM_ASSERT(AM_AO_PRIO_IS_VALID(*prio));
+    return prio->ao;
+}
@@ -26,18 +26,83 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "common/compiler.h"
 #include "common/macros.h"
 #include "common/types.h"
+#include "bit/bit.h"
 #include "event/event_common.h"
 #include "event/event_async.h"
 #include "event/event_queue.h"
 #include "pal/pal.h"
+#include "trace/trace.h"
 #include "ao/ao.h"
 #include "state.h"
 
-void am_ao_global_init_(void) {}
+/* each active object is run by its own task */
+AM_ASSERT_STATIC(AM_AO_NUM_MAX <= AM_TASK_NUM_MAX);
+
+/** The number of task IDs blocked in am_ao_post_fifo_wait() (main + tasks) */
+#define AM_AO_WAITERS_NBITS (AM_TASK_NUM_MAX + 1)
+
+/** Producers blocked in am_ao_post_fifo_wait() by one active object */
+struct am_ao_waiters {
+    /** set, if the task bitmap might be not empty */
+    bool blocked;
+    /** the bitmap of blocked tasks (see am_ao_waiter_bit()) */
+    uint64_t tasks[AM_BITMAP_NWORDS(AM_AO_WAITERS_NBITS)];
+    /** blocking post statistics */
+    struct am_ao_post_wait_stats stats;
+};
+
+/** Blocked producers of all active objects indexed by AO priority */
+static struct am_ao_waiters am_ao_waiters_[AM_AO_NUM_MAX];
+
+void am_ao_global_init_(const struct am_ao_cfg* cfg) { (void)cfg; }
+
+void am_ao_global_deinit_(void) {}
+
+/**
+ * Map task ID to the bit of blocked tasks bitmap.
+ *
+ * @param task_id  the task ID
+ *
+ * @return the bit index
+ */
+static int am_ao_waiter_bit(int task_id) {
+    return (AM_TASK_ID_MAIN == task_id) ? 0 : task_id;
+}
+
+/**
+ * Wake up all producers blocked in am_ao_post_fifo_wait().
+ *
+ * @param ao  the active object the producers post to
+ */
+static void am_ao_wake_producers(const struct am_ao* ao) {
+    struct am_ao_waiters* w = &am_ao_waiters_[ao->prio.ao];
+    if (!AM_ATOMIC_LOAD_N(&w->blocked)) {
+        return;
+    }
+    struct am_ao_state* me = &am_ao_state_;
+    uint64_t tasks[AM_COUNTOF(w->tasks)];
+
+    me->crit_enter();
+
+    memcpy(tasks, w->tasks, sizeof(tasks));
+    memset(w->tasks, 0, sizeof(w->tasks));
+    AM_ATOMIC_STORE_N(&w->blocked, false);
+
+    me->crit_exit();
+
+    const int nbits = AM_AO_WAITERS_NBITS;
+    while (!am_bitmap_is_empty(tasks, nbits)) {
+        const int bit = am_bitmap_msb(tasks, nbits);
+        am_bitmap_clear(tasks, nbits, bit);
+        am_task_notify(bit ? bit : AM_TASK_ID_MAIN);
+    }
+}
 
 static bool am_ao_handle(void* ctx, const struct am_event* event) {
     AM_ASSERT(ctx);
@@ -45,9 +110,10 @@ static bool am_ao_handle(void* ctx, const struct am_event* event) {
 
     struct am_ao* ao = ctx;
 
-    AM_ATOMIC_STORE_N(&ao->last_event, event->id);
-    ao->user_event_handler(ao->ctx, event);
-    AM_ATOMIC_STORE_N(&ao->last_event, AM_EVT_EMPTY);
+    /* the event queue slot of the event is free by now */
+    am_ao_wake_producers(ao);
+
+    am_ao_dispatch(ao, event);
 
     return true;
 }
@@ -60,8 +126,8 @@ static void am_ao_task_init(void* param) {
 
     AM_ATOMIC_STORE_N(&ao->running, true);
 
-    am_event_async_register_with_id(
-        am_ao_event_handler_unsafe, ao, ao->prio.ao
+    am_event_async_register_with_id_x(
+        am_ao_event_handler_unsafe, am_ao_event_check_unsafe, ao, ao->prio.ao
     );
 
     if (ao->user_init_handler) {
@@ -78,10 +144,19 @@ static void am_ao_task(void* param) {
         while (am_event_queue_is_empty(&ao->event_queue)) {
             am_task_wait(ao->task_id);
         }
+        /*
+         * The pop from lock-free event queue may fail even if the queue
+         * is not empty: the push of the front event may be incomplete.
+         * The producer completing the push notifies the active object
+         * in this case (see am_event_queue_set_mpsc()).
+         */
         enum am_rc rc = am_event_queue_pop_front_with_cb(
             &ao->event_queue, am_ao_handle, ao
         );
-        AM_ASSERT(AM_RC_OK == rc);
+        if (AM_RC_OK != rc) {
+            AM_ASSERT(ao->mpsc);
+            am_task_wait(ao->task_id);
+        }
     }
 }
 
@@ -116,6 +191,19 @@ void am_ao_start(
 
     struct am_ao_state* me = &am_ao_state_;
     am_event_queue_init(&ao->event_queue, queue, queue_size, me->alloc);
+    if (ao->mpsc) {
+        am_event_queue_set_mpsc(&ao->event_queue);
+    }
+    if (ao->lanes) {
+        am_event_queue_set_lanes(
+            &ao->event_queue, ao->lanes, ao->nlane_events, ao->nlanes
+        );
+    }
+    if (ao->stamps) {
+        am_event_queue_set_stamps(
+            &ao->event_queue, ao->stamps, ao->nstamps, me->get_time
+        );
+    }
 
     ao->prio = prio;
     ao->name = name;
@@ -123,6 +211,7 @@ void am_ao_start(
 
     AM_ASSERT(NULL == me->aos[prio.ao]);
     me->aos[prio.ao] = ao;
+    memset(&am_ao_waiters_[prio.ao], 0, sizeof(am_ao_waiters_[prio.ao]));
 
     AM_ATOMIC_FETCH_ADD(&me->aos_cnt, 1);
 
@@ -169,11 +258,107 @@ void am_ao_stop(struct am_ao* ao) {
 
     am_event_async_unregister(ao->prio.ao);
 
+    /* the blocked producers fail posting to the stopped active object */
+    am_ao_wake_producers(ao);
+
     if (0 == AM_ATOMIC_LOAD_N(&me->aos_cnt)) {
         am_task_notify(/*task_id=*/AM_TASK_ID_MAIN);
     }
 }
 
+bool am_ao_post_fifo_wait(
+    struct am_ao* ao, const struct am_event* event, uint32_t timeout_ms
+) {
+    AM_ASSERT(ao);
+    AM_ASSERT(AM_ATOMIC_LOAD_N(&ao->init_called));
+    AM_ASSERT(event);
+    AM_ASSERT(event->id >= AM_EVT_USER);
+
+    const int task_id = am_task_get_own_id();
+    AM_ASSERT(task_id != ao->task_id); /* would block forever */
+
+    struct am_ao_state* me = &am_ao_state_;
+    struct am_ao_waiters* w = &am_ao_waiters_[ao->prio.ao];
+    const int bit = am_ao_waiter_bit(task_id);
+    const struct am_event_queue_policy policy = {.lifo = 0, .margin = 0};
+
+    bool posted = false;
+    bool blocked = false;
+    uint32_t start_ms = 0;
+    uint32_t elapsed_ms = 0;
+
+    for (;;) {
+        me->crit_enter();
+
+        if (!AM_ATOMIC_LOAD_N(&ao->running)) {
+            am_bitmap_clear(w->tasks, AM_AO_WAITERS_NBITS, bit);
+            break;
+        }
+        /*
+         * Announce the wait before checking the event queue.
+         * So, the consumer either sees the announcement after it
+         * took an event from the event queue or the producer sees
+         * the free event queue slot.
+         */
+        am_bitmap_set(w->tasks, AM_AO_WAITERS_NBITS, bit);
+        AM_ATOMIC_STORE_N(&w->blocked, true);
+
+        if (am_ao_event_check_unsafe(ao, policy)) {
+            am_bitmap_clear(w->tasks, AM_AO_WAITERS_NBITS, bit);
+            AM_TRACE(AM_TRACE_POST, ao->prio.ao, event);
+            posted = am_ao_event_handler_unsafe(ao, event, policy);
+            break;
+        }
+
+        me->crit_exit();
+
+        const uint32_t now_ms = am_time_get_ms();
+        if (!blocked) {
+            blocked = true;
+            start_ms = now_ms;
+        }
+        elapsed_ms = now_ms - start_ms;
+        if (elapsed_ms >= timeout_ms) {
+            me->crit_enter();
+            am_bitmap_clear(w->tasks, AM_AO_WAITERS_NBITS, bit);
+            break;
+        }
+        am_task_wait_timeout(task_id, timeout_ms - elapsed_ms);
+    }
+
+    /* still in critical section here */
+    if (blocked) {
+        elapsed_ms = am_time_get_ms() - start_ms;
+        struct am_ao_post_wait_stats* stats = &w->stats;
+        ++stats->nblocked;
+        stats->ntimeouts += posted ? 0U : 1U;
+        stats->blocked_ms += elapsed_ms;
+        stats->blocked_ms_max = AM_MAX(stats->blocked_ms_max, elapsed_ms);
+    }
+
+    me->crit_exit();
+
+    if (!posted) {
+        am_event_free(me->alloc, event);
+    }
+
+    return posted;
+}
+
+void am_ao_get_post_wait_stats(
+    const struct am_ao* ao, struct am_ao_post_wait_stats* stats
+) {
+    AM_ASSERT(ao);
+    AM_ASSERT(AM_AO_PRIO_IS_VALID(ao->prio));
+    AM_ASSERT(stats);
+
+    struct am_ao_state* me = &am_ao_state_;
+
+    me->crit_enter();
+    *stats = am_ao_waiters_[ao->prio.ao].stats;
+    me->crit_exit();
+}
+
 void am_ao_notify(const struct am_ao* ao) {
     AM_ASSERT(ao);
     if (AM_TASK_ID_NONE == ao->task_id) {
@@ -28,6 +28,7 @@
 #define AM_AO_STATE_H_INCLUDED
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "ao/ao.h"
 #include "bit/bit.h"
@@ -51,11 +52,8 @@ struct am_ao_state {
     /** Exit critical section. */
     void (*crit_exit)(void);
 
-    /**
-     * The priority of the currently running AO.
-     * Only valid for cooperative AO builds.
-     */
-    struct am_ao_prio running_ao_prio;
+    /** Time source of active object statistics */
+    uint32_t (*get_time)(void);
 
     /** Event memory allocator */
     struct am_event_alloc* alloc;
@@ -88,8 +86,30 @@ void am_ao_notify_unsafe(const struct am_ao* ao);
  * Internal active object library state initialization.
  * Has different implementation for cooperative and preemptive
  * active object library builds.
+ *
+ * @param cfg  active object library configuration. Can be NULL.
+ */
+void am_ao_global_init_(const struct am_ao_cfg* cfg);
+
+/**
+ * Internal active object library state de-initialization.
+ * Has different implementation for cooperative and preemptive
+ * active object library builds.
+ */
+void am_ao_global_deinit_(void);
+
+/**
+ * Dispatch event to active object.
+ *
+ * Calls the user event handler of the active object and updates
+ * the active object statistics, if enabled (see am_ao_set_stats()).
+ * Must be called by the active object event queue consumer
+ * right after the @p event was popped from the queue.
+ *
+ * @param ao     the active object
+ * @param event  the event to dispatch
  */
-void am_ao_global_init_(void);
+void am_ao_dispatch(struct am_ao* ao, const struct am_event* event);
 
 /**
  * AO event handler.
@@ -101,6 +121,14 @@ bool am_ao_event_handler_unsafe(
     void* ctx, const struct am_event* event, struct am_event_queue_policy policy
 );
 
+/**
+ * AO event handler check.
+ *
+ * Matches the type am_event_async_check_fn.
+ * Does not use critical section.
+ */
+bool am_ao_event_check_unsafe(void* ctx, struct am_event_queue_policy policy);
+
 #ifdef __cplusplus
 }
 #endif
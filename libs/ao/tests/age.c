@@ -0,0 +1,149 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ *
+ * Unit test of active object event ages.
+ * The AO posts several events to itself at once and handles them one by
+ * one. The time source is advanced by the AO event handler only, which
+ * makes the event ages known. The events older than TEST_MAX_AGE are
+ * dropped by the event handler.
+ * The thread pool port might dispatch the events, while they are
+ * still being posted. So the handler waits for all events to be posted.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_TICK AM_EVT_USER
+#define AM_EVT_DONE (AM_EVT_USER + 1)
+
+#define TEST_NEVENTS 8
+/** the event handler run time */
+#define TEST_RUN 5
+/** the events older than this are dropped */
+#define TEST_MAX_AGE 12
+
+static const struct am_event m_tick = {.id = AM_EVT_TICK};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+static uint32_t m_now;
+static bool m_posted;
+
+static uint32_t test_get_time(void) { return AM_ATOMIC_LOAD_N(&m_now); }
+
+static struct test_age {
+    struct am_ao ao;
+    int nhandled;
+    int nshed;
+    bool done;
+} m_age;
+
+static const struct am_event* m_queue[TEST_NEVENTS + 1];
+static uint32_t m_stamps[TEST_NEVENTS + 1];
+
+static void age_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct test_age* me = (struct test_age*)ctx;
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        am_ao_post_fifo(&me->ao, &m_tick);
+    }
+    am_ao_post_fifo(&me->ao, &m_done);
+    AM_ATOMIC_STORE_N(&m_posted, true);
+}
+
+static void age_handler(void* ctx, const struct am_event* event) {
+    struct test_age* me = (struct test_age*)ctx;
+    while (!AM_ATOMIC_LOAD_N(&m_posted)) {
+        am_sleep_ms(1);
+    }
+    /* the event waited for all handled events before it */
+    const uint32_t age = am_ao_get_event_age(&me->ao);
+    AM_ASSERT((uint32_t)(me->nhandled * TEST_RUN) == age);
+
+    switch (event->id) {
+    case AM_EVT_TICK:
+        if (age > TEST_MAX_AGE) {
+            ++me->nshed;
+            break;
+        }
+        AM_ATOMIC_FETCH_ADD(&m_now, TEST_RUN);
+        ++me->nhandled;
+        break;
+    case AM_EVT_DONE: {
+        const int nhandled = TEST_MAX_AGE / TEST_RUN + 1;
+        AM_ASSERT(nhandled == me->nhandled);
+        AM_ASSERT((TEST_NEVENTS - nhandled) == me->nshed);
+        me->done = true;
+        am_ao_stop(&me->ao);
+        break;
+    }
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .get_time = test_get_time
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    struct test_age* me = &m_age;
+    am_ao_init(&me->ao, age_init, age_handler, me);
+    am_ao_set_event_stamps(&me->ao, m_stamps, AM_COUNTOF(m_stamps));
+    am_ao_start(
+        &me->ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = AM_AO_PRIO_MAX},
+        /*queue=*/m_queue,
+        /*queue_size=*/AM_COUNTOF(m_queue),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"age",
+        /*init_event=*/NULL
+    );
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    AM_ASSERT(me->done);
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
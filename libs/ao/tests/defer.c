@@ -0,0 +1,201 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Unit test of active object deferred events store.
+ * The AO posts a sequence of events to itself. While busy, the AO defers
+ * the events and then recalls them by ID, all at once and one by one.
+ * The recalled events are expected to be handled in the order they were
+ * posted and the event memory pool is expected to be intact at the end.
+ * The thread pool port is not tested as it might dispatch the events,
+ * while they are still being posted.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "event/event_pool.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_A AM_EVT_USER
+#define AM_EVT_B (AM_EVT_USER + 1)
+#define AM_EVT_READY (AM_EVT_USER + 2)
+#define AM_EVT_BUSY (AM_EVT_USER + 3)
+#define AM_EVT_RECALL (AM_EVT_USER + 4)
+#define AM_EVT_DONE (AM_EVT_USER + 5)
+
+#define TEST_NDATA 6
+
+struct data {
+    struct am_event event;
+    int seq;
+};
+
+static const struct am_event m_ready = {.id = AM_EVT_READY};
+static const struct am_event m_busy = {.id = AM_EVT_BUSY};
+static const struct am_event m_recall = {.id = AM_EVT_RECALL};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+/* the pool blocks might be padded, so the pool is oversized */
+static struct data m_data_pool[2 * TEST_NDATA];
+static struct am_event_alloc m_alloc;
+
+static struct test_defer {
+    struct am_ao ao;
+    struct am_ao_defer defer;
+    bool busy;
+    int nhandled;
+    int seq[TEST_NDATA];
+    bool done;
+} m_defer;
+
+static const struct am_event* m_queue[2 * TEST_NDATA];
+static const struct am_event* m_deferred[4];
+
+static void defer_post_data(struct test_defer* me, int id, int seq) {
+    struct data* data = (struct data*)am_event_allocate(
+        &m_alloc, id, (int)sizeof(struct data)
+    );
+    data->seq = seq;
+    am_ao_post_fifo(&me->ao, &data->event);
+}
+
+static void defer_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct test_defer* me = (struct test_defer*)ctx;
+    me->busy = true;
+    defer_post_data(me, AM_EVT_A, /*seq=*/0);
+    defer_post_data(me, AM_EVT_A, /*seq=*/1);
+    defer_post_data(me, AM_EVT_B, /*seq=*/3);
+    defer_post_data(me, AM_EVT_A, /*seq=*/2);
+    am_ao_post_fifo(&me->ao, &m_ready);
+    am_ao_post_fifo(&me->ao, &m_busy);
+    defer_post_data(me, AM_EVT_A, /*seq=*/4);
+    defer_post_data(me, AM_EVT_A, /*seq=*/5);
+    am_ao_post_fifo(&me->ao, &m_recall);
+    am_ao_post_fifo(&me->ao, &m_done);
+}
+
+static void defer_handler(void* ctx, const struct am_event* event) {
+    struct test_defer* me = (struct test_defer*)ctx;
+    switch (event->id) {
+    case AM_EVT_A:
+    case AM_EVT_B: {
+        if (me->busy) {
+            bool deferred = am_ao_defer(&me->defer, event);
+            AM_ASSERT(deferred);
+            break;
+        }
+        const struct data* data = (const struct data*)event;
+        AM_ASSERT(me->nhandled < AM_COUNTOF(me->seq));
+        me->seq[me->nhandled++] = data->seq;
+        break;
+    }
+    case AM_EVT_READY:
+        me->busy = false;
+        AM_ASSERT(4 == am_ao_defer_get_nbusy(&me->defer));
+        /* B is recalled first, but is handled after all A events */
+        AM_ASSERT(1 == am_ao_recall_id(&me->ao, &me->defer, AM_EVT_B));
+        AM_ASSERT(3 == am_ao_recall_all(&me->ao, &me->defer));
+        AM_ASSERT(0 == am_ao_defer_get_nbusy(&me->defer));
+        AM_ASSERT(!am_ao_recall(&me->ao, &me->defer));
+        break;
+    case AM_EVT_BUSY:
+        me->busy = true;
+        break;
+    case AM_EVT_RECALL:
+        me->busy = false;
+        AM_ASSERT(am_ao_recall(&me->ao, &me->defer));
+        AM_ASSERT(1 == am_ao_defer_get_nbusy(&me->defer));
+        break;
+    case AM_EVT_DONE:
+        AM_ASSERT(5 == me->nhandled);
+        for (int i = 0; i < me->nhandled; ++i) {
+            AM_ASSERT(i == me->seq[i]);
+        }
+        AM_ASSERT(1 == am_ao_defer_flush(&me->defer));
+        me->done = true;
+        am_ao_stop(&me->ao);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    am_event_alloc_init(&m_alloc);
+    am_event_alloc_add_pool(
+        &m_alloc,
+        m_data_pool,
+        sizeof(m_data_pool),
+        sizeof(m_data_pool[0]),
+        AM_ALIGNOF(am_event_t)
+    );
+
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .alloc = &m_alloc
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    struct test_defer* me = &m_defer;
+    am_ao_init(&me->ao, defer_init, defer_handler, me);
+    am_ao_defer_init(&me->defer, m_deferred, AM_COUNTOF(m_deferred));
+    am_ao_start(
+        &me->ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = AM_AO_PRIO_MAX},
+        /*queue=*/m_queue,
+        /*queue_size=*/AM_COUNTOF(m_queue),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"defer",
+        /*init_event=*/NULL
+    );
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    AM_ASSERT(me->done);
+    AM_ASSERT(
+        am_event_alloc_get_nblocks(&m_alloc, 0) ==
+        am_event_alloc_get_nfree(&m_alloc, 0)
+    );
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Unit test of active object event queue lanes.
+ * The AO posts bulk events to the lane 0 and then urgent events
+ * to the lane 1 of its own event queue. The urgent events are expected
+ * to be dispatched first. The AO also checks the lanes usage.
+ * The thread pool port is not tested as it might dispatch the events,
+ * while they are still being posted.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/macros.h"
+#include "event/event_queue.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_BULK AM_EVT_USER
+#define AM_EVT_URGENT (AM_EVT_USER + 1)
+#define AM_EVT_DONE (AM_EVT_USER + 2)
+
+#define TEST_NBULK 8
+#define TEST_NURGENT 2
+
+static const struct am_event m_bulk = {.id = AM_EVT_BULK};
+static const struct am_event m_urgent = {.id = AM_EVT_URGENT};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+static struct test_lanes {
+    struct am_ao ao;
+    int nbulk;
+    int nurgent;
+    bool done;
+} m_lanes;
+
+static const struct am_event* m_queue[TEST_NBULK + 1 + TEST_NURGENT];
+static struct am_event_queue_lane m_lanes_storage[2];
+static const int m_lanes_nevents[] = {TEST_NBULK + 1, TEST_NURGENT};
+
+static void lanes_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct test_lanes* me = (struct test_lanes*)ctx;
+    for (int i = 0; i < TEST_NBULK; ++i) {
+        am_ao_post_fifo(&me->ao, &m_bulk);
+    }
+    am_ao_post_fifo(&me->ao, &m_done);
+
+    struct am_event_queue_policy policy = {.lane = 1};
+    for (int i = 0; i < TEST_NURGENT; ++i) {
+        bool posted = am_ao_post_x(&me->ao, &m_urgent, policy);
+        AM_ASSERT(posted);
+    }
+    /* the lane 1 is full */
+    policy.margin = 1;
+    bool posted = am_ao_post_x(&me->ao, &m_urgent, policy);
+    AM_ASSERT(!posted);
+}
+
+static void lanes_handler(void* ctx, const struct am_event* event) {
+    struct test_lanes* me = (struct test_lanes*)ctx;
+    const struct am_event_queue* queue = &me->ao.event_queue;
+    switch (event->id) {
+    case AM_EVT_URGENT:
+        AM_ASSERT(0 == me->nbulk);
+        ++me->nurgent;
+        break;
+    case AM_EVT_BULK:
+        AM_ASSERT(TEST_NURGENT == me->nurgent);
+        ++me->nbulk;
+        break;
+    case AM_EVT_DONE:
+        AM_ASSERT(TEST_NBULK == me->nbulk);
+        AM_ASSERT(0 == am_event_queue_get_lane_nfree_min(queue, /*lane=*/0));
+        AM_ASSERT(0 == am_event_queue_get_lane_nfree_min(queue, /*lane=*/1));
+        me->done = true;
+        am_ao_stop(&me->ao);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter, .crit_exit = am_crit_exit
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    struct test_lanes* me = &m_lanes;
+    am_ao_init(&me->ao, lanes_init, lanes_handler, me);
+    am_ao_set_event_queue_lanes(
+        &me->ao,
+        m_lanes_storage,
+        m_lanes_nevents,
+        AM_COUNTOF(m_lanes_storage)
+    );
+    am_ao_start(
+        &me->ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = AM_AO_PRIO_MAX},
+        /*queue=*/m_queue,
+        /*queue_size=*/AM_COUNTOF(m_queue),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"lanes",
+        /*init_event=*/NULL
+    );
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    AM_ASSERT(me->done);
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ *
+ * Unit test of cooperative AO port with AM_AO_NUM_MAX active objects.
+ * All AOs subscribe to the same event, which is then published once.
+ * Checks that every AO gets the event and that AOs are run
+ * in the descending order of their priorities.
+ */
+
+#include <stddef.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_PUB AM_EVT_USER
+#define AM_AO_EVT_PUB_MAX (AM_EVT_PUB + 1)
+
+#define TEST_NAOS AM_AO_NUM_MAX
+
+static const struct am_event m_pub = {.id = AM_EVT_PUB};
+
+struct many {
+    struct am_ao ao;
+    /** the order in which the AO got the published event */
+    int order;
+};
+
+static struct many m_many[TEST_NAOS];
+static const struct am_event* m_queue_many[TEST_NAOS][1];
+static int m_order;
+
+static void many_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct many* me = (struct many*)ctx;
+    am_ao_subscribe(&me->ao, AM_EVT_PUB);
+}
+
+static void many_handler(void* ctx, const struct am_event* event) {
+    struct many* me = (struct many*)ctx;
+    AM_ASSERT(AM_EVT_PUB == event->id);
+    AM_ASSERT(am_ao_get_own_prio() == me->ao.prio.ao);
+    me->order = m_order++;
+    am_ao_stop(&me->ao);
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    static struct am_event_subscribe_list sub[AM_AO_EVT_PUB_MAX];
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter, .crit_exit = am_crit_exit
+    };
+    am_ao_global_init(&cfg, sub, AM_COUNTOF(sub));
+
+    for (int i = 0; i < TEST_NAOS; ++i) {
+        struct many* m = &m_many[i];
+        m->order = -1;
+        am_ao_init(&m->ao, many_init, many_handler, m);
+        am_ao_start(
+            &m->ao,
+            (struct am_ao_prio){.ao = (unsigned short)i, .task = 0},
+            /*queue=*/m_queue_many[i],
+            /*queue_size=*/AM_COUNTOF(m_queue_many[i]),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"many",
+            /*init_event=*/NULL
+        );
+    }
+    AM_ASSERT(TEST_NAOS == am_ao_get_cnt());
+
+    am_ao_run_all();
+
+    am_ao_publish(&m_pub);
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    AM_ASSERT(TEST_NAOS == m_order);
+    for (int i = 0; i < TEST_NAOS; ++i) {
+        AM_ASSERT((TEST_NAOS - 1 - i) == m_many[i].order);
+    }
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Unit test of active object with lock-free event queue.
+ * Several producer AOs post events to the consumer AO in parallel.
+ * Every producer posts a pair of events (one to the back and one to
+ * the front of the consumer event queue) and waits for two ACK replies.
+ * The consumer event queue is sized to fit all events in flight.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "event/event_pool.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_START AM_EVT_USER
+#define AM_EVT_DATA (AM_EVT_USER + 1)
+#define AM_EVT_URGENT (AM_EVT_USER + 2)
+#define AM_EVT_ACK (AM_EVT_USER + 3)
+#define AM_EVT_DONE (AM_EVT_USER + 4)
+
+#define TEST_NTHREADS 4
+#define TEST_NPRODUCERS 6
+#define TEST_NROUNDS 2000
+
+struct data {
+    struct am_event event;
+    int producer;
+};
+
+static const struct am_event m_start = {.id = AM_EVT_START};
+static const struct am_event m_ack = {.id = AM_EVT_ACK};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+static struct data m_urgent[TEST_NPRODUCERS];
+
+/* the consumer frees DATA event after the producer gets ACK for it */
+static struct data m_data_pool[2 * TEST_NPRODUCERS];
+static struct am_event_alloc m_alloc;
+
+struct producer {
+    struct am_ao ao;
+    int index;
+    int nacks;
+    int nrounds;
+};
+
+static struct producer m_producers[TEST_NPRODUCERS];
+static const struct am_event* m_queue_producers[TEST_NPRODUCERS][2];
+
+static struct consumer {
+    struct am_ao ao;
+    int cnt[TEST_NPRODUCERS];
+    int ndone;
+} m_consumer;
+
+static const struct am_event* m_queue_consumer[2 * TEST_NPRODUCERS];
+
+static void producer_send(struct producer* me) {
+    struct data* data = (struct data*)am_event_allocate(
+        &m_alloc, AM_EVT_DATA, (int)sizeof(struct data)
+    );
+    data->producer = me->index;
+    am_ao_post_fifo(&m_consumer.ao, &data->event);
+    am_ao_post_lifo(&m_consumer.ao, &m_urgent[me->index].event);
+}
+
+static void producer_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct producer* me = (struct producer*)ctx;
+    am_ao_post_fifo(&me->ao, &m_start);
+}
+
+static void producer_handler(void* ctx, const struct am_event* event) {
+    struct producer* me = (struct producer*)ctx;
+
+    switch (event->id) {
+    case AM_EVT_START:
+        producer_send(me);
+        break;
+    case AM_EVT_ACK:
+        if (++me->nacks < 2) {
+            break;
+        }
+        me->nacks = 0;
+        if (++me->nrounds == TEST_NROUNDS) {
+            am_ao_post_fifo(&m_consumer.ao, &m_done);
+            am_ao_stop(&me->ao);
+            break;
+        }
+        producer_send(me);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+static void consumer_handler(void* ctx, const struct am_event* event) {
+    struct consumer* me = (struct consumer*)ctx;
+
+    switch (event->id) {
+    case AM_EVT_DATA:
+    case AM_EVT_URGENT: {
+        const struct data* data = (const struct data*)event;
+        AM_ASSERT(data->producer >= 0);
+        AM_ASSERT(data->producer < TEST_NPRODUCERS);
+        ++me->cnt[data->producer];
+        am_ao_post_fifo(&m_producers[data->producer].ao, &m_ack);
+        break;
+    }
+    case AM_EVT_DONE:
+        /*
+         * All DATA events were handled and freed by now.
+         * So the AO stop does not race with the DATA events freeing.
+         */
+        if (++me->ndone == TEST_NPRODUCERS) {
+            am_ao_stop(&me->ao);
+        }
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    am_event_alloc_init(&m_alloc);
+    am_event_alloc_add_pool(
+        &m_alloc,
+        m_data_pool,
+        sizeof(m_data_pool),
+        sizeof(m_data_pool[0]),
+        AM_ALIGNOF(am_event_t)
+    );
+
+    struct am_ao_cfg cfg = {
+        .on_idle = am_on_idle,
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .alloc = &m_alloc,
+        .nthreads = TEST_NTHREADS
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    struct consumer* c = &m_consumer;
+    am_ao_init(&c->ao, /*init_handler=*/NULL, consumer_handler, c);
+    am_ao_set_event_queue_mpsc(&c->ao);
+    am_ao_start(
+        &c->ao,
+        (struct am_ao_prio){.ao = TEST_NPRODUCERS, .task = TEST_NPRODUCERS},
+        /*queue=*/m_queue_consumer,
+        /*queue_size=*/AM_COUNTOF(m_queue_consumer),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"consumer",
+        /*init_event=*/NULL
+    );
+
+    for (int i = 0; i < TEST_NPRODUCERS; ++i) {
+        m_urgent[i].event.id = AM_EVT_URGENT;
+        m_urgent[i].producer = i;
+
+        struct producer* p = &m_producers[i];
+        p->index = i;
+        am_ao_init(&p->ao, producer_init, producer_handler, p);
+        am_ao_start(
+            &p->ao,
+            (struct am_ao_prio){
+                .ao = (unsigned char)i, .task = (unsigned char)i
+            },
+            /*queue=*/m_queue_producers[i],
+            /*queue_size=*/AM_COUNTOF(m_queue_producers[i]),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"producer",
+            /*init_event=*/NULL
+        );
+    }
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    for (int i = 0; i < TEST_NPRODUCERS; ++i) {
+        AM_ASSERT((2 * TEST_NROUNDS) == c->cnt[i]);
+        AM_ASSERT(TEST_NROUNDS == m_producers[i].nrounds);
+    }
+    AM_ASSERT(
+        am_event_alloc_get_nblocks(&m_alloc, 0) ==
+        am_event_alloc_get_nfree(&m_alloc, 0)
+    );
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Stress test of active object with lock-free event queue.
+ * Several producer tasks post events to the consumer AO as fast as
+ * they can, alternating posts to the back and to the front of
+ * the consumer event queue. The producers are plain tasks, which
+ * run in parallel with the consumer on multi-core hosts.
+ *
+ * The front posts race with the consumer pops. So the consumer
+ * regularly finds the front event queue slot reserved, but not
+ * filled yet, and must wait for the producer notification.
+ *
+ * The consumer stops itself only after all producers returned from
+ * their last posts (see am_ao_set_event_queue_mpsc()).
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_DATA AM_EVT_USER
+#define AM_EVT_CHECK (AM_EVT_USER + 1)
+
+#define TEST_NPRODUCERS 4
+#define TEST_NEVENTS 20000
+
+struct data {
+    struct am_event event;
+    int producer;
+};
+
+static struct data m_data[TEST_NPRODUCERS];
+static const struct am_event m_check = {.id = AM_EVT_CHECK};
+
+/** the number of producers, which returned from their last posts */
+static int m_nfinished;
+
+static struct consumer {
+    struct am_ao ao;
+    int cnt[TEST_NPRODUCERS];
+    int total;
+} m_consumer;
+
+static const struct am_event* m_queue_consumer[8];
+
+static void producer_task(void* param) {
+    const struct data* data = (const struct data*)param;
+
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        bool posted = false;
+        do {
+            if (i & 1) {
+                posted = am_ao_post_lifo_x(
+                    &m_consumer.ao, &data->event, /*margin=*/1
+                );
+            } else {
+                posted = am_ao_post_fifo_x(
+                    &m_consumer.ao, &data->event, /*margin=*/1
+                );
+            }
+        } while (!posted);
+    }
+    AM_ATOMIC_FETCH_ADD(&m_nfinished, 1);
+}
+
+static void consumer_check(struct consumer* me) {
+    if (me->total < (TEST_NPRODUCERS * TEST_NEVENTS)) {
+        return;
+    }
+    if (AM_ATOMIC_LOAD_N(&m_nfinished) == TEST_NPRODUCERS) {
+        am_ao_stop(&me->ao);
+        return;
+    }
+    /* wait for the producers to return from their last posts */
+    am_ao_post_fifo(&me->ao, &m_check);
+}
+
+static void consumer_handler(void* ctx, const struct am_event* event) {
+    struct consumer* me = (struct consumer*)ctx;
+
+    switch (event->id) {
+    case AM_EVT_DATA: {
+        const struct data* data = (const struct data*)event;
+        AM_ASSERT(data->producer >= 0);
+        AM_ASSERT(data->producer < TEST_NPRODUCERS);
+        ++me->cnt[data->producer];
+        ++me->total;
+        consumer_check(me);
+        break;
+    }
+    case AM_EVT_CHECK:
+        consumer_check(me);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .on_idle = am_on_idle,
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    struct consumer* c = &m_consumer;
+    am_ao_init(&c->ao, /*init_handler=*/NULL, consumer_handler, c);
+    am_ao_set_event_queue_mpsc(&c->ao);
+    am_ao_start(
+        &c->ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = AM_AO_PRIO_MAX},
+        /*queue=*/m_queue_consumer,
+        /*queue_size=*/AM_COUNTOF(m_queue_consumer),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"consumer",
+        /*init_event=*/NULL
+    );
+
+    for (int i = 0; i < TEST_NPRODUCERS; ++i) {
+        m_data[i].event.id = AM_EVT_DATA;
+        m_data[i].producer = i;
+        am_task_create(
+            "producer",
+            AM_AO_PRIO_MIN,
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*init=*/NULL,
+            /*entry=*/producer_task,
+            /*flags=*/AM_TASK_FLAG_WAIT_INIT,
+            /*arg=*/&m_data[i]
+        );
+    }
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    for (int i = 0; i < TEST_NPRODUCERS; ++i) {
+        AM_ASSERT(TEST_NEVENTS == c->cnt[i]);
+    }
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ *
+ * Unit test of active object bulk event posting.
+ * Two AOs, one with regular and one with lock-free event queue,
+ * post batches of events to themselves. The posted events are expected
+ * to be handled in the order they were posted, the events, which did not
+ * fit the event queues, are expected to be freed and the event memory
+ * pool is expected to be intact at the end.
+ * The thread pool port is not tested as it might dispatch the events,
+ * while they are still being posted.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "event/event_pool.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_DATA AM_EVT_USER
+#define AM_EVT_DONE (AM_EVT_USER + 1)
+
+#define TEST_QUEUE_SIZE 8
+#define TEST_BATCH_SIZE 4
+
+struct data {
+    struct am_event event;
+    int seq;
+};
+
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+/* the pool blocks might be padded, so the pool is oversized */
+static struct data m_data_pool[4 * TEST_QUEUE_SIZE];
+static struct am_event_alloc m_alloc;
+
+struct test_post_many {
+    struct am_ao ao;
+    int nhandled;
+    bool done;
+    const struct am_event* queue[TEST_QUEUE_SIZE];
+};
+
+static struct test_post_many m_post_many[2];
+
+static int post_many_batch(
+    struct test_post_many* me, int seq, int margin, bool all_or_none
+) {
+    const struct am_event* events[TEST_BATCH_SIZE];
+    for (int i = 0; i < AM_COUNTOF(events); ++i) {
+        struct data* data = (struct data*)am_event_allocate(
+            &m_alloc, AM_EVT_DATA, (int)sizeof(struct data)
+        );
+        data->seq = seq + i;
+        events[i] = &data->event;
+    }
+    return am_ao_post_fifo_many(
+        &me->ao, events, AM_COUNTOF(events), margin, all_or_none
+    );
+}
+
+static void post_many_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct test_post_many* me = (struct test_post_many*)ctx;
+
+    int n = post_many_batch(me, /*seq=*/0, /*margin=*/0, /*all_or_none=*/true);
+    AM_ASSERT(TEST_BATCH_SIZE == n);
+
+    /* four free slots left: only two events fit with the margin of two */
+    n = post_many_batch(me, /*seq=*/4, /*margin=*/2, /*all_or_none=*/true);
+    AM_ASSERT(0 == n);
+    n = post_many_batch(me, /*seq=*/4, /*margin=*/2, /*all_or_none=*/false);
+    AM_ASSERT(2 == n);
+
+    am_ao_post_fifo(&me->ao, &m_done);
+}
+
+static void post_many_handler(void* ctx, const struct am_event* event) {
+    struct test_post_many* me = (struct test_post_many*)ctx;
+    switch (event->id) {
+    case AM_EVT_DATA: {
+        const struct data* data = (const struct data*)event;
+        AM_ASSERT(me->nhandled == data->seq);
+        ++me->nhandled;
+        break;
+    }
+    case AM_EVT_DONE:
+        AM_ASSERT(TEST_BATCH_SIZE + 2 == me->nhandled);
+        me->done = true;
+        am_ao_stop(&me->ao);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    am_event_alloc_init(&m_alloc);
+    am_event_alloc_add_pool(
+        &m_alloc,
+        m_data_pool,
+        sizeof(m_data_pool),
+        sizeof(m_data_pool[0]),
+        AM_ALIGNOF(am_event_t)
+    );
+
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .alloc = &m_alloc
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    for (int i = 0; i < AM_COUNTOF(m_post_many); ++i) {
+        struct test_post_many* me = &m_post_many[i];
+        am_ao_init(&me->ao, post_many_init, post_many_handler, me);
+        if (i) {
+            am_ao_set_event_queue_mpsc(&me->ao);
+        }
+        am_ao_start(
+            &me->ao,
+            (struct am_ao_prio){
+                .ao = (unsigned char)i, .task = (unsigned char)i
+            },
+            /*queue=*/me->queue,
+            /*queue_size=*/AM_COUNTOF(me->queue),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"post_many",
+            /*init_event=*/NULL
+        );
+    }
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    for (int i = 0; i < AM_COUNTOF(m_post_many); ++i) {
+        AM_ASSERT(m_post_many[i].done);
+    }
+    AM_ASSERT(
+        am_event_alloc_get_nblocks(&m_alloc, 0) ==
+        am_event_alloc_get_nfree(&m_alloc, 0)
+    );
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
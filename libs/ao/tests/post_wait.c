@@ -0,0 +1,160 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Blocking post test.
+ *
+ * The producer task posts events to the consumer AO with small event queue
+ * faster than the consumer AO handles them. So the producer is blocked
+ * by am_ao_post_fifo_wait() till the consumer AO frees event queue slots.
+ * Then the consumer AO is held busy to check the blocking post timeout.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_DATA AM_EVT_USER
+#define AM_EVT_HOLD (AM_EVT_USER + 1)
+#define AM_EVT_DONE (AM_EVT_USER + 2)
+
+#define TEST_NEVENTS 32
+#define TEST_TIMEOUT_MS 20
+
+static const struct am_event m_data = {.id = AM_EVT_DATA};
+static const struct am_event m_hold = {.id = AM_EVT_HOLD};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+static struct am_ao m_consumer;
+static const struct am_event* m_queue_consumer[2];
+static int m_ndata;
+static bool m_holding;
+
+static void consumer_handler(void* ctx, const struct am_event* event) {
+    (void)ctx;
+    switch (event->id) {
+    case AM_EVT_DATA:
+        ++m_ndata;
+        am_sleep_ms(1);
+        break;
+    case AM_EVT_HOLD:
+        while (AM_ATOMIC_LOAD_N(&m_holding)) {
+            am_sleep_ms(1);
+        }
+        break;
+    case AM_EVT_DONE:
+        AM_ASSERT((TEST_NEVENTS + 2) == m_ndata);
+        am_ao_stop(&m_consumer);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+static void producer_task(void* param) {
+    (void)param;
+
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        bool posted = am_ao_post_fifo_wait(
+            &m_consumer, &m_data, /*timeout_ms=*/1000
+        );
+        AM_ASSERT(posted);
+    }
+    struct am_ao_post_wait_stats stats;
+    am_ao_get_post_wait_stats(&m_consumer, &stats);
+    AM_ASSERT(stats.nblocked > 0);
+    AM_ASSERT(0 == stats.ntimeouts);
+    AM_ASSERT(stats.blocked_ms_max <= stats.blocked_ms);
+
+    /* the consumer AO does not free event queue slots while holding */
+    AM_ATOMIC_STORE_N(&m_holding, true);
+    AM_ASSERT(am_ao_post_fifo_wait(&m_consumer, &m_hold, /*timeout_ms=*/1000));
+    AM_ASSERT(am_ao_post_fifo_wait(&m_consumer, &m_data, /*timeout_ms=*/1000));
+    AM_ASSERT(am_ao_post_fifo_wait(&m_consumer, &m_data, /*timeout_ms=*/1000));
+    AM_ASSERT(!am_ao_post_fifo_wait(
+        &m_consumer, &m_data, /*timeout_ms=*/TEST_TIMEOUT_MS
+    ));
+
+    struct am_ao_post_wait_stats stats_timeout;
+    am_ao_get_post_wait_stats(&m_consumer, &stats_timeout);
+    AM_ASSERT(1 == stats_timeout.ntimeouts);
+    AM_ASSERT(stats_timeout.nblocked > stats.nblocked);
+    AM_ASSERT(stats_timeout.blocked_ms_max >= TEST_TIMEOUT_MS);
+
+    AM_ATOMIC_STORE_N(&m_holding, false);
+    AM_ASSERT(am_ao_post_fifo_wait(&m_consumer, &m_done, /*timeout_ms=*/1000));
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter, .crit_exit = am_crit_exit
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    am_ao_init(
+        &m_consumer, /*init_handler=*/NULL, consumer_handler, &m_consumer
+    );
+    am_ao_start(
+        &m_consumer,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = AM_AO_PRIO_MAX},
+        /*queue=*/m_queue_consumer,
+        /*queue_size=*/AM_COUNTOF(m_queue_consumer),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"consumer",
+        /*init_event=*/NULL
+    );
+
+    am_task_create(
+        "producer",
+        /*prio=*/AM_AO_PRIO_MIN,
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*init=*/NULL,
+        /*entry=*/producer_task,
+        /*flags=*/AM_TASK_FLAG_DETACH | AM_TASK_FLAG_WAIT_INIT,
+        /*arg=*/NULL
+    );
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
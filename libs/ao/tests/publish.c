@@ -143,6 +143,13 @@ static void test_publish(void) {
 
     AM_ASSERT('\0' == m_publish.log_buf[0]);
 
+    /* the event queue has one slot only */
+    AM_ASSERT(am_ao_publish_all_or_none(&event, /*ao=*/NULL, /*margin=*/0));
+    AM_ASSERT(!am_ao_publish_all_or_none(&event, /*ao=*/NULL, /*margin=*/0));
+    am_ao_run_all();
+
+    AM_ASSERT(0 == strcmp(m_publish.log_buf, "s-PUB;"));
+
     am_ao_global_deinit();
 
     am_pal_global_deinit();
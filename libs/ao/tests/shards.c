@@ -0,0 +1,216 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Unit test of cooperative AO port with several scheduler threads.
+ * The hub AO sends PING events to worker AOs distributed over
+ * all scheduler threads and waits for PONG replies.
+ * Checks that every AO is always run by the same scheduler thread
+ * and is never run concurrently with itself.
+ * The AOs are then started again to check that the scheduler threads
+ * outlive the moment, when all AOs were stopped.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_START AM_EVT_USER
+#define AM_EVT_PING (AM_EVT_USER + 1)
+#define AM_EVT_PONG (AM_EVT_USER + 2)
+#define AM_EVT_SHUTDOWN (AM_EVT_USER + 3)
+
+#define TEST_NTHREADS 4
+#define TEST_NWORKERS 8
+#define TEST_NROUNDS 100
+
+static const struct am_event m_start = {.id = AM_EVT_START};
+static const struct am_event m_ping = {.id = AM_EVT_PING};
+static const struct am_event m_pong = {.id = AM_EVT_PONG};
+static const struct am_event m_shutdown = {.id = AM_EVT_SHUTDOWN};
+
+struct worker {
+    struct am_ao ao;
+    int task_id;
+    int cnt;
+    bool busy;
+};
+
+static struct worker m_workers[TEST_NWORKERS];
+static const struct am_event* m_queue_workers[TEST_NWORKERS][2];
+
+static struct hub {
+    struct am_ao ao;
+    int npongs;
+    int nrounds;
+} m_hub;
+
+static const struct am_event* m_queue_hub[TEST_NWORKERS];
+
+static void worker_handler(void* ctx, const struct am_event* event) {
+    struct worker* me = (struct worker*)ctx;
+
+    bool was_busy = AM_ATOMIC_EXCHANGE_N(&me->busy, true);
+    AM_ASSERT(!was_busy);
+    AM_ASSERT(am_ao_get_own_prio() == me->ao.prio.ao);
+
+    int task_id = am_task_get_own_id();
+    if (AM_TASK_ID_NONE == me->task_id) {
+        me->task_id = task_id;
+    }
+    AM_ASSERT(me->task_id == task_id);
+
+    switch (event->id) {
+    case AM_EVT_PING:
+        ++me->cnt;
+        am_ao_post_fifo(&m_hub.ao, &m_pong);
+        break;
+    case AM_EVT_SHUTDOWN:
+        am_ao_stop(&me->ao);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+
+    AM_ATOMIC_STORE_N(&me->busy, false);
+}
+
+static void hub_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct hub* me = (struct hub*)ctx;
+    am_ao_post_fifo(&me->ao, &m_start);
+}
+
+static void hub_handler(void* ctx, const struct am_event* event) {
+    struct hub* me = (struct hub*)ctx;
+
+    AM_ASSERT(am_ao_get_own_prio() == AM_AO_PRIO_MAX);
+
+    switch (event->id) {
+    case AM_EVT_PONG:
+        if (++me->npongs < TEST_NWORKERS) {
+            return;
+        }
+        me->npongs = 0;
+        if (++me->nrounds == TEST_NROUNDS) {
+            for (int i = 0; i < TEST_NWORKERS; ++i) {
+                am_ao_post_fifo(&m_workers[i].ao, &m_shutdown);
+            }
+            am_ao_stop(&me->ao);
+            return;
+        }
+        break;
+    case AM_EVT_START:
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+    for (int i = 0; i < TEST_NWORKERS; ++i) {
+        am_ao_post_fifo(&m_workers[i].ao, &m_ping);
+    }
+}
+
+static void test_run(void) {
+    m_hub.npongs = 0;
+    m_hub.nrounds = 0;
+
+    for (int i = 0; i < TEST_NWORKERS; ++i) {
+        struct worker* w = &m_workers[i];
+        w->cnt = 0;
+        am_ao_init(&w->ao, /*init_handler=*/NULL, worker_handler, w);
+        am_ao_start(
+            &w->ao,
+            (struct am_ao_prio){
+                .ao = (unsigned char)i, .task = (unsigned char)i
+            },
+            /*queue=*/m_queue_workers[i],
+            /*queue_size=*/AM_COUNTOF(m_queue_workers[i]),
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*name=*/"worker",
+            /*init_event=*/NULL
+        );
+    }
+
+    am_ao_init(&m_hub.ao, hub_init, hub_handler, &m_hub);
+    am_ao_start(
+        &m_hub.ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = 0},
+        /*queue=*/m_queue_hub,
+        /*queue_size=*/AM_COUNTOF(m_queue_hub),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"hub",
+        /*init_event=*/NULL
+    );
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    for (int i = 0; i < TEST_NWORKERS; ++i) {
+        const struct worker* w = &m_workers[i];
+        AM_ASSERT(TEST_NROUNDS == w->cnt);
+        /* workers sharing scheduler thread are run by the same task */
+        const struct worker* peer = &m_workers[i % TEST_NTHREADS];
+        AM_ASSERT(w->task_id == peer->task_id);
+        /* workers of different scheduler threads are run by different tasks */
+        for (int j = 0; j < i % TEST_NTHREADS; ++j) {
+            AM_ASSERT(w->task_id != m_workers[j].task_id);
+        }
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .on_idle = am_on_idle,
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .nthreads = TEST_NTHREADS
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    test_run();
+    /*
+     * All AOs are stopped now. The workers record their tasks
+     * during the first run, so the second run checks that the AOs
+     * are run by the same scheduler threads again.
+     */
+    test_run();
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ *
+ * Unit test of active object statistics.
+ * The AO posts several events to itself at once, handles them one by one
+ * and then checks its own statistics. The time source is advanced
+ * by the AO event handler only, which makes the handler run times and
+ * event queueing delays known.
+ * The thread pool port might dispatch the events, while they are
+ * still being posted. So the handler waits for all events to be posted.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_TICK AM_EVT_USER
+#define AM_EVT_DONE (AM_EVT_USER + 1)
+
+#define TEST_NEVENTS 8
+/** the event handler run time (log2 bucket 3) */
+#define TEST_RUN 5
+
+static const struct am_event m_tick = {.id = AM_EVT_TICK};
+static const struct am_event m_done = {.id = AM_EVT_DONE};
+
+static uint32_t m_now;
+static bool m_posted;
+
+static uint32_t test_get_time(void) { return AM_ATOMIC_LOAD_N(&m_now); }
+
+static struct test_stats {
+    struct am_ao ao;
+    struct am_ao_stats stats;
+    int cnt;
+    bool done;
+} m_stats;
+
+static const struct am_event* m_queue[TEST_NEVENTS + 1];
+static uint32_t m_stamps[TEST_NEVENTS + 1];
+
+static void stats_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct test_stats* me = (struct test_stats*)ctx;
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        am_ao_post_fifo(&me->ao, &m_tick);
+    }
+    am_ao_post_fifo(&me->ao, &m_done);
+    AM_ATOMIC_STORE_N(&m_posted, true);
+}
+
+static void stats_check(struct test_stats* me) {
+    struct am_ao_stats s;
+    am_ao_get_stats(&me->ao, &s);
+
+    AM_ASSERT(TEST_NEVENTS == s.nevents);
+    AM_ASSERT(TEST_NEVENTS == s.run[3]);
+    AM_ASSERT(TEST_RUN == s.run_max);
+
+    /* the event i waited for i * TEST_RUN */
+    AM_ASSERT((TEST_NEVENTS - 1) * TEST_RUN == s.wait_max);
+    static const uint32_t wait[] = {1, 0, 0, 1, 2, 3, 1};
+    for (int i = 0; i < AM_COUNTOF(wait); ++i) {
+        AM_ASSERT(wait[i] == s.wait[i]);
+    }
+
+    am_ao_reset_stats(&me->ao);
+    am_ao_get_stats(&me->ao, &s);
+    AM_ASSERT(0 == s.nevents);
+    AM_ASSERT(0 == s.run[3]);
+    AM_ASSERT(0 == s.wait_max);
+}
+
+static void stats_handler(void* ctx, const struct am_event* event) {
+    struct test_stats* me = (struct test_stats*)ctx;
+    while (!AM_ATOMIC_LOAD_N(&m_posted)) {
+        am_sleep_ms(1);
+    }
+    switch (event->id) {
+    case AM_EVT_TICK:
+        AM_ATOMIC_FETCH_ADD(&m_now, TEST_RUN);
+        ++me->cnt;
+        break;
+    case AM_EVT_DONE:
+        /* the statistics of all TICK events are complete by now */
+        AM_ASSERT(TEST_NEVENTS == me->cnt);
+        stats_check(me);
+        me->done = true;
+        am_ao_stop(&me->ao);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter,
+        .crit_exit = am_crit_exit,
+        .get_time = test_get_time
+    };
+    am_ao_global_init(&cfg, /*sub=*/NULL, /*nsub=*/0);
+
+    struct test_stats* me = &m_stats;
+    am_ao_init(&me->ao, stats_init, stats_handler, me);
+    am_ao_set_stats(&me->ao, &me->stats, m_stamps, AM_COUNTOF(m_stamps));
+    am_ao_start(
+        &me->ao,
+        (struct am_ao_prio){.ao = AM_AO_PRIO_MAX, .task = AM_AO_PRIO_MAX},
+        /*queue=*/m_queue,
+        /*queue_size=*/AM_COUNTOF(m_queue),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"stats",
+        /*init_event=*/NULL
+    );
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+
+    AM_ASSERT(me->done);
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
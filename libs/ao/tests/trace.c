@@ -0,0 +1,197 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Unit test of binary event trace of active objects.
+ * The trace drain task drains trace records to a file, while
+ * the active object handles posted and published events.
+ * The trace file is then read back and checked.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "common/alignment.h"
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "event/event_pool.h"
+#include "trace/trace.h"
+#include "trace/trace_drain.h"
+#include "pal/pal.h"
+#include "ao/ao.h"
+
+#define AM_EVT_DATA AM_EVT_USER
+#define AM_EVT_PUB (AM_EVT_USER + 1)
+#define AM_AO_EVT_PUB_MAX (AM_EVT_PUB + 1)
+
+#define TEST_NEVENTS 16
+#define TEST_PRIO 3
+
+static const struct am_event m_pub = {.id = AM_EVT_PUB};
+
+static struct am_trace_slot m_slots[128];
+static uint32_t m_now;
+
+static uint32_t test_get_time(void) {
+    return (uint32_t)AM_ATOMIC_FETCH_ADD(&m_now, 1U);
+}
+
+static struct test_trace {
+    struct am_ao ao;
+    int cnt;
+} m_trace;
+
+static const struct am_event* m_queue[TEST_NEVENTS + 1];
+
+static char m_pool[TEST_NEVENTS][16] AM_ALIGNED(AM_ALIGN_MAX);
+
+static void trace_init(void* ctx, const struct am_event* event) {
+    (void)event;
+    struct test_trace* me = (struct test_trace*)ctx;
+    am_ao_subscribe(&me->ao, AM_EVT_PUB);
+}
+
+static void trace_handler(void* ctx, const struct am_event* event) {
+    struct test_trace* me = (struct test_trace*)ctx;
+    switch (event->id) {
+    case AM_EVT_DATA:
+        ++me->cnt;
+        break;
+    case AM_EVT_PUB:
+        AM_ASSERT(TEST_NEVENTS == me->cnt);
+        am_ao_stop(&me->ao);
+        break;
+    default:
+        AM_ASSERT(0);
+    }
+}
+
+static void test_trace_file(FILE* file) {
+    int cnt[AM_TRACE_FREE + 1] = {0};
+    int nrecs = 0;
+    uint32_t time = 0;
+
+    rewind(file);
+    struct am_trace_rec rec;
+    while (1 == fread(&rec, sizeof(rec), 1, file)) {
+        AM_ASSERT((0 == nrecs) || (rec.time > time));
+        time = rec.time;
+        AM_ASSERT(rec.type <= AM_TRACE_FREE);
+        ++cnt[rec.type];
+        ++nrecs;
+
+        switch (rec.type) {
+        case AM_TRACE_POST:
+        case AM_TRACE_DISPATCH_BEGIN:
+        case AM_TRACE_DISPATCH_END:
+            AM_ASSERT(TEST_PRIO == rec.prio);
+            break;
+        case AM_TRACE_PUBLISH:
+            AM_ASSERT(AM_EVT_PUB == rec.id);
+            AM_ASSERT(0 == rec.pool);
+            break;
+        case AM_TRACE_ALLOCATE:
+        case AM_TRACE_FREE:
+            AM_ASSERT(AM_EVT_DATA == rec.id);
+            AM_ASSERT(1 == rec.pool);
+            break;
+        default:
+            AM_ASSERT(0);
+        }
+    }
+    AM_ASSERT((5 * TEST_NEVENTS + 3) == nrecs);
+    AM_ASSERT(TEST_NEVENTS == cnt[AM_TRACE_ALLOCATE]);
+    AM_ASSERT(TEST_NEVENTS == cnt[AM_TRACE_POST]);
+    AM_ASSERT(1 == cnt[AM_TRACE_PUBLISH]);
+    AM_ASSERT((TEST_NEVENTS + 1) == cnt[AM_TRACE_DISPATCH_BEGIN]);
+    AM_ASSERT((TEST_NEVENTS + 1) == cnt[AM_TRACE_DISPATCH_END]);
+    AM_ASSERT(TEST_NEVENTS == cnt[AM_TRACE_FREE]);
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    am_trace_init(m_slots, AM_COUNTOF(m_slots), test_get_time);
+
+    FILE* file = tmpfile();
+    AM_ASSERT(file);
+    struct am_trace_drain_cfg drain = {
+        .write = am_trace_drain_write_file, .ctx = file, .period_ms = 1
+    };
+    am_trace_drain_start(&drain);
+
+    struct am_event_alloc alloc;
+    am_event_alloc_init(&alloc);
+    am_event_alloc_add_pool(
+        &alloc, m_pool, sizeof(m_pool), sizeof(m_pool[0]), AM_ALIGN_MAX
+    );
+
+    static struct am_event_subscribe_list sub[AM_AO_EVT_PUB_MAX];
+    struct am_ao_cfg cfg = {
+        .crit_enter = am_crit_enter, .crit_exit = am_crit_exit, .alloc = &alloc
+    };
+    am_ao_global_init(&cfg, sub, AM_COUNTOF(sub));
+
+    struct test_trace* me = &m_trace;
+    am_ao_init(&me->ao, trace_init, trace_handler, me);
+    am_ao_start(
+        &me->ao,
+        (struct am_ao_prio){.ao = TEST_PRIO, .task = TEST_PRIO},
+        /*queue=*/m_queue,
+        /*queue_size=*/AM_COUNTOF(m_queue),
+        /*stack=*/NULL,
+        /*stack_size=*/0,
+        /*name=*/"trace",
+        /*init_event=*/NULL
+    );
+    am_ao_run_all();
+
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        const struct am_event* e =
+            am_event_allocate(&alloc, AM_EVT_DATA, sizeof(struct am_event));
+        am_ao_post_fifo(&me->ao, e);
+    }
+    am_ao_publish(&m_pub);
+
+    while (am_ao_get_cnt() > 0) {
+        am_ao_run_all();
+    }
+    am_trace_drain_stop();
+    AM_ASSERT(0 == am_trace_get_dropped());
+    AM_ASSERT(TEST_NEVENTS == am_event_alloc_get_nfree(&alloc, 0));
+
+    test_trace_file(file);
+    fclose(file);
+
+    am_ao_global_deinit();
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -31,6 +31,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "common/compiler.h"
 #include "common/macros.h"
 #include "bit/bit.h"
 
@@ -81,3 +82,97 @@ void am_bit_u64_clear(struct am_bit_u64* u64, int n) {
     mask &= ~(1U << i);
     u64->bytes = (unsigned char)mask;
 }
+
+/** Hierarchical bitmap levels. */
+struct am_bitmap_levels {
+    int ntop; /**< the number of top level words: 0 or 1 */
+    int nsum; /**< the number of summary words */
+};
+
+static struct am_bitmap_levels am_bitmap_get_levels(int nbits) {
+    AM_ASSERT(nbits > 0);
+    AM_ASSERT(nbits <= AM_BITMAP_NBITS_MAX);
+
+    int nleaf = AM_DIV_CEIL(nbits, 64);
+    struct am_bitmap_levels l = {0};
+    l.nsum = (nleaf > 1) ? AM_DIV_CEIL(nleaf, 64) : 0;
+    l.ntop = (l.nsum > 1) ? 1 : 0;
+    return l;
+}
+
+static int am_bitmap_word_msb(uint64_t word) {
+    AM_ASSERT(word);
+    return 63 - AM_CLZLL(word);
+}
+
+static uint64_t am_bitmap_word_mask(int n) {
+    return (uint64_t)1 << ((unsigned)n & 63U);
+}
+
+bool am_bitmap_is_empty(const uint64_t* map, int nbits) {
+    AM_ASSERT(map);
+    AM_ASSERT(nbits > 0);
+    AM_ASSERT(nbits <= AM_BITMAP_NBITS_MAX);
+    /* the first word is the highest level word */
+    return 0 == map[0];
+}
+
+int am_bitmap_msb(const uint64_t* map, int nbits) {
+    AM_ASSERT(map);
+    struct am_bitmap_levels l = am_bitmap_get_levels(nbits);
+    const uint64_t* sum = map + l.ntop;
+    const uint64_t* leaf = sum + l.nsum;
+
+    int s = l.ntop ? am_bitmap_word_msb(map[0]) : 0;
+    int w = l.nsum ? ((s * 64) + am_bitmap_word_msb(sum[s])) : 0;
+    return (w * 64) + am_bitmap_word_msb(leaf[w]);
+}
+
+bool am_bitmap_test(const uint64_t* map, int nbits, int n) {
+    AM_ASSERT(map);
+    AM_ASSERT(n >= 0);
+    AM_ASSERT(n < nbits);
+    struct am_bitmap_levels l = am_bitmap_get_levels(nbits);
+    const uint64_t* leaf = map + l.ntop + l.nsum;
+
+    return 0 != (leaf[n / 64] & am_bitmap_word_mask(n));
+}
+
+void am_bitmap_set(uint64_t* map, int nbits, int n) {
+    AM_ASSERT(map);
+    AM_ASSERT(n >= 0);
+    AM_ASSERT(n < nbits);
+    struct am_bitmap_levels l = am_bitmap_get_levels(nbits);
+    uint64_t* sum = map + l.ntop;
+    uint64_t* leaf = sum + l.nsum;
+
+    int w = n / 64;
+    leaf[w] |= am_bitmap_word_mask(n);
+    if (l.nsum) {
+        sum[w / 64] |= am_bitmap_word_mask(w);
+    }
+    if (l.ntop) {
+        map[0] |= am_bitmap_word_mask(w / 64);
+    }
+}
+
+void am_bitmap_clear(uint64_t* map, int nbits, int n) {
+    AM_ASSERT(map);
+    AM_ASSERT(n >= 0);
+    AM_ASSERT(n < nbits);
+    struct am_bitmap_levels l = am_bitmap_get_levels(nbits);
+    uint64_t* sum = map + l.ntop;
+    uint64_t* leaf = sum + l.nsum;
+
+    int w = n / 64;
+    leaf[w] &= ~am_bitmap_word_mask(n);
+    if (leaf[w] || !l.nsum) {
+        return;
+    }
+    int s = w / 64;
+    sum[s] &= ~am_bitmap_word_mask(w);
+    if (sum[s] || !l.ntop) {
+        return;
+    }
+    map[0] &= ~am_bitmap_word_mask(s);
+}
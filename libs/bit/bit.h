@@ -36,12 +36,33 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "common/macros.h"
+
 /** A 64 bit array. */
 struct am_bit_u64 {
     unsigned char bytes;   /**< redundant byte mask */
     unsigned char bits[8]; /**< the 64 bit array itself */
 };
 
+/** The maximum number of bits in hierarchical bitmap. */
+#define AM_BITMAP_NBITS_MAX (64 * 64 * 64)
+
+/**
+ * The number of 64 bit words needed for hierarchical bitmap.
+ *
+ * The bitmap has up to three levels: one leaf word per 64 bits,
+ * one summary word per 64 leaf words (if there is more than one leaf word)
+ * and one top word (if there is more than one summary word).
+ * Each summary bit is set, if the corresponding lower level word
+ * is not zero.
+ *
+ * @param nbits  the number of bits in the bitmap [1, #AM_BITMAP_NBITS_MAX]
+ */
+#define AM_BITMAP_NWORDS(nbits)                            \
+    (AM_DIV_CEIL(nbits, 64) +                              \
+     (((nbits) > 64) ? AM_DIV_CEIL(nbits, 64 * 64) : 0) + \
+     (((nbits) > (64 * 64)) ? 1 : 0))
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -90,6 +111,69 @@ void am_bit_u64_set(struct am_bit_u64* u64, int n);
  */
 void am_bit_u64_clear(struct am_bit_u64* u64, int n);
 
+/**
+ * Check if hierarchical bitmap has no bits set to 1.
+ *
+ * Takes O(1) to complete.
+ *
+ * @param map    the bitmap of #AM_BITMAP_NWORDS(nbits) words
+ * @param nbits  the number of bits in the bitmap
+ *
+ * @retval true   the bitmap is empty
+ * @retval false  the bitmap is not empty
+ */
+bool am_bitmap_is_empty(const uint64_t* map, int nbits);
+
+/**
+ * Return the index of the most significant bit (MSB) set to 1.
+ *
+ * Takes O(1) to complete.
+ * The bitmap must not be empty.
+ *
+ * @param map    the bitmap of #AM_BITMAP_NWORDS(nbits) words
+ * @param nbits  the number of bits in the bitmap
+ *
+ * @return the MSB index
+ */
+int am_bitmap_msb(const uint64_t* map, int nbits);
+
+/**
+ * Check if bit with index @p n is set to 1.
+ *
+ * @param map    the bitmap of #AM_BITMAP_NWORDS(nbits) words
+ * @param nbits  the number of bits in the bitmap
+ * @param n      the index of bit to check. Zero based.
+ *               The valid range [0..nbits-1].
+ *
+ * @retval true   the bit is set
+ * @retval false  the bit is not set
+ */
+bool am_bitmap_test(const uint64_t* map, int nbits, int n);
+
+/**
+ * Set bit with index @p n to 1.
+ *
+ * Takes O(1) to complete.
+ *
+ * @param map    the bitmap of #AM_BITMAP_NWORDS(nbits) words
+ * @param nbits  the number of bits in the bitmap
+ * @param n      the index of bit to set. Zero based.
+ *               The valid range [0..nbits-1].
+ */
+void am_bitmap_set(uint64_t* map, int nbits, int n);
+
+/**
+ * Clear bit with index @p n to 0.
+ *
+ * Takes O(1) to complete.
+ *
+ * @param map    the bitmap of #AM_BITMAP_NWORDS(nbits) words
+ * @param nbits  the number of bits in the bitmap
+ * @param n      the index of bit to clear. Zero based.
+ *               The valid range [0..nbits-1].
+ */
+void am_bitmap_clear(uint64_t* map, int nbits, int n);
+
 #ifdef __cplusplus
 }
 #endif
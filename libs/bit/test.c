@@ -29,6 +29,9 @@
  * Bit API unit tests.
  */
 
+#include <stdint.h>
+#include <string.h>
+
 #include "common/macros.h"
 #include "bit/bit.h"
 
@@ -66,8 +69,56 @@ static void test_bit_u64(void) {
     AM_ASSERT(am_bit_u64_is_empty(&u64));
 }
 
+static uint64_t m_map[AM_BITMAP_NWORDS(AM_BITMAP_NBITS_MAX) + 1];
+
+static void test_bitmap(int nbits, int step) {
+    memset(m_map, 0, sizeof(m_map));
+    const int nwords = AM_BITMAP_NWORDS(nbits);
+
+    AM_ASSERT(am_bitmap_is_empty(m_map, nbits));
+
+    int last = 0;
+    for (int i = 0; i < nbits; i += step) {
+        AM_ASSERT(!am_bitmap_test(m_map, nbits, i));
+        am_bitmap_set(m_map, nbits, i);
+        AM_ASSERT(am_bitmap_test(m_map, nbits, i));
+        AM_ASSERT(am_bitmap_msb(m_map, nbits) == i);
+        last = i;
+    }
+    am_bitmap_set(m_map, nbits, 0);
+    AM_ASSERT(am_bitmap_msb(m_map, nbits) == last);
+    AM_ASSERT(!am_bitmap_is_empty(m_map, nbits));
+    AM_ASSERT(0 == m_map[nwords]); /* no writes beyond the bitmap */
+
+    for (int i = last; i > 0; i -= step) {
+        AM_ASSERT(am_bitmap_msb(m_map, nbits) == i);
+        am_bitmap_clear(m_map, nbits, i);
+        AM_ASSERT(!am_bitmap_test(m_map, nbits, i));
+    }
+    AM_ASSERT(am_bitmap_msb(m_map, nbits) == 0);
+    am_bitmap_clear(m_map, nbits, 0);
+    AM_ASSERT(am_bitmap_is_empty(m_map, nbits));
+
+    for (int i = 0; i < nwords; ++i) {
+        AM_ASSERT(0 == m_map[i]);
+    }
+}
+
 int main(void) {
     test_bit_u64();
 
+    AM_ASSERT(1 == AM_BITMAP_NWORDS(1));
+    AM_ASSERT(1 == AM_BITMAP_NWORDS(64));
+    AM_ASSERT(3 == AM_BITMAP_NWORDS(65));
+    AM_ASSERT(65 == AM_BITMAP_NWORDS(64 * 64));
+    AM_ASSERT(68 == AM_BITMAP_NWORDS((64 * 64) + 1));
+
+    test_bitmap(/*nbits=*/1, /*step=*/1);
+    test_bitmap(/*nbits=*/64, /*step=*/1);
+    test_bitmap(/*nbits=*/65, /*step=*/1);
+    test_bitmap(/*nbits=*/64 * 64, /*step=*/1);
+    test_bitmap(/*nbits=*/(64 * 64) + 1, /*step=*/3);
+    test_bitmap(/*nbits=*/AM_BITMAP_NBITS_MAX, /*step=*/61);
+
     return 0;
 }
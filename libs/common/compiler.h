@@ -92,6 +92,8 @@
 #define AM_CLZL(x) __builtin_clzl(x)
 /** count trailing zeros in unsigned long */
 #define AM_CTZL(x) __builtin_ctzl(x)
+/** count leading zeros in unsigned long long */
+#define AM_CLZLL(x) __builtin_clzll(x)
 
 /**
  * The parameter `si` specifies which argument is the format string argument
@@ -121,4 +123,16 @@
 #define AM_ATOMIC_EXCHANGE_N(ptr, val) \
     __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST)
 
+/**
+ * Atomic compare and exchange operation.
+ *
+ * Stores `des` to `ptr`, if the value at `ptr` equals to the value at `exp`.
+ * Otherwise loads the value at `ptr` to `exp`.
+ * Evaluates to true, if `des` was stored.
+ */
+#define AM_ATOMIC_COMPARE_EXCHANGE_N(ptr, exp, des)                   \
+    __atomic_compare_exchange_n(                                      \
+        ptr, exp, des, /*weak=*/0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST \
+    )
+
 #endif /* AM_COMPILER_H_INCLUDED */
@@ -212,3 +212,20 @@ bool am_dlist_item_is_linked(const struct am_dlist_item* item) {
     AM_ASSERT(item);
     return item->next && item->prev;
 }
+
+void am_dlist_append(struct am_dlist* to, struct am_dlist* from) {
+    AM_ASSERT(to);
+    AM_ASSERT(from);
+    if (am_dlist_is_empty(from)) {
+        return;
+    }
+    struct am_dlist_item* first = from->sentinel.next;
+    struct am_dlist_item* last = from->sentinel.prev;
+
+    first->prev = to->sentinel.prev;
+    to->sentinel.prev->next = first;
+    last->next = &to->sentinel;
+    to->sentinel.prev = last;
+
+    am_dlist_init(from);
+}
@@ -358,6 +358,18 @@ bool am_dlist_owns(
     const struct am_dlist* list, const struct am_dlist_item* item
 );
 
+/**
+ * Append one list to another.
+ *
+ * Takes O(1) to complete.
+ *
+ * @param to    append to this list
+ * @param from  append this list.
+ *              The handler is initialized after the list is appended.
+ *              So this list becomes empty after it gets appended to @p to list.
+ */
+void am_dlist_append(struct am_dlist* to, struct am_dlist* from);
+
 #ifdef __cplusplus
 }
 #endif
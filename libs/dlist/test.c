@@ -337,6 +337,34 @@ static void test_am_dlist_next_prev_item(void) {
     AM_ASSERT(NULL == am_dlist_prev(&dlist, item2));
 }
 
+static void test_am_dlist_append(void) {
+    struct am_dlist from;
+    am_dlist_init(&from);
+    test_setup(&dlist);
+
+    am_dlist_append(&dlist, &from);
+    AM_ASSERT(am_dlist_is_empty(&dlist));
+
+    am_dlist_push_back(&from, &test_dlist[0].hdr);
+    am_dlist_append(&dlist, &from);
+    AM_ASSERT(am_dlist_is_empty(&from));
+    AM_ASSERT(&test_dlist[0].hdr == am_dlist_peek_front(&dlist));
+
+    am_dlist_push_back(&from, &test_dlist[1].hdr);
+    am_dlist_push_back(&from, &test_dlist[2].hdr);
+    am_dlist_append(&dlist, &from);
+    AM_ASSERT(am_dlist_is_empty(&from));
+
+    struct am_dlist_iterator it;
+    am_dlist_iterator_init(&dlist, &it, AM_DLIST_BACKWARD);
+    for (int i = 2; i >= 0; --i) {
+        struct am_dlist_item* item = am_dlist_iterator_next(&it);
+        AM_ASSERT(item);
+        AM_ASSERT(i == AM_CONTAINER_OF(item, struct test_dlist, hdr)->data);
+    }
+    AM_ASSERT(NULL == am_dlist_iterator_next(&it));
+}
+
 int main(void) {
     test_am_dlist_empty();
 
@@ -365,5 +393,7 @@ int main(void) {
 
     test_am_dlist_next_prev_item();
 
+    test_am_dlist_append();
+
     return 0;
 }
@@ -0,0 +1,155 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Event allocation benchmark.
+ *
+ * Several tasks allocate and free events concurrently.
+ * Run with argument 0 to allocate events directly from event pools
+ * and with argument 1 to allocate events from per task event caches.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "event/event_pool.h"
+#include "pal/pal.h"
+
+/** The number of allocating tasks */
+#define BENCH_NTASKS 4
+/** The number of events allocated by a task before freeing them */
+#define BENCH_BURST 4
+/** The number of bursts per task */
+#define BENCH_NBURSTS 200000
+
+struct bench_event {
+    struct am_event event;
+    uint32_t data;
+};
+
+static struct am_event_alloc m_alloc;
+static struct am_event_cache m_caches[BENCH_NTASKS];
+static struct am_event_cache* m_task_caches[AM_TASK_NUM_MAX];
+static bool m_use_caches;
+static int m_ndone;
+
+static struct am_event_cache* bench_get_cache(void) {
+    int task_id = am_task_get_own_id();
+    if (task_id < 0) {
+        return NULL;
+    }
+    return m_task_caches[task_id];
+}
+
+static void bench_task(void* param) {
+    struct am_event_cache* cache = (struct am_event_cache*)param;
+    if (m_use_caches) {
+        am_event_cache_init(&m_alloc, cache);
+        m_task_caches[am_task_get_own_id()] = cache;
+    }
+
+    const struct am_event* events[BENCH_BURST];
+    for (int i = 0; i < BENCH_NBURSTS; ++i) {
+        for (int j = 0; j < BENCH_BURST; ++j) {
+            events[j] = am_event_allocate(
+                &m_alloc, AM_EVT_USER, (int)sizeof(struct bench_event)
+            );
+        }
+        for (int j = 0; j < BENCH_BURST; ++j) {
+            am_event_free(&m_alloc, events[j]);
+        }
+    }
+
+    if (m_use_caches) {
+        am_event_cache_deinit(&m_alloc, cache);
+    }
+    AM_ATOMIC_FETCH_ADD(&m_ndone, 1);
+}
+
+int main(int argc, char* argv[]) {
+    AM_ASSERT(2 == argc);
+    m_use_caches = (0 != atoi(argv[1]));
+
+    am_pal_global_init(/*arg=*/NULL);
+    am_event_register_crit(am_crit_enter, am_crit_exit);
+
+    static struct bench_event pool[BENCH_NTASKS * AM_EVENT_CACHE_SIZE * 2];
+    am_event_alloc_init(&m_alloc);
+    am_event_alloc_add_pool(
+        &m_alloc,
+        pool,
+        (int)sizeof(pool),
+        (int)sizeof(pool[0]),
+        AM_ALIGNOF(am_event_t)
+    );
+    if (m_use_caches) {
+        am_event_alloc_set_cache_fn(&m_alloc, bench_get_cache);
+    }
+
+    for (int i = 0; i < BENCH_NTASKS; ++i) {
+        am_task_create(
+            "alloc",
+            /*prio=*/i,
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*init=*/NULL,
+            /*entry=*/bench_task,
+            /*flags=*/AM_TASK_FLAG_DETACH | AM_TASK_FLAG_WAIT_INIT,
+            /*arg=*/&m_caches[i]
+        );
+    }
+
+    uint32_t start_ms = am_time_get_ms();
+    am_task_init_wait();
+    while (AM_ATOMIC_LOAD_N(&m_ndone) < BENCH_NTASKS) {
+        am_sleep_ms(1);
+    }
+    uint32_t elapsed_ms = am_time_get_ms() - start_ms;
+
+    AM_ASSERT(
+        am_event_alloc_get_nblocks(&m_alloc, /*index=*/0) ==
+        am_event_alloc_get_nfree(&m_alloc, /*index=*/0)
+    );
+
+    const uint64_t nallocs =
+        (uint64_t)BENCH_NTASKS * BENCH_NBURSTS * BENCH_BURST;
+    am_printf(
+        "caches=%d ntasks=%d: %u ns/allocation\n",
+        m_use_caches,
+        BENCH_NTASKS,
+        (unsigned)(elapsed_ms * 1000000ULL / nallocs)
+    );
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -33,8 +33,11 @@
 #include <stdint.h>
 
 #include "event_common.h"
+#include "event_pool.h"
+#include "common/compiler.h"
 #include "common/macros.h"
 #include "onesize/onesize.h"
+#include "trace/trace.h"
 
 /** Pool index bit mask. */
 #define AM_EVENT_POOL_INDEX_MASK \
@@ -59,17 +62,299 @@ void am_event_register_crit(void (*crit_enter)(void), void (*crit_exit)(void)) {
     am_event_crit_exit = crit_exit;
 }
 
-struct am_event* am_event_allocate_x(
-    struct am_event_alloc* alloc, int id, int size, int margin
+/**
+ * Get the event cache of the calling task.
+ *
+ * @param alloc  the event allocator
+ *
+ * @return the event cache or NULL, if the calling task has no event cache
+ */
+static struct am_event_cache* am_event_cache_get(
+    const struct am_event_alloc* alloc
+) {
+    return alloc->get_cache ? alloc->get_cache() : NULL;
+}
+
+/**
+ * Update the minimum number of free memory blocks of event pool.
+ *
+ * Must be called inside critical section.
+ *
+ * @param alloc  the event allocator
+ * @param index  the event pool index
+ */
+static void am_event_cache_update_nfree_min_unsafe(
+    struct am_event_alloc* alloc, int index
+) {
+    int nfree = am_event_alloc_get_nfree_unsafe(alloc, index);
+    alloc->nfree_min[index] = AM_MIN(alloc->nfree_min[index], nfree);
+}
+
+/**
+ * Pop free memory block from event cache magazine.
+ *
+ * @param mag  the event cache magazine
+ *
+ * @return the free memory block
+ */
+static void* am_event_cache_pop(struct am_event_cache_mag* mag) {
+    AM_ASSERT(mag->nblocks > 0);
+    int nblocks = mag->nblocks - 1;
+    void* ptr = mag->blocks[nblocks];
+    AM_ATOMIC_STORE_N(&mag->nblocks, nblocks);
+    return ptr;
+}
+
+/**
+ * Push free memory block to event cache magazine.
+ *
+ * @param mag  the event cache magazine
+ * @param ptr  the free memory block
+ */
+static void am_event_cache_push(struct am_event_cache_mag* mag, void* ptr) {
+    AM_ASSERT(mag->nblocks < AM_EVENT_CACHE_SIZE);
+    mag->blocks[mag->nblocks] = ptr;
+    AM_ATOMIC_STORE_N(&mag->nblocks, mag->nblocks + 1);
+}
+
+/**
+ * Move up to AM_EVENT_CACHE_SIZE / 2 free memory blocks from event pool
+ * to empty event cache magazine.
+ *
+ * Must be called inside critical section.
+ *
+ * @param alloc  the event allocator
+ * @param mag    the event cache magazine
+ * @param index  the event pool index
+ */
+static void am_event_cache_refill_unsafe(
+    struct am_event_alloc* alloc, struct am_event_cache_mag* mag, int index
+) {
+    AM_ASSERT(0 == mag->nblocks);
+
+    for (int i = 0; i < AM_EVENT_CACHE_SIZE / 2; ++i) {
+        void* ptr = am_onesize_allocate_x(&alloc->pools[index], /*margin=*/0);
+        if (!ptr) {
+            break;
+        }
+        am_event_cache_push(mag, ptr);
+    }
+}
+
+/**
+ * Move free memory blocks from event cache magazine to event pool.
+ *
+ * Must be called inside critical section.
+ *
+ * @param alloc  the event allocator
+ * @param mag    the event cache magazine
+ * @param index  the event pool index
+ * @param num    the number of memory blocks to move
+ */
+static void am_event_cache_drain_unsafe(
+    struct am_event_alloc* alloc,
+    struct am_event_cache_mag* mag,
+    int index,
+    int num
+) {
+    AM_ASSERT(num <= mag->nblocks);
+
+    for (int i = 0; i < num; ++i) {
+        am_onesize_free(&alloc->pools[index], am_event_cache_pop(mag));
+    }
+}
+
+/**
+ * Allocate memory block from event cache.
+ *
+ * Enters critical section only, if the event cache is to be refilled
+ * or if @p margin is not zero.
+ * The event cache is refilled, when its last memory block is allocated.
+ * So, the minimum number of free memory blocks is updated,
+ * when the event cache runs empty.
+ *
+ * @param alloc   the event allocator
+ * @param cache   the event cache of the calling task
+ * @param index   the event pool index
+ * @param margin  free memory blocks to remain available after the allocation
+ *
+ * @return the allocated memory block or NULL, if allocation failed
+ */
+static void* am_event_cache_allocate(
+    struct am_event_alloc* alloc,
+    struct am_event_cache* cache,
+    int index,
+    int margin
+) {
+    struct am_event_cache_mag* mag = &cache->mags[index];
+    if ((0 == margin) && (mag->nblocks > 1)) {
+        return am_event_cache_pop(mag);
+    }
+
+    void* ptr = NULL;
+    am_event_crit_enter();
+    if (am_event_alloc_get_nfree_unsafe(alloc, index) > margin) {
+        if (0 == mag->nblocks) {
+            am_event_cache_refill_unsafe(alloc, mag, index);
+        }
+        if (mag->nblocks > 0) {
+            ptr = am_event_cache_pop(mag);
+        }
+        if (0 == mag->nblocks) {
+            am_event_cache_refill_unsafe(alloc, mag, index);
+        }
+    }
+    am_event_cache_update_nfree_min_unsafe(alloc, index);
+    am_event_crit_exit();
+
+    return ptr;
+}
+
+/**
+ * Return event to event cache.
+ *
+ * Enters critical section only, if the event cache is to be flushed.
+ *
+ * @param alloc  the event allocator
+ * @param cache  the event cache of the calling task
+ * @param event  the event allocated from one of the event pools of @p alloc
+ */
+static void am_event_cache_free(
+    struct am_event_alloc* alloc,
+    struct am_event_cache* cache,
+    const struct am_event* event
+) {
+    /*
+     * Check if event is valid.
+     * If the below assert hits, then the reason is likely
+     * a double free condition.
+     */
+    AM_ASSERT(((uint32_t)event->id & AM_EVENT_ID_LSW_MASK) == event->id_lsw);
+
+    AM_TRACE(AM_TRACE_FREE, AM_TRACE_PRIO_NONE, event);
+
+    int index = (int)event->pool_index_plus_one - 1;
+    struct am_event_cache_mag* mag = &cache->mags[index];
+    struct am_event* e = AM_CAST(struct am_event*, event);
+    /*
+     * The event cache does not overwrite the memory block.
+     * So, invalidate the event to catch double free and use after free.
+     */
+    e->id_lsw = (e->id_lsw + 1U) & AM_EVENT_ID_LSW_MASK;
+
+    if (AM_EVENT_CACHE_SIZE == mag->nblocks) {
+        am_event_crit_enter();
+        am_event_cache_drain_unsafe(
+            alloc, mag, index, /*num=*/AM_EVENT_CACHE_SIZE / 2
+        );
+        am_event_crit_exit();
+    }
+    am_event_cache_push(mag, e);
+}
+
+void am_event_cache_init(
+    struct am_event_alloc* alloc, struct am_event_cache* cache
 ) {
-    AM_ASSERT(size > 0);
     AM_ASSERT(alloc);
-    AM_ASSERT(alloc->npools > 0);
-    AM_ASSERT(alloc->npools <= AM_EVENT_POOL_INDEX_MAX);
+    AM_ASSERT(cache);
+
+    memset(cache, 0, sizeof(*cache));
+
+    am_event_crit_enter();
+    cache->next = alloc->caches;
+    alloc->caches = cache;
+    am_event_crit_exit();
+}
+
+void am_event_cache_flush(
+    struct am_event_alloc* alloc, struct am_event_cache* cache
+) {
+    AM_ASSERT(alloc);
+    AM_ASSERT(cache);
+
+    am_event_crit_enter();
+    for (int i = 0; i < alloc->npools; ++i) {
+        struct am_event_cache_mag* mag = &cache->mags[i];
+        am_event_cache_drain_unsafe(alloc, mag, i, mag->nblocks);
+    }
+    am_event_crit_exit();
+}
+
+void am_event_cache_deinit(
+    struct am_event_alloc* alloc, struct am_event_cache* cache
+) {
+    am_event_cache_flush(alloc, cache);
+
+    am_event_crit_enter();
+    struct am_event_cache** c = &alloc->caches;
+    while (*c && (*c != cache)) {
+        c = &(*c)->next;
+    }
+    AM_ASSERT(*c); /* the event cache was not registered */
+    *c = cache->next;
+    cache->next = NULL;
+    am_event_crit_exit();
+}
+
+/**
+ * Update event allocator statistics.
+ *
+ * Uses atomic operations.
+ *
+ * @param stats      the event allocator statistics
+ * @param size       the requested event size [bytes]
+ * @param index      the index of the event pool serving the event
+ * @param allocated  true, if the event was allocated
+ */
+static void am_event_alloc_stats_update(
+    struct am_event_alloc_stats* stats, int size, int index, bool allocated
+) {
+    if (size <= AM_EVENT_SIZE_LUT_MAX) {
+        int i = (size - 1) / AM_EVENT_SIZE_LUT_GRANULE;
+        AM_ATOMIC_FETCH_ADD(&stats->nallocs[i], 1U);
+    } else {
+        AM_ATOMIC_FETCH_ADD(&stats->nallocs_big, 1U);
+    }
+    uint32_t usize = (uint32_t)size;
+    uint32_t size_max = AM_ATOMIC_LOAD_N(&stats->size_max);
+    while (usize > size_max) {
+        if (AM_ATOMIC_COMPARE_EXCHANGE_N(&stats->size_max, &size_max, usize)) {
+            break;
+        }
+    }
+    if (!allocated) {
+        AM_ATOMIC_FETCH_ADD(&stats->nfailed[index], 1U);
+    }
+}
+
+/**
+ * Find the event pool with the smallest memory blocks fitting the event.
+ *
+ * Uses the event size lookup table built by am_event_alloc_add_pool()
+ * for event sizes up to AM_EVENT_SIZE_LUT_MAX bytes.
+ * Uses binary search over the event pools for bigger events.
+ *
+ * @param alloc  the event allocator
+ * @param size   the event size [bytes]
+ *
+ * @return the event pool index
+ */
+static int am_event_alloc_find_pool(
+    const struct am_event_alloc* alloc, int size
+) {
     int maxind = alloc->npools - 1;
     AM_ASSERT(size <= am_onesize_get_block_size(&alloc->pools[maxind]));
-    AM_ASSERT(id >= AM_EVT_USER);
-    AM_ASSERT(margin >= 0);
+
+    if (size <= AM_EVENT_SIZE_LUT_MAX) {
+        int lut = (size - 1) / AM_EVENT_SIZE_LUT_GRANULE;
+        int index = (int)alloc->size_lut[lut] - 1;
+        AM_ASSERT(index >= 0);
+        /* several event pools may share one lookup table entry */
+        while (size > am_onesize_get_block_size(&alloc->pools[index])) {
+            ++index;
+        }
+        return index;
+    }
 
     /* find allocator using binary search */
     int left = 0;
@@ -86,9 +371,36 @@ struct am_event* am_event_allocate_x(
             break;
         }
     }
-    am_event_crit_enter();
-    struct am_event* event = am_onesize_allocate_x(&alloc->pools[left], margin);
-    am_event_crit_exit();
+    return left;
+}
+
+struct am_event* am_event_allocate_x(
+    struct am_event_alloc* alloc, int id, int size, int margin
+) {
+    AM_ASSERT(size > 0);
+    AM_ASSERT(alloc);
+    AM_ASSERT(alloc->npools > 0);
+    AM_ASSERT(alloc->npools <= AM_EVENT_POOL_INDEX_MAX);
+    AM_ASSERT(id >= AM_EVT_USER);
+    AM_ASSERT(margin >= 0);
+
+    int index = am_event_alloc_find_pool(alloc, size);
+    struct am_event* event = NULL;
+    struct am_event_cache* cache = am_event_cache_get(alloc);
+    if (cache) {
+        event = am_event_cache_allocate(alloc, cache, index, margin);
+    } else {
+        am_event_crit_enter();
+        event = am_onesize_allocate_x(&alloc->pools[index], margin);
+        if (alloc->get_cache) {
+            am_event_cache_update_nfree_min_unsafe(alloc, index);
+        }
+        am_event_crit_exit();
+    }
+
+    if (alloc->stats) {
+        am_event_alloc_stats_update(alloc->stats, size, index, event != NULL);
+    }
 
     if (!event) { /* cppcheck-suppress knownConditionTrueFalse */
         return NULL;
@@ -98,7 +410,9 @@ struct am_event* am_event_allocate_x(
     event->id = (uint16_t)id;
     event->id_lsw = (uint16_t)id & AM_EVENT_ID_LSW_MASK;
     event->pool_index_plus_one =
-        (unsigned)(left + 1) & AM_EVENT_POOL_INDEX_MASK;
+        (unsigned)(index + 1) & AM_EVENT_POOL_INDEX_MASK;
+
+    AM_TRACE(AM_TRACE_ALLOCATE, AM_TRACE_PRIO_NONE, event);
 
     return event;
 }
@@ -112,13 +426,22 @@ struct am_event* am_event_allocate(
     return event;
 }
 
-void am_event_free_unsafe(
-    struct am_event_alloc* alloc, const struct am_event* event
+/**
+ * Release one event reference.
+ *
+ * Does not release the last event reference.
+ * Uses atomic operations, if AM_EVENT_REF_COUNTER_ATOMIC is defined.
+ * Otherwise must be called inside critical section.
+ *
+ * @param alloc  the event allocator
+ * @param event  the event allocated from one of the event pools of @p alloc
+ *
+ * @retval true   the reference was released, the event is still referenced
+ * @retval false  the event is to be returned to its event pool
+ */
+static bool am_event_release(
+    const struct am_event_alloc* alloc, const struct am_event* event
 ) {
-    if (am_event_is_static(event)) {
-        return; /* the event is statically allocated */
-    }
-
     AM_ASSERT(alloc);
 
     struct am_event* e = AM_CAST(struct am_event*, event);
@@ -130,20 +453,96 @@ void am_event_free_unsafe(
      */
     AM_ASSERT(((uint32_t)e->id & AM_EVENT_ID_LSW_MASK) == e->id_lsw);
 
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    uint32_t cnt = AM_ATOMIC_LOAD_N(&e->ref_counter);
+    do {
+        if (cnt <= 1) {
+            return false;
+        }
+    } while (!AM_ATOMIC_COMPARE_EXCHANGE_N(&e->ref_counter, &cnt, cnt - 1));
+    return true;
+#else
     if (e->ref_counter > 1) {
         --e->ref_counter;
-        return;
+        return true;
     }
+    return false;
+#endif
+}
+
+/**
+ * Return event to its event pool.
+ *
+ * Must be called inside critical section.
+ *
+ * @param alloc  the event allocator
+ * @param event  the event allocated from one of the event pools of @p alloc
+ */
+static void am_event_dispose_unsafe(
+    struct am_event_alloc* alloc, const struct am_event* event
+) {
+    AM_TRACE(AM_TRACE_FREE, AM_TRACE_PRIO_NONE, event);
 
-    am_onesize_free(&alloc->pools[e->pool_index_plus_one - 1], e);
+    am_onesize_free(
+        &alloc->pools[event->pool_index_plus_one - 1],
+        AM_CAST(struct am_event*, event)
+    );
+}
+
+void am_event_free_unsafe(
+    struct am_event_alloc* alloc, const struct am_event* event
+) {
+    if (am_event_is_static(event)) {
+        return; /* the event is statically allocated */
+    }
+    if (!am_event_release(alloc, event)) {
+        am_event_dispose_unsafe(alloc, event);
+    }
 }
 
 void am_event_free(struct am_event_alloc* alloc, const struct am_event* event) {
     AM_ASSERT(event);
 
+    if (am_event_is_static(event)) {
+        return;
+    }
+    struct am_event_cache* cache = am_event_cache_get(alloc);
+
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    if (am_event_release(alloc, event)) {
+        return;
+    }
+    if (cache) {
+        am_event_cache_free(alloc, cache, event);
+        return;
+    }
+    am_event_crit_enter();
+    am_event_dispose_unsafe(alloc, event);
+    am_event_crit_exit();
+#else
+    if (cache && (event->ref_counter <= 1)) {
+        /*
+         * The caller holds the last event reference.
+         * So, no other task is to update the event reference counter
+         * and the event is returned to the event cache without entering
+         * critical section.
+         */
+        am_event_cache_free(alloc, cache, event);
+        return;
+    }
     am_event_crit_enter();
-    am_event_free_unsafe(alloc, event);
+    if (am_event_release(alloc, event)) {
+        am_event_crit_exit();
+        return;
+    }
+    if (!cache) {
+        am_event_dispose_unsafe(alloc, event);
+        am_event_crit_exit();
+        return;
+    }
     am_event_crit_exit();
+    am_event_cache_free(alloc, cache, event);
+#endif
 }
 
 struct am_event* am_event_dup_x(
@@ -195,7 +594,7 @@ bool am_event_is_static(const struct am_event* event) {
     return (0 == (event->pool_index_plus_one & AM_EVENT_POOL_INDEX_MASK));
 }
 
-void am_event_inc_ref_cnt(const struct am_event* event) {
+void am_event_inc_ref_cnt_unsafe(const struct am_event* event) {
     AM_ASSERT(event);
 
     if (am_event_is_static(event)) {
@@ -211,12 +610,23 @@ void am_event_inc_ref_cnt(const struct am_event* event) {
 
     struct am_event* e = AM_CAST(struct am_event*, event);
 
-    am_event_crit_enter();
-
-    AM_ASSERT(event->ref_counter < AM_EVENT_REF_COUNTER_MAX);
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    uint32_t cnt = AM_ATOMIC_FETCH_ADD(&e->ref_counter, 1U);
+    AM_ASSERT(cnt < AM_EVENT_REF_COUNTER_MAX);
+#else
+    AM_ASSERT(e->ref_counter < AM_EVENT_REF_COUNTER_MAX);
     ++e->ref_counter;
+#endif
+}
 
+void am_event_inc_ref_cnt(const struct am_event* event) {
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    am_event_inc_ref_cnt_unsafe(event);
+#else
+    am_event_crit_enter();
+    am_event_inc_ref_cnt_unsafe(event);
     am_event_crit_exit();
+#endif
 }
 
 void am_event_dec_ref_cnt(
@@ -232,9 +642,13 @@ int am_event_get_ref_cnt(
     (void)alloc;
     AM_ASSERT(event);
 
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    int cnt = (int)AM_ATOMIC_LOAD_N(&event->ref_counter);
+#else
     am_event_crit_enter();
     int cnt = event->ref_counter;
     am_event_crit_exit();
+#endif
 
     return cnt;
 }
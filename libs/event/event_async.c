@@ -50,6 +50,8 @@ struct am_event_async_state {
     struct am_event_async_handler {
         /** Event handler function */
         am_event_async_fn fn;
+        /** Event handler check function */
+        am_event_async_check_fn check;
         /** Event handler context */
         void* ctx;
     } handlers[AM_EVT_HANDLERS_NUM_MAX]; /**< event handlers */
@@ -94,11 +96,9 @@ void am_event_async_subscribe(int handler_id, int event_id) {
     int si = event_id - AM_EVT_USER;
     AM_ASSERT(si < me->nsub);
 
-    int li = handler_id / 8;
-
     am_event_crit_enter();
 
-    me->sub[si].list[li] |= (uint8_t)(1U << (unsigned)(handler_id % 8));
+    am_bitmap_set(me->sub[si].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
 
     am_event_crit_exit();
 }
@@ -114,11 +114,9 @@ void am_event_async_unsubscribe(int handler_id, int event_id) {
     int si = event_id - AM_EVT_USER;
     AM_ASSERT(si < me->nsub);
 
-    int li = handler_id / 8;
-
     am_event_crit_enter();
 
-    me->sub[si].list[li] &= (uint8_t)~(1U << (unsigned)(handler_id % 8));
+    am_bitmap_clear(me->sub[si].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
 
     am_event_crit_exit();
 }
@@ -129,13 +127,10 @@ void am_event_async_unsubscribe_all(int handler_id) {
     struct am_event_async_state* me = &m_async_state;
     AM_ASSERT(me->handlers[handler_id].fn);
 
-    int li = handler_id / 8;
-    unsigned clear_mask = ~(1U << (unsigned)(handler_id % 8));
-
     am_event_crit_enter();
 
     for (int i = 0; i < me->nsub; ++i) {
-        me->sub[i].list[li] &= (uint8_t)clear_mask;
+        am_bitmap_clear(me->sub[i].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
     }
 
     am_event_crit_exit();
@@ -143,6 +138,15 @@ void am_event_async_unsubscribe_all(int handler_id) {
 
 void am_event_async_register_with_id(
     am_event_async_fn fn, void* ctx, int handler_id
+) {
+    am_event_async_register_with_id_x(fn, /*check=*/NULL, ctx, handler_id);
+}
+
+void am_event_async_register_with_id_x(
+    am_event_async_fn fn,
+    am_event_async_check_fn check,
+    void* ctx,
+    int handler_id
 ) {
     AM_ASSERT(fn);
     AM_ASSERT(handler_id >= 0);
@@ -155,6 +159,7 @@ void am_event_async_register_with_id(
     AM_ASSERT(NULL == me->handlers[handler_id].fn);
 
     me->handlers[handler_id].fn = fn;
+    me->handlers[handler_id].check = check;
     me->handlers[handler_id].ctx = ctx;
 
     am_event_crit_exit();
@@ -167,15 +172,13 @@ void am_event_async_unregister(int handler_id) {
 
     am_event_crit_enter();
 
-    int h = handler_id / 8;
-    unsigned clear_mask = ~(1U << (unsigned)(handler_id % 8));
-
     for (int i = 0; i < me->nsub; ++i) {
-        me->sub[i].list[h] &= (uint8_t)clear_mask;
+        am_bitmap_clear(me->sub[i].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
     }
 
     AM_ASSERT(me->handlers[handler_id].fn);
     me->handlers[handler_id].fn = NULL;
+    me->handlers[handler_id].check = NULL;
     me->handlers[handler_id].ctx = NULL;
 
     am_event_crit_exit();
@@ -204,6 +207,39 @@ bool am_event_async_post(
     return ok;
 }
 
+/**
+ * Check if all subscribed event handlers can accept event.
+ *
+ * Must be called inside critical section.
+ *
+ * @param me      the asynchronous event state
+ * @param sub     the subscribed event handlers
+ * @param policy  the event queue posting policy
+ *
+ * @return true, if all event handlers can accept event, false otherwise
+ */
+static bool am_event_async_check_all_unsafe(
+    const struct am_event_async_state* me,
+    struct am_event_subscribe_list sub,
+    struct am_event_queue_policy policy
+) {
+    const int nbits = AM_EVT_HANDLERS_NUM_MAX;
+    while (!am_bitmap_is_empty(sub.list, nbits)) {
+        const int ind = am_bitmap_msb(sub.list, nbits);
+        am_bitmap_clear(sub.list, nbits, ind);
+
+        if (policy.exclude_id == ind) {
+            continue;
+        }
+        const struct am_event_async_handler* handler = &me->handlers[ind];
+        if (handler->fn && handler->check &&
+            !handler->check(handler->ctx, policy)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool am_event_async_publish(
     const struct am_event* event, struct am_event_queue_policy policy
 ) {
@@ -217,50 +253,48 @@ bool am_event_async_publish(
 
     AM_ASSERT(si < me->nsub);
 
+    /*
+     * The event is delivered to all subscribers in one critical section.
+     * So, the event handlers cannot preempt the publishing and
+     * the event publishing order does not cause priority inversion.
+     */
+    am_event_crit_enter();
+
     if (!am_event_is_static(event)) {
         AM_ASSERT(me->alloc);
         /*
-         * To avoid a potential race condition, if higher priority
-         * event handler preempts the event publishing and frees the event
-         * as processed.
+         * The event must not be freed, if the event delivery fails
+         * for some subscribers after it succeeded for others.
          */
-        am_event_inc_ref_cnt(event);
+        am_event_inc_ref_cnt_unsafe(event);
     }
 
-    bool all_published = true;
-
-    /*
-     * The event publishing is done for higher priority
-     * event handlers first to avoid priority inversion.
-     */
-    am_event_crit_enter();
-
     struct am_event_subscribe_list sub = me->sub[si];
 
-    am_event_crit_exit();
-
-    for (int i = AM_COUNTOF(sub.list) - 1; i >= 0; --i) {
-        while (sub.list[i]) {
-            int msb = am_bit_u8_msb(sub.list[i]);
-            sub.list[i] &= (uint8_t)~(1U << (unsigned)msb);
+    bool all_published = true;
+    if (policy.all_or_none) {
+        all_published = am_event_async_check_all_unsafe(me, sub, policy);
+        if (!all_published) {
+            memset(&sub, 0, sizeof(sub));
+        }
+    }
 
-            const int ind = (8 * i) + msb;
-            if (policy.exclude_id == ind) {
-                continue;
-            }
+    const int nbits = AM_EVT_HANDLERS_NUM_MAX;
+    while (!am_bitmap_is_empty(sub.list, nbits)) {
+        const int ind = am_bitmap_msb(sub.list, nbits);
+        am_bitmap_clear(sub.list, nbits, ind);
 
-            am_event_crit_enter();
+        if (policy.exclude_id == ind) {
+            continue;
+        }
 
-            struct am_event_async_handler* handler = &me->handlers[ind];
+        struct am_event_async_handler* handler = &me->handlers[ind];
 
-            if (handler->fn) {
-                bool ok = handler->fn(handler->ctx, event, policy);
-                if (!ok) {
-                    all_published = false;
-                }
+        if (handler->fn) {
+            bool ok = handler->fn(handler->ctx, event, policy);
+            if (!ok) {
+                all_published = false;
             }
-
-            am_event_crit_exit();
         }
     }
 
@@ -270,7 +304,9 @@ bool am_event_async_publish(
      * the function. Also takes care of the case when no event handlers
      * subscribed to this event.
      */
-    am_event_free(me->alloc, event);
+    am_event_free_unsafe(me->alloc, event);
+
+    am_event_crit_exit();
 
     return all_published;
 }
@@ -55,6 +55,23 @@ typedef bool (*am_event_async_fn)(
     void* ctx, const struct am_event* event, struct am_event_queue_policy policy
 );
 
+/**
+ * Asynchronous event handler check function type.
+ *
+ * Called from am_event_async_publish() inside an event critical section
+ * for every subscribed event handler before the event is delivered to any
+ * of them, if am_event_queue_policy::all_or_none is set.
+ * Same limitations as for #am_event_async_fn apply.
+ *
+ * @param ctx     event handler specific context
+ * @param policy  the event queue handling policy
+ *
+ * @return true, if the event handler can accept an event, false otherwise
+ */
+typedef bool (*am_event_async_check_fn)(
+    void* ctx, struct am_event_queue_policy policy
+);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -150,6 +167,30 @@ void am_event_async_register_with_id(
     am_event_async_fn fn, void* ctx, int handler_id
 );
 
+/**
+ * Register event handler with ID (eXtended version).
+ *
+ * Same as am_event_async_register_with_id() except it also registers
+ * the check function used by am_event_async_publish() to deliver events
+ * in all-or-none mode.
+ *
+ * @param fn     the event handler function.
+ *               See am_event_async_register_with_id() for details.
+ * @param check  the event handler check function or NULL.
+ *               Called by am_event_async_publish() inside a critical section.
+ *               Event handlers without the check function are assumed
+ *               to accept any event.
+ * @param ctx    the event handler and check functions context
+ * @param handler_id  the event handler ID to register with.
+ *                    See am_event_async_register_with_id() for details.
+ */
+void am_event_async_register_with_id_x(
+    am_event_async_fn fn,
+    am_event_async_check_fn check,
+    void* ctx,
+    int handler_id
+);
+
 /**
  * Unregister event handler by ID.
  *
@@ -189,6 +230,15 @@ bool am_event_async_post(
  * This function delivers @p event to all event handlers subscribed to the
  * event ID carried by @p event.
  *
+ * The event is delivered to all subscribers within one critical section.
+ *
+ * If am_event_queue_policy::all_or_none of @p policy is set, then
+ * the check functions of all subscribers are called first and the event
+ * is delivered only, if all of them accept it.
+ * Lock-free pushes of static events to MPSC event queues
+ * (see am_event_queue_set_mpsc()) bypass the critical section and so
+ * might still take the checked event queue slots meanwhile.
+ *
  * @param event         input event
  * @param policy        event queue posting policy
  * @return true on success, false otherwise
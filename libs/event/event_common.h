@@ -39,11 +39,16 @@
 #include "common/alignment.h"
 #include "common/macros.h"
 #include "common/types.h"
+#include "bit/bit.h"
 #include "onesize/onesize.h"
 /* #include "event/event_pool.h" */
 
+#ifndef AM_EVT_HANDLERS_NUM_MAX
 /** The maximum number of event handlers */
 #define AM_EVT_HANDLERS_NUM_MAX 64
+#endif
+
+AM_ASSERT_STATIC(AM_EVT_HANDLERS_NUM_MAX <= AM_BITMAP_NBITS_MAX);
 
 /**
  * Empty event.
@@ -111,8 +116,14 @@
 /** Event reference counter bit mask. */
 #define AM_EVENT_REF_COUNTER_MASK \
     ((1U << (unsigned)AM_EVENT_REF_COUNTER_BITS) - 1U)
+
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+/** Maximum value of reference counter. */
+#define AM_EVENT_REF_COUNTER_MAX 0x7FFFFFFFU
+#else
 /** Maximum value of reference counter. */
 #define AM_EVENT_REF_COUNTER_MAX AM_EVENT_REF_COUNTER_MASK
+#endif
 
 /** Event ID least significant word bit mask. */
 #define AM_EVENT_ID_LSW_MASK ((1U << (unsigned)AM_EVENT_ID_LSW_BITS) - 1U)
@@ -120,13 +131,27 @@
 /** Unknown publisher ID */
 #define AM_EVENT_PUBLISHER_ID_NONE (-1)
 
-/** Event descriptor. */
+/**
+ * Event descriptor.
+ *
+ * If AM_EVENT_REF_COUNTER_ATOMIC is defined, then the event reference counter
+ * is a separate word updated with atomic operations. So, the event
+ * reference counter is not limited to #AM_EVENT_REF_COUNTER_MASK and
+ * the events are referenced and released without entering
+ * critical section. Only the release of the last reference of an event
+ * enters critical section to return the event to its event pool.
+ */
 struct am_event {
     /** event ID */
     uint32_t id : 16;
 
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    /** not used (see am_event::ref_counter) */
+    uint32_t reserved : AM_EVENT_REF_COUNTER_BITS; /* 7 bits */
+#else
     /** reference counter */
     uint32_t ref_counter : AM_EVENT_REF_COUNTER_BITS; /* 7 bits */
+#endif
     /** if set to zero, then event is not event pool allocated */
     uint32_t pool_index_plus_one : AM_EVENT_POOL_INDEX_BITS; /* 5 bits */
     /**
@@ -134,12 +159,20 @@ struct am_event {
      * Used for sanity checks.
      */
     uint32_t id_lsw : AM_EVENT_ID_LSW_BITS; /* 4 bits */
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    /** reference counter (atomic) */
+    uint32_t ref_counter;
+#endif
 };
 
 /** To use with AM_ALIGNOF() macro. */
 typedef struct am_event am_event_t;
 
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+AM_ASSERT_STATIC(sizeof(struct am_event) == (2 * sizeof(uint32_t)));
+#else
 AM_ASSERT_STATIC(sizeof(struct am_event) == sizeof(uint32_t));
+#endif
 
 /** To use with AM_ALIGNOF() macro. */
 typedef struct am_event* am_event_ptr_t;
@@ -152,7 +185,8 @@ AM_ALIGNOF_DEFINE(am_event_ptr_t);
 
 /** The subscribe list for one event. */
 struct am_event_subscribe_list {
-    uint8_t list[AM_DIV_CEIL(AM_EVT_HANDLERS_NUM_MAX, 8)]; /**< the bitmask */
+    /** the bitmap of event handler IDs (see am_bitmap_set()) */
+    uint64_t list[AM_BITMAP_NWORDS(AM_EVT_HANDLERS_NUM_MAX)];
 };
 
 /**
@@ -184,12 +218,118 @@ struct am_event_log_ctx {
 #define AM_EVENT_POOLS_NUM_MAX 3
 #endif
 
+#ifndef AM_EVENT_SIZE_LUT_MAX
+/**
+ * The max event size [bytes] served by the event size lookup table.
+ * The lookup table maps event sizes to event pools in constant time.
+ * Bigger events are mapped to event pools with binary search.
+ */
+#define AM_EVENT_SIZE_LUT_MAX 256
+#endif
+
+/** The event size lookup table granularity [bytes] */
+#define AM_EVENT_SIZE_LUT_GRANULE 4
+
+AM_ASSERT_STATIC(AM_EVENT_SIZE_LUT_MAX >= AM_EVENT_SIZE_LUT_GRANULE);
+AM_ASSERT_STATIC(AM_EVENT_SIZE_LUT_MAX < (255 * AM_EVENT_SIZE_LUT_GRANULE));
+
+/** The number of event size lookup table entries */
+#define AM_EVENT_SIZE_LUT_NUM \
+    (AM_EVENT_SIZE_LUT_MAX / AM_EVENT_SIZE_LUT_GRANULE)
+
+#ifndef AM_EVENT_CACHE_SIZE
+/**
+ * The max number of free memory blocks an event cache keeps per event pool.
+ * The event cache is refilled from and flushed to the event pool
+ * in batches of half of this number of memory blocks.
+ */
+#define AM_EVENT_CACHE_SIZE 8
+#endif
+
+AM_ASSERT_STATIC(AM_EVENT_CACHE_SIZE >= 2);
+
+/** Event cache magazine - LIFO stack of free memory blocks of one pool. */
+struct am_event_cache_mag {
+    /** the free memory blocks */
+    void* blocks[AM_EVENT_CACHE_SIZE];
+    /** the number of free memory blocks in am_event_cache_mag::blocks */
+    int nblocks;
+};
+
+/**
+ * Event cache.
+ *
+ * Owned by one task. Serves the event allocations and frees
+ * done by the task without entering critical section.
+ * See am_event_cache_init() and am_event_alloc_set_cache_fn() for details.
+ */
+struct am_event_cache {
+    /** one magazine per event pool */
+    struct am_event_cache_mag mags[AM_EVENT_POOLS_NUM_MAX];
+    /** the next event cache registered with the same event allocator */
+    struct am_event_cache* next;
+};
+
+/**
+ * Get the event cache of the calling task.
+ * Used as a parameter to am_event_alloc_set_cache_fn() API.
+ * @return the event cache of the calling task or NULL, if the calling
+ *         task or interrupt has no event cache
+ */
+typedef struct am_event_cache* (*am_event_cache_fn)(void);
+
+/**
+ * Event allocator statistics.
+ *
+ * See am_event_alloc_set_stats() and am_event_alloc_advise() for details.
+ */
+struct am_event_alloc_stats {
+    /**
+     * Requested event sizes histogram.
+     * The entry i counts the allocations of events of
+     * (i * AM_EVENT_SIZE_LUT_GRANULE, (i + 1) * AM_EVENT_SIZE_LUT_GRANULE]
+     * bytes.
+     */
+    uint32_t nallocs[AM_EVENT_SIZE_LUT_NUM];
+    /** the number of allocations of events bigger than AM_EVENT_SIZE_LUT_MAX */
+    uint32_t nallocs_big;
+    /** the biggest requested event size [bytes] */
+    uint32_t size_max;
+    /** the number of failed allocations per event pool */
+    uint32_t nfailed[AM_EVENT_POOLS_NUM_MAX];
+};
+
+/** Event pool proposed by am_event_alloc_advise(). */
+struct am_event_pool_advice {
+    int block_size; /**< the memory block size [bytes] */
+    int nblocks;    /**< the number of memory blocks */
+};
+
 /** Event allocator */
 struct am_event_alloc {
     /** user defined event memory pools  */
     struct am_onesize pools[AM_EVENT_POOLS_NUM_MAX];
     /** the number of user defined event memory pools */
     int npools;
+    /** get the event cache of the calling task (optional) */
+    am_event_cache_fn get_cache;
+    /** the list of registered event caches */
+    struct am_event_cache* caches;
+    /**
+     * Minimum free memory blocks observed in each event pool,
+     * if am_event_alloc::get_cache is set.
+     * The free memory blocks kept in event caches are counted as free.
+     */
+    int nfree_min[AM_EVENT_POOLS_NUM_MAX];
+    /**
+     * Event size lookup table.
+     * The entry i holds the index plus one of the first event pool
+     * with memory blocks not smaller than i * AM_EVENT_SIZE_LUT_GRANULE + 1
+     * bytes. Zero means no such event pool.
+     */
+    uint8_t size_lut[AM_EVENT_SIZE_LUT_NUM];
+    /** statistics or NULL (see am_event_alloc_set_stats()) */
+    struct am_event_alloc_stats* stats;
 };
 
 /** enter critical section */
@@ -405,6 +545,16 @@ int am_event_get_ref_cnt(
  */
 void am_event_register_crit(void (*crit_enter)(void), void (*crit_exit)(void));
 
+/**
+ * Increment event reference counter without using critical section APIs.
+ *
+ * The function does nothing for statically allocated events -
+ * the events for which am_event_is_static() returns true.
+ *
+ * @param event  the event
+ */
+void am_event_inc_ref_cnt_unsafe(const struct am_event* event);
+
 /**
  * Free event without using critical section APIs.
  *
@@ -415,6 +565,54 @@ void am_event_free_unsafe(
     struct am_event_alloc* alloc, const struct am_event* event
 );
 
+/**
+ * Register event cache with event allocator.
+ *
+ * The event cache is owned by one task. The task allocates events from
+ * and frees events to its event cache without entering critical section.
+ * The event cache is refilled from and flushed to the event pools
+ * in batches of AM_EVENT_CACHE_SIZE / 2 memory blocks.
+ *
+ * The event allocator finds the event cache of the calling task
+ * with the callback set by am_event_alloc_set_cache_fn().
+ *
+ * The free memory blocks kept in the event cache of one task
+ * are not available to other tasks.
+ *
+ * Thread safe.
+ *
+ * @param alloc  the event allocator
+ * @param cache  the event cache to register
+ */
+void am_event_cache_init(
+    struct am_event_alloc* alloc, struct am_event_cache* cache
+);
+
+/**
+ * Return all free memory blocks of event cache to the event pools.
+ *
+ * Must be called by the task owning the event cache.
+ *
+ * @param alloc  the event allocator
+ * @param cache  the event cache to flush
+ */
+void am_event_cache_flush(
+    struct am_event_alloc* alloc, struct am_event_cache* cache
+);
+
+/**
+ * Flush event cache and unregister it from event allocator.
+ *
+ * Must be called by the task owning the event cache.
+ * The task must not use the event cache after the call.
+ *
+ * @param alloc  the event allocator
+ * @param cache  the event cache to unregister
+ */
+void am_event_cache_deinit(
+    struct am_event_alloc* alloc, struct am_event_cache* cache
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,9 +28,11 @@
  * Event pools API implementation.
  */
 
+#include <stdint.h>
 #include <string.h>
 
 #include "common/alignment.h"
+#include "common/compiler.h"
 #include "common/macros.h"
 #include "onesize/onesize.h"
 #include "event_common.h"
@@ -59,9 +61,29 @@ void am_event_alloc_add_pool(
         .block_size = block_size,
         .alignment = alignment
     };
-    am_onesize_init(&alloc->pools[alloc->npools], &cfg);
+    struct am_onesize* onesize = &alloc->pools[alloc->npools];
+    am_onesize_init(onesize, &cfg);
+    alloc->nfree_min[alloc->npools] = am_onesize_get_nblocks(onesize);
 
     ++alloc->npools;
+
+    /* map the event sizes not served by the previous pools to this pool */
+    unsigned max_size = (unsigned)am_onesize_get_block_size(onesize);
+    unsigned nlut = (max_size - 1U) / AM_EVENT_SIZE_LUT_GRANULE + 1U;
+    nlut = AM_MIN(nlut, (unsigned)AM_EVENT_SIZE_LUT_NUM);
+    for (unsigned i = 0; i < nlut; ++i) {
+        if (0 == alloc->size_lut[i]) {
+            alloc->size_lut[i] = (uint8_t)alloc->npools;
+        }
+    }
+}
+
+void am_event_alloc_set_cache_fn(
+    struct am_event_alloc* alloc, am_event_cache_fn fn
+) {
+    AM_ASSERT(alloc);
+
+    alloc->get_cache = fn;
 }
 
 int am_event_alloc_get_nfree_min(struct am_event_alloc* alloc, int index) {
@@ -69,18 +91,29 @@ int am_event_alloc_get_nfree_min(struct am_event_alloc* alloc, int index) {
     AM_ASSERT(index < alloc->npools);
 
     am_event_crit_enter();
-    int nfree = am_onesize_get_nfree_min(&alloc->pools[index]);
+    int nfree = alloc->get_cache
+                    ? alloc->nfree_min[index]
+                    : am_onesize_get_nfree_min(&alloc->pools[index]);
     am_event_crit_exit();
 
     return nfree;
 }
 
-int am_event_alloc_get_nfree(struct am_event_alloc* alloc, int index) {
+int am_event_alloc_get_nfree_unsafe(struct am_event_alloc* alloc, int index) {
     AM_ASSERT(index >= 0);
     AM_ASSERT(index < alloc->npools);
 
-    am_event_crit_enter();
     int nfree = am_onesize_get_nfree(&alloc->pools[index]);
+    for (const struct am_event_cache* c = alloc->caches; c; c = c->next) {
+        nfree += AM_ATOMIC_LOAD_N(&c->mags[index].nblocks);
+    }
+
+    return nfree;
+}
+
+int am_event_alloc_get_nfree(struct am_event_alloc* alloc, int index) {
+    am_event_crit_enter();
+    int nfree = am_event_alloc_get_nfree_unsafe(alloc, index);
     am_event_crit_exit();
 
     return nfree;
@@ -135,3 +168,212 @@ void am_event_alloc_log_unsafe(
         );
     }
 }
+
+void am_event_alloc_set_stats(
+    struct am_event_alloc* alloc, struct am_event_alloc_stats* stats
+) {
+    AM_ASSERT(alloc);
+    AM_ASSERT(stats);
+
+    memset(stats, 0, sizeof(*stats));
+    alloc->stats = stats;
+}
+
+void am_event_alloc_get_stats(
+    struct am_event_alloc* alloc, struct am_event_alloc_stats* stats
+) {
+    AM_ASSERT(alloc);
+    AM_ASSERT(alloc->stats);
+    AM_ASSERT(stats);
+
+    am_event_crit_enter();
+    *stats = *alloc->stats;
+    am_event_crit_exit();
+}
+
+void am_event_alloc_reset_stats(struct am_event_alloc* alloc) {
+    AM_ASSERT(alloc);
+    AM_ASSERT(alloc->stats);
+
+    am_event_crit_enter();
+    memset(alloc->stats, 0, sizeof(*alloc->stats));
+    am_event_crit_exit();
+}
+
+/** The fixed point scale of the event size demand */
+#define AM_EVENT_DEMAND_SCALE 1000U
+
+/** The max number of requested event sizes in am_event_alloc_advise() */
+#define AM_EVENT_DEMANDS_NUM_MAX (AM_EVENT_SIZE_LUT_NUM + 1)
+
+/* the requested event size indices fit am_event_alloc_advise() from[] */
+AM_ASSERT_STATIC(AM_EVENT_DEMANDS_NUM_MAX <= (UINT8_MAX + 1));
+
+/** The peak demand of memory blocks of one requested event size */
+struct am_event_size_demand {
+    /** the requested event size [bytes] */
+    int size;
+    /** the number of allocations of the requested event size */
+    uint32_t nallocs;
+    /** the peak busy memory blocks multiplied by AM_EVENT_DEMAND_SCALE */
+    uint64_t demand;
+};
+
+/**
+ * Find the index of the event pool serving the requested event size.
+ *
+ * @param alloc  the event allocator
+ * @param size   the requested event size [bytes]
+ *
+ * @return the event pool index
+ */
+static int am_event_alloc_get_pool_index(
+    const struct am_event_alloc* alloc, int size
+) {
+    for (int i = 0; i < alloc->npools; ++i) {
+        if (size <= am_onesize_get_block_size(&alloc->pools[i])) {
+            return i;
+        }
+    }
+    AM_ASSERT(0);
+    return -1;
+}
+
+/**
+ * Get the memory block size of proposed event pool.
+ *
+ * @param size   the biggest requested event size served by the event pool
+ * @param align  the memory block alignment [bytes]
+ *
+ * @return the memory block size [bytes]
+ */
+static int am_event_advice_get_block_size(int size, int align) {
+    int block_size = AM_MAX(size, (int)sizeof(struct am_slist_item));
+    return AM_ALIGN_SIZE(block_size, align);
+}
+
+/**
+ * Get the number of memory blocks of proposed event pool.
+ *
+ * @param demand  the demand of the event sizes served by the event pool
+ *
+ * @return the number of memory blocks
+ */
+static uint64_t am_event_advice_get_nblocks(uint64_t demand) {
+    uint64_t nblocks =
+        (demand + AM_EVENT_DEMAND_SCALE - 1U) / AM_EVENT_DEMAND_SCALE;
+    return AM_MAX(nblocks, 1U);
+}
+
+int am_event_alloc_advise(
+    struct am_event_alloc* alloc,
+    const struct am_event_alloc_stats* stats,
+    int alignment,
+    struct am_event_pool_advice advice[],
+    int npools_max
+) {
+    AM_ASSERT(alloc);
+    AM_ASSERT(alloc->npools > 0);
+    AM_ASSERT(stats);
+    AM_ASSERT(alignment >= 0);
+    AM_ASSERT(AM_IS_POW2((unsigned)alignment));
+    AM_ASSERT(advice);
+    AM_ASSERT(npools_max > 0);
+    AM_ASSERT(npools_max <= AM_EVENT_POOLS_NUM_MAX);
+
+    /* collect the requested event sizes in ascending order */
+    struct am_event_size_demand d[AM_EVENT_DEMANDS_NUM_MAX];
+    unsigned n = 0;
+    for (unsigned i = 0; i < AM_EVENT_SIZE_LUT_NUM; ++i) {
+        if (stats->nallocs[i]) {
+            d[n].size = (int)((i + 1U) * AM_EVENT_SIZE_LUT_GRANULE);
+            d[n].nallocs = stats->nallocs[i];
+            ++n;
+        }
+    }
+    if (stats->nallocs_big) {
+        d[n].size = (int)stats->size_max;
+        d[n].nallocs = stats->nallocs_big;
+        ++n;
+    }
+    if (0 == n) {
+        return 0;
+    }
+
+    /* split the peak busy memory blocks of event pools between event sizes */
+    uint32_t nallocs[AM_EVENT_POOLS_NUM_MAX] = {0};
+    for (unsigned i = 0; i < n; ++i) {
+        nallocs[am_event_alloc_get_pool_index(alloc, d[i].size)] +=
+            d[i].nallocs;
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        int pool = am_event_alloc_get_pool_index(alloc, d[i].size);
+        int nbusy_max = am_event_alloc_get_nblocks(alloc, pool) -
+                        am_event_alloc_get_nfree_min(alloc, pool);
+        d[i].demand = (uint64_t)nbusy_max * d[i].nallocs *
+                      AM_EVENT_DEMAND_SCALE / nallocs[pool];
+    }
+
+    /*
+     * Split the event sizes into at most npools_max groups of adjacent
+     * event sizes with minimum total memory with dynamic programming.
+     * cost[j] is the minimum memory of event pools serving
+     * the first j event sizes with m event pools.
+     * from[m][j] is the number of event sizes served by
+     * the first m - 1 event pools in this case.
+     */
+    int align = AM_MAX(alignment, AM_ALIGNOF(am_slist_item_t));
+    uint64_t cost[2][AM_EVENT_DEMANDS_NUM_MAX + 1];
+    uint8_t from[AM_EVENT_POOLS_NUM_MAX + 1][AM_EVENT_DEMANDS_NUM_MAX + 1];
+    uint64_t best = UINT64_MAX;
+    unsigned best_m = 0;
+    unsigned mmax = AM_MIN((unsigned)npools_max, n);
+    for (unsigned j = 0; j <= n; ++j) {
+        cost[0][j] = (0 == j) ? 0 : UINT64_MAX;
+    }
+    for (unsigned m = 1; m <= mmax; ++m) {
+        const uint64_t* prev = cost[(m - 1U) & 1U];
+        uint64_t* cur = cost[m & 1U];
+        for (unsigned j = 0; j <= n; ++j) {
+            cur[j] = UINT64_MAX;
+            uint64_t demand = 0;
+            int block_size =
+                (j > 0) ? am_event_advice_get_block_size(d[j - 1U].size, align)
+                        : 0;
+            /* k goes from j - 1 down to m - 1 */
+            for (unsigned k = j; k-- > (m - 1U);) {
+                demand += d[k].demand;
+                if (UINT64_MAX == prev[k]) {
+                    continue;
+                }
+                uint64_t nblocks = am_event_advice_get_nblocks(demand);
+                uint64_t c = prev[k] + nblocks * (uint64_t)block_size;
+                if (c < cur[j]) {
+                    cur[j] = c;
+                    from[m][j] = (uint8_t)k;
+                }
+            }
+        }
+        if (cur[n] < best) {
+            best = cur[n];
+            best_m = m;
+        }
+    }
+
+    /* collect the proposed event pools */
+    unsigned j = n;
+    for (unsigned m = best_m; m > 0; --m) {
+        unsigned k = from[m][j];
+        uint64_t demand = 0;
+        for (unsigned i = k; i < j; ++i) {
+            demand += d[i].demand;
+        }
+        advice[m - 1U].block_size =
+            am_event_advice_get_block_size(d[j - 1U].size, align);
+        advice[m - 1U].nblocks = (int)am_event_advice_get_nblocks(demand);
+        j = k;
+    }
+    AM_ASSERT(0 == j);
+
+    return (int)best_m;
+}
@@ -80,6 +80,25 @@ void am_event_alloc_add_pool(
  */
 int am_event_alloc_get_nfree_min(struct am_event_alloc* alloc, int index);
 
+/**
+ * Set the callback returning the event cache of the calling task.
+ *
+ * Enables per task event caches (see am_event_cache_init()).
+ * Must be called before the first event allocation.
+ *
+ * The free memory blocks kept in event caches are counted as free by
+ * am_event_alloc_get_nfree() and am_event_alloc_get_nfree_min().
+ * The event caches are only inspected, when they are refilled or flushed.
+ * So, the minimum number of free memory blocks might be higher than the
+ * exact one by up to AM_EVENT_CACHE_SIZE memory blocks per event cache.
+ *
+ * @param alloc  the event allocator
+ * @param fn     the callback
+ */
+void am_event_alloc_set_cache_fn(
+    struct am_event_alloc* alloc, am_event_cache_fn fn
+);
+
 /**
  * Get number of free memory blocks.
  *
@@ -94,6 +113,18 @@ int am_event_alloc_get_nfree_min(struct am_event_alloc* alloc, int index);
  */
 int am_event_alloc_get_nfree(struct am_event_alloc* alloc, int index);
 
+/**
+ * Get number of free memory blocks without using critical section APIs.
+ *
+ * Counts the free memory blocks kept in event caches as free.
+ *
+ * @param alloc  the event allocator
+ * @param index  memory pool index
+ *
+ * @return the number of free blocks available now in the memory pool
+ */
+int am_event_alloc_get_nfree_unsafe(struct am_event_alloc* alloc, int index);
+
 /**
  * The number of memory blocks in the pool with the given index.
  *
@@ -117,10 +148,89 @@ int am_event_alloc_get_nblocks(struct am_event_alloc* alloc, int index);
  */
 int am_event_alloc_get_num(const struct am_event_alloc* alloc);
 
+/**
+ * Set event allocator statistics.
+ *
+ * Then every event allocation updates @p stats with the requested
+ * event size and every failed event allocation updates @p stats
+ * with the event pool failed to serve it.
+ * Use am_event_alloc_get_stats() to take a snapshot of the statistics,
+ * am_event_alloc_reset_stats() to reset them and am_event_alloc_advise()
+ * to propose event pools for the recorded workload.
+ *
+ * Must be called before the first event allocation.
+ *
+ * @param alloc  the event allocator
+ * @param stats  the statistics storage
+ */
+void am_event_alloc_set_stats(
+    struct am_event_alloc* alloc, struct am_event_alloc_stats* stats
+);
+
+/**
+ * Take a snapshot of event allocator statistics.
+ *
+ * Thread safe.
+ *
+ * @param alloc  the event allocator
+ * @param stats  the snapshot is copied here
+ */
+void am_event_alloc_get_stats(
+    struct am_event_alloc* alloc, struct am_event_alloc_stats* stats
+);
+
+/**
+ * Reset event allocator statistics.
+ *
+ * Does not reset the minimum number of free memory blocks
+ * of event pools.
+ *
+ * Thread safe.
+ *
+ * @param alloc  the event allocator
+ */
+void am_event_alloc_reset_stats(struct am_event_alloc* alloc);
+
+/**
+ * Propose event pools for the workload recorded in event allocator statistics.
+ *
+ * The requested event sizes are taken from @p stats.
+ * The peak number of busy memory blocks of each event pool is taken
+ * from am_event_alloc_get_nfree_min() and is split between the requested
+ * event sizes served by the event pool proportionally to the number
+ * of their allocations. The proposed event pools minimize the total
+ * memory of event pools [bytes] with at most @p npools_max event pools.
+ *
+ * The workload should be recorded with no failed event allocations
+ * (see am_event_alloc_stats::nfailed). Otherwise the proposed number of
+ * memory blocks is too low for the event pools with failed allocations.
+ *
+ * Uses about AM_EVENT_POOLS_NUM_MAX * AM_EVENT_SIZE_LUT_NUM bytes of stack.
+ *
+ * Thread safe.
+ *
+ * @param alloc       the event allocator
+ * @param stats       the event allocator statistics snapshot
+ * @param alignment   the alignment of event pool memory blocks [bytes]
+ * @param advice      the proposed event pools sorted by block size
+ * @param npools_max  the max number of event pools to propose.
+ *                    The number of elements in @p advice.
+ *
+ * @return the number of proposed event pools in @p advice
+ */
+int am_event_alloc_advise(
+    struct am_event_alloc* alloc,
+    const struct am_event_alloc_stats* stats,
+    int alignment,
+    struct am_event_pool_advice advice[],
+    int npools_max
+);
+
 /**
  * Log events content of the first @p num events in each event pool.
  *
  * To be used for debugging purposes.
+ * The free memory blocks kept in event caches are logged as events.
  *
  * Thread usafe.
  *
@@ -32,8 +32,10 @@
 #include <string.h>
 #include <stdint.h>
 
+#include "common/compiler.h"
 #include "common/types.h"
 #include "common/macros.h"
+#include "bit/bit.h"
 
 #include "event_common.h"
 #include "event_queue.h"
@@ -52,11 +54,309 @@ void am_event_queue_init(
 
     queue->events = events;
     queue->capacity = nevents;
+    queue->mask = (nevents & (nevents - 1)) ? -1 : (nevents - 1);
     queue->nfree = queue->nfree_min = queue->capacity;
     queue->init_called = true;
     queue->alloc = alloc;
 }
 
+/**
+ * Get the event queue slot index following the given one.
+ *
+ * @param queue  the event queue
+ * @param ind    the slot index
+ *
+ * @return the next slot index
+ */
+static int am_event_queue_next(
+    const struct am_event_queue* queue, int ind
+) {
+    if (queue->mask >= 0) {
+        return (ind + 1) & queue->mask;
+    }
+    return (ind + 1) % queue->capacity;
+}
+
+void am_event_queue_set_mpsc(struct am_event_queue* queue) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->init_called);
+    AM_ASSERT(am_event_queue_is_empty_unsafe(queue));
+    AM_ASSERT(!queue->lanes);
+
+    /* free slots are marked with NULL in MPSC mode */
+    for (int i = 0; i < queue->capacity; ++i) {
+        queue->events[i] = NULL;
+    }
+    queue->rd = queue->wr = 0;
+    queue->stalled = 0;
+    queue->mpsc = true;
+}
+
+void am_event_queue_set_stamps(
+    struct am_event_queue* queue,
+    uint32_t stamps[],
+    int nstamps,
+    uint32_t (*get_time)(void)
+) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->init_called);
+    AM_ASSERT(am_event_queue_is_empty_unsafe(queue));
+    AM_ASSERT(stamps);
+    AM_ASSERT(nstamps == queue->capacity);
+    AM_ASSERT(get_time);
+
+    queue->stamps = stamps;
+    queue->get_time = get_time;
+    queue->stamp = 0;
+}
+
+uint32_t am_event_queue_get_stamp_unsafe(const struct am_event_queue* queue) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->stamps);
+    return queue->stamp;
+}
+
+void am_event_queue_set_lanes(
+    struct am_event_queue* queue,
+    struct am_event_queue_lane lanes[],
+    const int nevents[],
+    int nlanes
+) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->init_called);
+    AM_ASSERT(!queue->mpsc);
+    AM_ASSERT(am_event_queue_is_empty_unsafe(queue));
+    AM_ASSERT(lanes);
+    AM_ASSERT(nevents);
+    AM_ASSERT(nlanes > 0);
+    AM_ASSERT(nlanes <= AM_EVENT_QUEUE_LANES_MAX);
+
+    int offset = 0;
+    for (int i = 0; i < nlanes; ++i) {
+        AM_ASSERT(nevents[i] > 0);
+        lanes[i] = (struct am_event_queue_lane){
+            .offset = offset, .capacity = nevents[i], .nfree_min = nevents[i]
+        };
+        offset += nevents[i];
+    }
+    AM_ASSERT(offset == queue->capacity);
+
+    queue->lanes = lanes;
+    queue->nlanes = nlanes;
+    queue->lanes_busy = 0;
+}
+
+int am_event_queue_get_lane_nfree_unsafe(
+    const struct am_event_queue* queue, int lane
+) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->init_called);
+    AM_ASSERT(lane >= 0);
+
+    if (!queue->lanes) {
+        return queue->capacity - am_event_queue_get_nbusy_unsafe(queue);
+    }
+    const struct am_event_queue_lane* l =
+        &queue->lanes[AM_MIN(lane, queue->nlanes - 1)];
+
+    return l->capacity - l->nbusy;
+}
+
+int am_event_queue_get_lane_nfree_min(
+    const struct am_event_queue* queue, int lane
+) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->init_called);
+    AM_ASSERT(queue->lanes);
+    AM_ASSERT(lane >= 0);
+    AM_ASSERT(lane < queue->nlanes);
+
+    am_event_crit_enter();
+    int min = queue->lanes[lane].nfree_min;
+    am_event_crit_exit();
+
+    return min;
+}
+
+/**
+ * Peek the event at the front of MPSC event queue.
+ *
+ * Called by the queue consumer only.
+ *
+ * If the queue is not empty, but the push of the front event is
+ * not complete yet, then marks the consumer as stalled.
+ * The producer completing the push then reports the queue as empty
+ * to make sure the consumer gets notified.
+ *
+ * @param queue  the event queue
+ * @param rd     the read index of the front event is returned here
+ *
+ * @return the front event or NULL
+ */
+static const struct am_event* am_event_queue_mpsc_front(
+    struct am_event_queue* queue, int* rd
+) {
+    *rd = AM_ATOMIC_LOAD_N(&queue->rd);
+    const struct am_event* event = AM_ATOMIC_LOAD_N(&queue->events[*rd]);
+    if (event) {
+        return event;
+    }
+    if (AM_ATOMIC_LOAD_N(&queue->nfree) == queue->capacity) {
+        return NULL;
+    }
+    AM_ATOMIC_STORE_N(&queue->stalled, 1);
+
+    /* the push might have completed before the consumer was marked stalled */
+    *rd = AM_ATOMIC_LOAD_N(&queue->rd);
+    return AM_ATOMIC_LOAD_N(&queue->events[*rd]);
+}
+
+/**
+ * Pop event from the front of MPSC event queue.
+ *
+ * Called by the queue consumer only.
+ *
+ * @param queue  the event queue
+ *
+ * @return the popped event or NULL
+ */
+static const struct am_event* am_event_queue_mpsc_pop(
+    struct am_event_queue* queue
+) {
+    for (;;) {
+        int rd = 0;
+        const struct am_event* event = am_event_queue_mpsc_front(queue, &rd);
+        if (!event) {
+            return NULL;
+        }
+        /*
+         * The slot is released before the read index is moved forward.
+         * LIFO push might move the read index backward meanwhile.
+         * If so, the slot is restored and the pop is retried.
+         */
+        /* the slot time stamp is valid, while the slot is not released */
+        uint32_t stamp = queue->stamps ? queue->stamps[rd] : 0;
+        AM_ATOMIC_STORE_N(&queue->events[rd], NULL);
+        int expected = rd;
+        int next = am_event_queue_next(queue, rd);
+        if (AM_ATOMIC_COMPARE_EXCHANGE_N(&queue->rd, &expected, next)) {
+            queue->stamp = stamp;
+            AM_ATOMIC_FETCH_ADD(&queue->nfree, 1);
+            return event;
+        }
+        AM_ATOMIC_STORE_N(&queue->events[rd], event);
+    }
+}
+
+/**
+ * Reserve free slots in MPSC event queue.
+ *
+ * @param queue        the event queue
+ * @param margin       the number of free slots, which must remain
+ *                     in the queue after the reservation
+ * @param n            the number of slots to reserve.
+ *                     The number of reserved slots is returned here.
+ * @param all_or_none  reserve either all @p n slots or none of them
+ *
+ * @return the number of free slots before the reservation or
+ *         0, if no slots were reserved
+ */
+static int am_event_queue_mpsc_reserve_many(
+    struct am_event_queue* queue, int margin, int* n, bool all_or_none
+) {
+    int nfree = AM_ATOMIC_LOAD_N(&queue->nfree);
+    int nres = 0;
+    do {
+        /* no subtraction before the check to avoid signed overflow */
+        nres = (nfree > margin) ? AM_MIN(*n, nfree - margin) : 0;
+        if ((nres <= 0) || (all_or_none && (nres < *n))) {
+            *n = 0;
+            return 0;
+        }
+    } while (
+        !AM_ATOMIC_COMPARE_EXCHANGE_N(&queue->nfree, &nfree, nfree - nres)
+    );
+
+    int min = AM_ATOMIC_LOAD_N(&queue->nfree_min);
+    while ((nfree - nres) < min) {
+        if (AM_ATOMIC_COMPARE_EXCHANGE_N(
+                &queue->nfree_min, &min, nfree - nres
+            )) {
+            break;
+        }
+    }
+    *n = nres;
+    return nfree;
+}
+
+/**
+ * Reserve one free slot in MPSC event queue.
+ *
+ * @param queue   the event queue
+ * @param margin  the number of free slots, which must remain
+ *                in the queue after the reservation
+ *
+ * @return the number of free slots before the reservation or
+ *         0, if the slot was not reserved
+ */
+static int am_event_queue_mpsc_reserve(
+    struct am_event_queue* queue, int margin
+) {
+    int n = 1;
+    return am_event_queue_mpsc_reserve_many(
+        queue, margin, &n, /*all_or_none=*/true
+    );
+}
+
+/**
+ * Place event to the reserved slot of MPSC event queue.
+ *
+ * @param queue  the event queue
+ * @param event  the event to place
+ * @param lifo   place the event to the front of the queue, if true
+ * @param nfree  the number of free slots before the reservation
+ *
+ * @retval #AM_RC_OK               the event was placed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the event was placed, the queue was
+ *                                 empty or the consumer was stalled
+ */
+static enum am_rc am_event_queue_mpsc_commit(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    bool lifo,
+    int nfree
+) {
+    int ind = 0;
+    if (lifo) {
+        int rd = AM_ATOMIC_LOAD_N(&queue->rd);
+        do {
+            ind = rd ? (rd - 1) : (queue->capacity - 1);
+        } while (!AM_ATOMIC_COMPARE_EXCHANGE_N(&queue->rd, &rd, ind));
+    } else {
+        ind = AM_ATOMIC_LOAD_N(&queue->wr);
+        int next = 0;
+        do {
+            next = am_event_queue_next(queue, ind);
+        } while (!AM_ATOMIC_COMPARE_EXCHANGE_N(&queue->wr, &ind, next));
+    }
+    AM_ASSERT(NULL == AM_ATOMIC_LOAD_N(&queue->events[ind]));
+    if (queue->stamps) {
+        /* published to the consumer by the event store below */
+        queue->stamps[ind] = queue->get_time();
+    }
+    AM_ATOMIC_STORE_N(&queue->events[ind], event);
+
+    bool was_empty = queue->capacity == nfree;
+    if (AM_ATOMIC_LOAD_N(&queue->stalled) &&
+        AM_ATOMIC_EXCHANGE_N(&queue->stalled, 0)) {
+        was_empty = true;
+    }
+    if (was_empty) {
+        return AM_RC_QUEUE_WAS_EMPTY;
+    }
+    return AM_RC_OK;
+}
+
 void am_event_queue_deinit(struct am_event_queue* queue) {
     AM_ASSERT(queue);
     AM_ASSERT(am_event_queue_is_empty_unsafe(queue));
@@ -70,6 +370,22 @@ bool am_event_queue_is_valid(const struct am_event_queue* queue) {
 bool am_event_queue_is_empty_unsafe(const struct am_event_queue* queue) {
     AM_ASSERT(queue);
     AM_ASSERT(queue->init_called);
+    if (queue->mpsc) {
+        /*
+         * No am_event_queue_mpsc_front() call here: it marks
+         * the consumer as stalled. The stalled state is only set
+         * by the pop of the consumer.
+         */
+        int rd = AM_ATOMIC_LOAD_N(&queue->rd);
+        if (AM_ATOMIC_LOAD_N(&queue->events[rd])) {
+            return false;
+        }
+        /* a push in progress makes the queue non-empty */
+        return AM_ATOMIC_LOAD_N(&queue->nfree) == queue->capacity;
+    }
+    if (queue->lanes) {
+        return !queue->lanes_busy;
+    }
     return (queue->rd == queue->wr) && !queue->full;
 }
 
@@ -77,6 +393,10 @@ bool am_event_queue_is_empty(const struct am_event_queue* queue) {
     AM_ASSERT(queue);
     AM_ASSERT(queue->init_called);
 
+    if (queue->mpsc) {
+        return am_event_queue_is_empty_unsafe(queue);
+    }
+
     am_event_crit_enter();
     bool empty = am_event_queue_is_empty_unsafe(queue);
     am_event_crit_exit();
@@ -87,6 +407,9 @@ bool am_event_queue_is_empty(const struct am_event_queue* queue) {
 int am_event_queue_get_nbusy_unsafe(const struct am_event_queue* queue) {
     AM_ASSERT(queue);
     AM_ASSERT(queue->init_called);
+    if (queue->mpsc) {
+        return queue->capacity - AM_ATOMIC_LOAD_N(&queue->nfree);
+    }
     return queue->capacity - queue->nfree;
 }
 
@@ -96,17 +419,56 @@ int am_event_queue_get_capacity(const struct am_event_queue* queue) {
     return queue->capacity;
 }
 
+/**
+ * Pop event from the highest non-empty lane of event queue.
+ *
+ * @param queue  the event queue with lanes
+ *
+ * @return the popped event or NULL, if the queue is empty
+ */
+static const struct am_event* am_event_queue_lanes_pop_unsafe(
+    struct am_event_queue* queue
+) {
+    if (!queue->lanes_busy) {
+        return NULL;
+    }
+    const int ilane = am_bit_u8_msb(queue->lanes_busy);
+    struct am_event_queue_lane* lane = &queue->lanes[ilane];
+
+    const int ind = lane->offset + lane->rd;
+    const struct am_event* event = queue->events[ind];
+    if (queue->stamps) {
+        queue->stamp = queue->stamps[ind];
+    }
+    lane->rd = (lane->rd + 1) % lane->capacity;
+    if (0 == --lane->nbusy) {
+        queue->lanes_busy = (uint8_t)(queue->lanes_busy & ~(1U << ilane));
+    }
+    ++queue->nfree;
+
+    return event;
+}
+
 const struct am_event* am_event_queue_pop_front_unsafe(
     struct am_event_queue* queue
 ) {
     AM_ASSERT(queue);
     AM_ASSERT(queue->init_called);
 
+    if (queue->mpsc) {
+        return am_event_queue_mpsc_pop(queue);
+    }
+    if (queue->lanes) {
+        return am_event_queue_lanes_pop_unsafe(queue);
+    }
     if (am_event_queue_is_empty_unsafe(queue)) {
         return NULL;
     }
     const struct am_event* event = queue->events[queue->rd];
-    queue->rd = (queue->rd + 1) % queue->capacity;
+    if (queue->stamps) {
+        queue->stamp = queue->stamps[queue->rd];
+    }
+    queue->rd = am_event_queue_next(queue, queue->rd);
     queue->full = 0;
     ++queue->nfree;
 
@@ -117,6 +479,10 @@ const struct am_event* am_event_queue_pop_front(struct am_event_queue* queue) {
     AM_ASSERT(queue);
     AM_ASSERT(queue->init_called);
 
+    if (queue->mpsc) {
+        return am_event_queue_mpsc_pop(queue);
+    }
+
     am_event_crit_enter();
     const struct am_event* event = am_event_queue_pop_front_unsafe(queue);
     am_event_crit_exit();
@@ -128,6 +494,10 @@ int am_event_queue_get_nfree_min(const struct am_event_queue* queue) {
     AM_ASSERT(queue);
     AM_ASSERT(queue->init_called);
 
+    if (queue->mpsc) {
+        return AM_ATOMIC_LOAD_N(&queue->nfree_min);
+    }
+
     am_event_crit_enter();
     int min = queue->nfree_min;
     am_event_crit_exit();
@@ -148,20 +518,15 @@ enum am_rc am_event_queue_push_front(
     return am_event_queue_push(queue, event, policy);
 }
 
-enum am_rc am_event_queue_push(
-    struct am_event_queue* queue,
-    const struct am_event* event,
-    struct am_event_queue_policy policy
-) {
-    am_event_crit_enter();
-    enum am_rc rc = am_event_queue_push_unsafe(queue, event, policy);
-    am_event_crit_exit();
-
-    return rc;
-}
-
-enum am_rc am_event_queue_push_unsafe(
-    struct am_event_queue* queue,
+/**
+ * Check event queue push arguments.
+ *
+ * @param queue   the event queue
+ * @param event   the event to push
+ * @param policy  the event queue handling policy
+ */
+static void am_event_queue_push_check(
+    const struct am_event_queue* queue,
     const struct am_event* event,
     struct am_event_queue_policy policy
 ) {
@@ -181,30 +546,230 @@ enum am_rc am_event_queue_push_unsafe(
             ((uint32_t)event->id & AM_EVENT_ID_LSW_MASK) == event->id_lsw
         );
     }
+}
+
+/**
+ * Replace the queued event with the same ID as @p event.
+ *
+ * The replaced event is freed. The time stamp of the replaced event
+ * is retained, so the queueing delay is counted from the moment
+ * the first event of the coalesced series was queued.
+ *
+ * @param queue  the event queue
+ * @param ring   the queued events to search
+ * @param event  the event to replace the queued event with
+ * @param move   the caller event reference is moved to the queue
+ *
+ * @retval true   the queued event was replaced
+ * @retval false  no event with the same ID is queued
+ */
+static bool am_event_queue_coalesce_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event_queue_lane* ring,
+    const struct am_event* event,
+    bool move
+) {
+    for (int i = 0, ind = ring->rd; i < ring->nbusy; ++i) {
+        const struct am_event** queued = &queue->events[ring->offset + ind];
+        if ((*queued)->id == event->id) {
+            if (!move) {
+                am_event_inc_ref_cnt_unsafe(event);
+            }
+            const struct am_event* replaced = *queued;
+            *queued = event;
+            am_event_free_unsafe(queue->alloc, replaced);
+            return true;
+        }
+        ind = (ind + 1) % ring->capacity;
+    }
+    return false;
+}
 
-    struct am_event* e = AM_CAST(struct am_event*, event);
+/**
+ * Reject event push.
+ *
+ * Frees the event unless the caller keeps the event reference.
+ *
+ * @param queue   the event queue
+ * @param event   the rejected event
+ * @param policy  the event queue handling policy
+ * @param move    the caller event reference was to be moved to the queue
+ *
+ * @return #AM_RC_ERR
+ */
+static enum am_rc am_event_queue_reject_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy,
+    bool move
+) {
+    if (move) {
+        return AM_RC_ERR; /* the caller keeps the event reference */
+    }
+    am_event_free_unsafe(queue->alloc, event);
 
-    if (queue->nfree <= policy.margin) {
-        am_event_free_unsafe(queue->alloc, event);
+    AM_ASSERT(policy.margin > 0);
 
-        AM_ASSERT(policy.margin > 0);
+    return AM_RC_ERR;
+}
 
-        return AM_RC_ERR;
+/**
+ * Push event to event queue with lanes.
+ *
+ * @param queue   the event queue
+ * @param event   the event to push
+ * @param policy  the event queue handling policy
+ * @param move    the caller event reference is moved to the queue
+ *
+ * @retval #AM_RC_OK               the event was pushed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the event was pushed, queue was empty
+ * @retval #AM_RC_ERR              the event was not pushed
+ */
+static enum am_rc am_event_queue_lanes_push_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy,
+    bool move
+) {
+    AM_ASSERT(policy.lane >= 0);
+
+    const int ilane = AM_MIN(policy.lane, queue->nlanes - 1);
+    struct am_event_queue_lane* lane = &queue->lanes[ilane];
+
+    if (policy.coalesce &&
+        am_event_queue_coalesce_unsafe(queue, lane, event, move)) {
+        return AM_RC_OK;
+    }
+    if ((lane->capacity - lane->nbusy) <= policy.margin) {
+        return am_event_queue_reject_unsafe(queue, event, policy, move);
+    }
+    if (!move) {
+        am_event_inc_ref_cnt_unsafe(event);
+    }
+
+    int ind = 0;
+    if (policy.lifo) {
+        lane->rd = lane->rd ? (lane->rd - 1) : (lane->capacity - 1);
+        ind = lane->rd;
+    } else {
+        ind = (lane->rd + lane->nbusy) % lane->capacity;
+    }
+    ind += lane->offset;
+    queue->events[ind] = event;
+    if (queue->stamps) {
+        queue->stamps[ind] = queue->get_time();
+    }
+    ++lane->nbusy;
+    lane->nfree_min = AM_MIN(lane->capacity - lane->nbusy, lane->nfree_min);
+    queue->lanes_busy = (uint8_t)(queue->lanes_busy | (1U << ilane));
+
+    bool was_empty = queue->capacity == queue->nfree;
+
+    --queue->nfree;
+    queue->nfree_min = AM_MIN(queue->nfree, queue->nfree_min);
+
+    return was_empty ? AM_RC_QUEUE_WAS_EMPTY : AM_RC_OK;
+}
+
+enum am_rc am_event_queue_push(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+) {
+    AM_ASSERT(queue);
+
+    if (queue->mpsc) {
+        am_event_queue_push_check(queue, event, policy);
+        AM_ASSERT(!policy.coalesce);
+
+        int nfree = am_event_queue_mpsc_reserve(queue, policy.margin);
+        if (!nfree) {
+            am_event_free(queue->alloc, event);
+
+            AM_ASSERT(policy.margin > 0);
+
+            return AM_RC_ERR;
+        }
+        am_event_inc_ref_cnt(event);
+
+        return am_event_queue_mpsc_commit(queue, event, policy.lifo, nfree);
+    }
+
+    am_event_crit_enter();
+    enum am_rc rc = am_event_queue_push_unsafe(queue, event, policy);
+    am_event_crit_exit();
+
+    return rc;
+}
+
+/**
+ * Push event to event queue.
+ *
+ * @param queue   the event queue
+ * @param event   the event to push
+ * @param policy  the event queue handling policy
+ * @param move    the caller event reference is moved to the queue
+ *
+ * @retval #AM_RC_OK               the event was pushed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the event was pushed, queue was empty
+ * @retval #AM_RC_ERR              the event was not pushed
+ */
+static enum am_rc am_event_queue_push_x_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy,
+    bool move
+) {
+    am_event_queue_push_check(queue, event, policy);
+
+    if (queue->mpsc) {
+        AM_ASSERT(!policy.coalesce);
+        int nfree = am_event_queue_mpsc_reserve(queue, policy.margin);
+        if (!nfree) {
+            return am_event_queue_reject_unsafe(queue, event, policy, move);
+        }
+        if (!move) {
+            am_event_inc_ref_cnt_unsafe(event);
+        }
+        return am_event_queue_mpsc_commit(queue, event, policy.lifo, nfree);
+    }
+
+    if (queue->lanes) {
+        return am_event_queue_lanes_push_unsafe(queue, event, policy, move);
+    }
+
+    if (policy.coalesce) {
+        const struct am_event_queue_lane ring = {
+            .capacity = queue->capacity,
+            .rd = queue->rd,
+            .nbusy = queue->capacity - queue->nfree
+        };
+        if (am_event_queue_coalesce_unsafe(queue, &ring, event, move)) {
+            return AM_RC_OK;
+        }
+    }
+
+    if (queue->nfree <= policy.margin) {
+        return am_event_queue_reject_unsafe(queue, event, policy, move);
     }
     AM_ASSERT(queue->nfree > 0);
     AM_ASSERT(!queue->full);
 
-    if (!am_event_is_static(e)) {
-        AM_ASSERT(e->ref_counter < AM_EVENT_REF_COUNTER_MAX);
-        ++e->ref_counter;
+    if (!move) {
+        am_event_inc_ref_cnt_unsafe(event);
     }
 
+    int ind = 0;
     if (policy.lifo) {
         queue->rd = queue->rd ? (queue->rd - 1) : (queue->capacity - 1);
-        queue->events[queue->rd] = event;
+        ind = queue->rd;
     } else {
-        queue->events[queue->wr] = event;
-        queue->wr = (queue->wr + 1) % queue->capacity;
+        ind = queue->wr;
+        queue->wr = am_event_queue_next(queue, queue->wr);
+    }
+    queue->events[ind] = event;
+    if (queue->stamps) {
+        queue->stamps[ind] = queue->get_time();
     }
     if (queue->wr == queue->rd) {
         queue->full = 1;
@@ -221,6 +786,200 @@ enum am_rc am_event_queue_push_unsafe(
     return AM_RC_OK;
 }
 
+enum am_rc am_event_queue_push_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+) {
+    return am_event_queue_push_x_unsafe(queue, event, policy, /*move=*/false);
+}
+
+enum am_rc am_event_queue_push_move_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+) {
+    return am_event_queue_push_x_unsafe(queue, event, policy, /*move=*/true);
+}
+
+/**
+ * Check event queue bulk push arguments.
+ *
+ * @param queue    the event queue
+ * @param events   the events to push
+ * @param nevents  the number of events in @p events
+ * @param policy   the event queue handling policy
+ */
+static void am_event_queue_push_many_check(
+    const struct am_event_queue* queue,
+    const struct am_event* events[],
+    int nevents,
+    struct am_event_queue_policy policy
+) {
+    AM_ASSERT(queue);
+    AM_ASSERT(events);
+    AM_ASSERT(nevents > 0);
+    AM_ASSERT(!policy.coalesce);
+    for (int i = 0; i < nevents; ++i) {
+        am_event_queue_push_check(queue, events[i], policy);
+    }
+}
+
+/**
+ * Push events to MPSC event queue.
+ *
+ * @param queue    the event queue
+ * @param events   the events to push
+ * @param nevents  the number of events in @p events
+ * @param policy   the event queue handling policy
+ * @param npushed  the number of pushed events is returned here
+ * @param crit     enter critical section to update event reference counters
+ *
+ * @retval #AM_RC_OK               the events were pushed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the events were pushed, queue was empty
+ * @retval #AM_RC_ERR              no events were pushed
+ */
+static enum am_rc am_event_queue_mpsc_push_many(
+    struct am_event_queue* queue,
+    const struct am_event* events[],
+    int nevents,
+    struct am_event_queue_policy policy,
+    int* npushed,
+    bool crit
+) {
+    int n = nevents;
+    int nfree = am_event_queue_mpsc_reserve_many(
+        queue, policy.margin, &n, policy.all_or_none
+    );
+    bool was_empty = false;
+    for (int i = 0; i < n; ++i) {
+        /* LIFO pushes start from the last event to keep the events order */
+        const struct am_event* e = events[policy.lifo ? (n - 1 - i) : i];
+        if (crit) {
+            am_event_inc_ref_cnt(e);
+        } else {
+            am_event_inc_ref_cnt_unsafe(e);
+        }
+        enum am_rc rc =
+            am_event_queue_mpsc_commit(queue, e, policy.lifo, nfree - i);
+        was_empty = was_empty || (AM_RC_QUEUE_WAS_EMPTY == rc);
+    }
+    for (int i = n; i < nevents; ++i) {
+        if (crit) {
+            am_event_free(queue->alloc, events[i]);
+        } else {
+            am_event_free_unsafe(queue->alloc, events[i]);
+        }
+    }
+    *npushed = n;
+
+    AM_ASSERT((n == nevents) || (policy.margin > 0));
+
+    if (!n) {
+        return AM_RC_ERR;
+    }
+    return was_empty ? AM_RC_QUEUE_WAS_EMPTY : AM_RC_OK;
+}
+
+enum am_rc am_event_queue_push_many_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* events[],
+    int nevents,
+    struct am_event_queue_policy policy,
+    int* npushed
+) {
+    am_event_queue_push_many_check(queue, events, nevents, policy);
+
+    int n = 0;
+    if (!npushed) {
+        npushed = &n;
+    }
+    if (queue->mpsc) {
+        return am_event_queue_mpsc_push_many(
+            queue, events, nevents, policy, npushed, /*crit=*/false
+        );
+    }
+    int nfree = am_event_queue_get_lane_nfree_unsafe(queue, policy.lane);
+    n = AM_MAX(0, AM_MIN(nevents, nfree - policy.margin));
+    if (policy.all_or_none && (n < nevents)) {
+        n = 0;
+    }
+    bool was_empty = false;
+    for (int i = 0; i < n; ++i) {
+        /* LIFO pushes start from the last event to keep the events order */
+        const struct am_event* e = events[policy.lifo ? (n - 1 - i) : i];
+        enum am_rc rc =
+            am_event_queue_push_x_unsafe(queue, e, policy, /*move=*/false);
+        AM_ASSERT(AM_RC_ERR != rc);
+        was_empty = was_empty || (AM_RC_QUEUE_WAS_EMPTY == rc);
+    }
+    for (int i = n; i < nevents; ++i) {
+        am_event_free_unsafe(queue->alloc, events[i]);
+    }
+    *npushed = n;
+
+    AM_ASSERT((n == nevents) || (policy.margin > 0));
+
+    if (!n) {
+        return AM_RC_ERR;
+    }
+    return was_empty ? AM_RC_QUEUE_WAS_EMPTY : AM_RC_OK;
+}
+
+enum am_rc am_event_queue_push_many(
+    struct am_event_queue* queue,
+    const struct am_event* events[],
+    int nevents,
+    struct am_event_queue_policy policy,
+    int* npushed
+) {
+    AM_ASSERT(queue);
+
+    if (queue->mpsc) {
+        am_event_queue_push_many_check(queue, events, nevents, policy);
+        int n = 0;
+        return am_event_queue_mpsc_push_many(
+            queue, events, nevents, policy, npushed ? npushed : &n,
+            /*crit=*/true
+        );
+    }
+
+    am_event_crit_enter();
+    enum am_rc rc = am_event_queue_push_many_unsafe(
+        queue, events, nevents, policy, npushed
+    );
+    am_event_crit_exit();
+
+    return rc;
+}
+
+int am_event_queue_pop_many(
+    struct am_event_queue* queue, const struct am_event* events[], int nevents
+) {
+    AM_ASSERT(queue);
+    AM_ASSERT(queue->init_called);
+    AM_ASSERT(events);
+    AM_ASSERT(nevents > 0);
+
+    int n = 0;
+    if (queue->mpsc) {
+        while ((n < nevents) &&
+               ((events[n] = am_event_queue_mpsc_pop(queue)) != NULL)) {
+            ++n;
+        }
+        return n;
+    }
+
+    am_event_crit_enter();
+    while ((n < nevents) &&
+           ((events[n] = am_event_queue_pop_front_unsafe(queue)) != NULL)) {
+        ++n;
+    }
+    am_event_crit_exit();
+
+    return n;
+}
+
 enum am_rc am_event_queue_pop_front_with_cb(
     struct am_event_queue* queue, am_event_handler_fn cb, void* ctx
 ) {
@@ -231,6 +990,8 @@ enum am_rc am_event_queue_pop_front_with_cb(
         return AM_RC_ERR;
     }
     const int id = event->id;
+    /* the callback might deinitialize the queue */
+    struct am_event_alloc* alloc = queue->alloc;
 
     if (cb) {
         cb(ctx, event);
@@ -255,7 +1016,7 @@ enum am_rc am_event_queue_pop_front_with_cb(
         return AM_RC_OK;
     }
 
-    am_event_free(queue->alloc, event);
+    am_event_free(alloc, event);
 
     return AM_RC_OK;
 }
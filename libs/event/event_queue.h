@@ -34,24 +34,108 @@
 #define AM_EVENT_QUEUE_H_INCLUDED
 
 #include <stdbool.h>
+#include <stdint.h>
 
+#include "common/compiler.h"
 #include "common/types.h"
 #include "event_common.h"
 
-/** Event queue handler. */
-struct am_event_queue {
-    int rd;        /**< read index */
-    int wr;        /**< write index */
-    int nfree;     /**< number of free slots */
+/** The maximum number of event queue lanes (see am_event_queue_set_lanes()) */
+#define AM_EVENT_QUEUE_LANES_MAX 8
+
+/** Event queue lane (see am_event_queue_set_lanes()). */
+struct am_event_queue_lane {
+    int offset;    /**< the first event queue slot of the lane */
+    int capacity;  /**< lane capacity */
+    int rd;        /**< read index relative to the first slot */
+    int nbusy;     /**< number of busy slots */
     int nfree_min; /**< minimum number of free slots observed so far */
-    int capacity;  /**< queue capacity [number of items of isize] */
+};
+
+#ifndef AM_EVENT_QUEUE_CACHE_LINE_SIZE
+/**
+ * Cache line size [bytes] for event queue layout.
+ *
+ * If not 0, then the read mostly fields, the read index and
+ * the write index are placed to different cache lines. So, the pops
+ * do not invalidate the write index of the producers and the FIFO
+ * pushes do not invalidate the read index of the consumer.
+ * The free slots counter, the full flag and the stalled consumer flag
+ * share the cache line of the write index, but are also written by
+ * the consumer. So, the false sharing between the consumer and
+ * producers running on different CPU cores is reduced, not avoided.
+ * The LIFO pushes also write the read index.
+ * Costs a larger event queue handler. 0 keeps the handler compact.
+ */
+#define AM_EVENT_QUEUE_CACHE_LINE_SIZE 0
+#endif
+
+#if AM_EVENT_QUEUE_CACHE_LINE_SIZE > 0
+/** Place event queue field to the beginning of a cache line */
+#define AM_EVENT_QUEUE_CACHE_LINE_ALIGNED \
+    AM_ALIGNED(AM_EVENT_QUEUE_CACHE_LINE_SIZE)
+#else
+/** Place event queue field to the beginning of a cache line */
+#define AM_EVENT_QUEUE_CACHE_LINE_ALIGNED
+#endif
+
+/**
+ * Event queue handler.
+ *
+ * The fields are grouped into read mostly fields, the read index group
+ * and the write index group (see AM_EVENT_QUEUE_CACHE_LINE_SIZE).
+ */
+struct am_event_queue {
+    int capacity; /**< queue capacity [number of items of isize] */
+    /**
+     * capacity - 1, if the capacity is power of two, or -1 otherwise.
+     * Power of two capacity queues wrap indices with the mask instead of
+     * the more expensive division.
+     */
+    int mask;
     const struct am_event** events; /**< event queue */
 
     struct am_event_alloc* alloc; /**< the event allocator */
 
-    unsigned full : 1; /**< queue is full */
+    /** push time stamps of queued events or NULL */
+    uint32_t* stamps;
+    /** time source of push time stamps */
+    uint32_t (*get_time)(void);
+
+    /** event queue lanes or NULL (see am_event_queue_set_lanes()) */
+    struct am_event_queue_lane* lanes;
+    /** the number of event queue lanes */
+    int nlanes;
+
+    /**
+     * Lock-free multi-producer single-consumer mode.
+     * Not a bit field as it is read outside of critical section.
+     */
+    bool mpsc;
     /** safety net to catch missing am_event_queue_init() call */
     unsigned init_called : 1;
+
+    /** read index */
+    int rd AM_EVENT_QUEUE_CACHE_LINE_ALIGNED;
+    /** push time stamp of the event popped last */
+    uint32_t stamp;
+    /** bitmask of non-empty event queue lanes */
+    uint8_t lanes_busy;
+
+    /** write index */
+    int wr AM_EVENT_QUEUE_CACHE_LINE_ALIGNED;
+    /**
+     * Number of free slots.
+     * Also incremented by the consumer.
+     */
+    int nfree;
+    int nfree_min; /**< minimum number of free slots observed so far */
+    /**
+     * Consumer waits for a push to complete (MPSC mode only).
+     * Set by the consumer.
+     */
+    int stalled;
+    unsigned full : 1; /**< queue is full. Also cleared by the consumer. */
 };
 
 /** Event queue handling policy. */
@@ -61,6 +145,28 @@ struct am_event_queue_policy {
      * Otherwise FIFO mode is to be used.
      */
     unsigned lifo : 1;
+    /**
+     * Publish event to either all subscribed event handlers or none of them,
+     * if set to true. Used by am_event_async_publish().
+     * Also makes am_event_queue_push_many() push either all events
+     * or none of them.
+     */
+    unsigned all_or_none : 1;
+    /**
+     * Replace the queued event with the same ID in place, if set to true.
+     * The replaced event is freed. The event is placed to the event
+     * queue as usual, if no event with the same ID is queued.
+     * Not supported by lock-free MPSC event queues.
+     */
+    unsigned coalesce : 1;
+    /**
+     * The event queue lane to place the event to.
+     * Events from higher lanes are popped first.
+     * Clamped to the highest lane of the event queue.
+     * Ignored, if the event queue has no lanes
+     * (see am_event_queue_set_lanes()).
+     */
+    int lane;
     /**
      * The number of the free slots, which must remain
      * in event queue after placing the event.
@@ -97,6 +203,132 @@ void am_event_queue_init(
     struct am_event_alloc* alloc
 );
 
+/**
+ * Switch event queue to lock-free multi-producer single-consumer mode.
+ *
+ * In this (MPSC) mode am_event_queue_push() pushes statically allocated
+ * events without entering critical section. For other events the critical
+ * section is only entered to increment the event reference counter
+ * unless AM_EVENT_REF_COUNTER_ATOMIC is defined.
+ * am_event_queue_pop_front() does not enter critical section either.
+ *
+ * The queue keeps its margin, LIFO and free slots watermark semantics.
+ * The queue state is also consistent for the callers of
+ * the thread unsafe push APIs running from within critical section.
+ *
+ * All pops must be done by one consumer.
+ * If a push is still in progress, the pop returns NULL and marks
+ * the consumer as stalled. The push then returns #AM_RC_QUEUE_WAS_EMPTY
+ * to let the producer notify the consumer. am_event_queue_is_empty()
+ * has no side effects and returns false for the push in progress.
+ * The LIFO push also makes its slot the front one before placing
+ * the event to it. So, the pop may return NULL even if the preceding
+ * am_event_queue_is_empty() call returned false.
+ * The consumer then waits for the producer notification.
+ *
+ * Must be called for empty event queue before its first use.
+ *
+ * @param queue  the event queue
+ */
+void am_event_queue_set_mpsc(struct am_event_queue* queue);
+
+/**
+ * Enable push time stamps of event queue.
+ *
+ * The time of every push is taken with @p get_time and stored
+ * alongside the pushed event. The time stamp of the event popped last
+ * is available with am_event_queue_get_stamp_unsafe().
+ * Could be used to measure how long events wait in the queue.
+ *
+ * Must be called for empty event queue before its first use.
+ *
+ * @param queue     the event queue
+ * @param stamps    the array of time stamps
+ * @param nstamps   the number of time stamps in @p stamps.
+ *                  Must be equal to the event queue capacity.
+ * @param get_time  the time source
+ */
+void am_event_queue_set_stamps(
+    struct am_event_queue* queue,
+    uint32_t stamps[],
+    int nstamps,
+    uint32_t (*get_time)(void)
+);
+
+/**
+ * Get push time stamp of the event popped from event queue last.
+ *
+ * Must only be called by the event queue consumer.
+ * Requires push time stamps to be enabled with am_event_queue_set_stamps().
+ *
+ * @param queue  the event queue
+ *
+ * @return the push time stamp
+ */
+uint32_t am_event_queue_get_stamp_unsafe(const struct am_event_queue* queue);
+
+/**
+ * Split event queue into priority lanes.
+ *
+ * The event queue slots are split among @p nlanes lanes.
+ * Each lane is a separate ring of @p nevents[i] slots.
+ * The lane of a pushed event is selected with
+ * am_event_queue_policy::lane. The event is popped from the highest
+ * non-empty lane, so urgent events in higher lanes do not wait
+ * behind bulk events in lower lanes. The order of events within
+ * one lane is kept.
+ *
+ * The margin and coalescing policies apply to the selected lane.
+ * The free slots watermark is tracked for each lane
+ * (see am_event_queue_get_lane_nfree_min()) and for the whole queue.
+ *
+ * Not supported in MPSC mode (see am_event_queue_set_mpsc()).
+ *
+ * Must be called for empty event queue before its first use.
+ *
+ * @param queue    the event queue
+ * @param lanes    the array of lanes
+ * @param nevents  the number of event queue slots of each lane.
+ *                 The sum must be equal to the event queue capacity.
+ * @param nlanes   the number of lanes in @p lanes and @p nevents.
+ *                 Must not be greater than AM_EVENT_QUEUE_LANES_MAX.
+ */
+void am_event_queue_set_lanes(
+    struct am_event_queue* queue,
+    struct am_event_queue_lane lanes[],
+    const int nevents[],
+    int nlanes
+);
+
+/**
+ * Get the number of free slots available to pushes to event queue lane.
+ *
+ * Returns the number of free slots of the whole event queue,
+ * if the event queue has no lanes.
+ *
+ * @param queue  the event queue
+ * @param lane   the lane. Clamped to the highest lane of the event queue.
+ *
+ * @return the number of free slots
+ */
+int am_event_queue_get_lane_nfree_unsafe(
+    const struct am_event_queue* queue, int lane
+);
+
+/**
+ * Get minimum number of free slots ever observed in event queue lane.
+ *
+ * Thread safe.
+ *
+ * @param queue  the event queue with lanes (see am_event_queue_set_lanes())
+ * @param lane   the lane
+ *
+ * @return the minimum number of free slots of the lane observed so far
+ */
+int am_event_queue_get_lane_nfree_min(
+    const struct am_event_queue* queue, int lane
+);
+
 /**
  * De-initialize event queue.
  *
@@ -115,6 +347,10 @@ void am_event_queue_deinit(struct am_event_queue* queue);
  *
  * Asserts, if policy.margin == 0 and the event was not pushed.
  *
+ * If policy.coalesce is set and an event with the same ID is already
+ * queued, then the queued event is replaced with the event in place
+ * and freed. The free queue slots are not checked in this case.
+ *
  * Tries to free the event, if it was not pushed.
  *
  * Statically allocated events (the events for which am_event_is_static()
@@ -151,6 +387,10 @@ enum am_rc am_event_queue_push(
  *
  * Asserts, if policy.margin == 0 and the event was not pushed.
  *
+ * If policy.coalesce is set and an event with the same ID is already
+ * queued, then the queued event is replaced with the event in place
+ * and freed. The free queue slots are not checked in this case.
+ *
  * Tries to free the event, if it was not pushed.
  *
  * Statically allocated events (the events for which am_event_is_static()
@@ -178,6 +418,105 @@ enum am_rc am_event_queue_push_unsafe(
     struct am_event_queue_policy policy
 );
 
+/**
+ * Push event to event queue moving the caller event reference to the queue.
+ *
+ * Same as am_event_queue_push_unsafe() except the event reference counter
+ * is not incremented. The event reference held by the caller is moved
+ * to the event queue instead. Could be used to move events between
+ * event queues without updating their reference counters.
+ *
+ * Does not assert and does not free the event, if the event was not pushed.
+ * The caller keeps the event reference then.
+ *
+ * Not thread safe.
+ *
+ * @param queue   the event queue
+ * @param event   the event to push
+ * @param policy  the event queue handling policy
+ *
+ * @retval #AM_RC_OK               the event was pushed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the event was pushed,
+ *                                 queue was empty
+ * @retval #AM_RC_ERR              the event was not pushed
+ */
+enum am_rc am_event_queue_push_move_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* event,
+    struct am_event_queue_policy policy
+);
+
+/**
+ * Push several events to event queue.
+ *
+ * Pushes the events in one go with the same @p policy.
+ * The events keep their order in the event queue both in FIFO
+ * and LIFO modes. In LIFO mode the events are placed to the front of
+ * the event queue starting from the last one.
+ *
+ * The leading events, which fit the event queue with policy.margin
+ * free slots remaining, are pushed. If policy.all_or_none is set,
+ * then either all events are pushed or none of them.
+ *
+ * Asserts, if policy.margin == 0 and not all events were pushed.
+ * Tries to free the events, which were not pushed.
+ *
+ * policy.coalesce is not supported.
+ *
+ * Thread safe. Enters critical section once.
+ * In MPSC mode (see am_event_queue_set_mpsc()) the free slots are
+ * reserved for all events at once without entering critical section.
+ *
+ * There are limitations to what application code can do with the events
+ * after calling this function. Please consult the
+ * <a href="https://amast.readthedocs.io/event.html">Event Ownership Diagram</a>
+ * to understand the limitations.
+ *
+ * @param queue    the event queue
+ * @param events   the events to push
+ * @param nevents  the number of events in @p events
+ * @param policy   the event queue handling policy
+ * @param npushed  the number of pushed events is returned here.
+ *                 Can be NULL.
+ *
+ * @retval #AM_RC_OK               the events were pushed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the events were pushed,
+ *                                 queue was empty
+ * @retval #AM_RC_ERR              no events were pushed
+ */
+enum am_rc am_event_queue_push_many(
+    struct am_event_queue* queue,
+    const struct am_event* events[],
+    int nevents,
+    struct am_event_queue_policy policy,
+    int* npushed
+);
+
+/**
+ * Push several events to event queue.
+ *
+ * Same as am_event_queue_push_many() except it is thread unsafe.
+ *
+ * @param queue    the event queue
+ * @param events   the events to push
+ * @param nevents  the number of events in @p events
+ * @param policy   the event queue handling policy
+ * @param npushed  the number of pushed events is returned here.
+ *                 Can be NULL.
+ *
+ * @retval #AM_RC_OK               the events were pushed
+ * @retval #AM_RC_QUEUE_WAS_EMPTY  the events were pushed,
+ *                                 queue was empty
+ * @retval #AM_RC_ERR              no events were pushed
+ */
+enum am_rc am_event_queue_push_many_unsafe(
+    struct am_event_queue* queue,
+    const struct am_event* events[],
+    int nevents,
+    struct am_event_queue_policy policy,
+    int* npushed
+);
+
 /**
  * Push event to the back of event queue.
  *
@@ -284,6 +623,10 @@ bool am_event_queue_is_valid(const struct am_event_queue* queue);
 /**
  * Check if event queue is empty.
  *
+ * In MPSC mode (see am_event_queue_set_mpsc()) returns false,
+ * if the event at the front of the queue is still being pushed.
+ * Does not change the queue state, so producers may call it too.
+ *
  * Thread safe.
  *
  * @param queue  the event queue
@@ -296,6 +639,10 @@ bool am_event_queue_is_empty(const struct am_event_queue* queue);
 /**
  * Check if event queue is empty.
  *
+ * In MPSC mode (see am_event_queue_set_mpsc()) returns false,
+ * if the event at the front of the queue is still being pushed.
+ * Does not change the queue state, so producers may call it too.
+ *
  * Thread unsafe.
  *
  * @param queue  the event queue
@@ -355,6 +702,25 @@ const struct am_event* am_event_queue_pop_front_unsafe(
  */
 const struct am_event* am_event_queue_pop_front(struct am_event_queue* queue);
 
+/**
+ * Pop several items from the front (head) of event queue.
+ *
+ * Pops up to @p nevents events in one go.
+ * The caller owns the popped events and is responsible for
+ * freeing them.
+ *
+ * Thread safe. Enters critical section once.
+ *
+ * @param queue    the event queue
+ * @param events   the popped events are returned here
+ * @param nevents  the maximum number of events to pop
+ *
+ * @return the number of popped events
+ */
+int am_event_queue_pop_many(
+    struct am_event_queue* queue, const struct am_event* events[], int nevents
+);
+
 /**
  * Get minimum number of free slots ever observed in event queue.
  *
@@ -86,8 +86,7 @@ void am_event_sync_subscribe(
     int si = event_id - AM_EVT_USER;
     AM_ASSERT(si < hub->nsub);
 
-    int li = handler_id / 8;
-    hub->sub[si].list[li] |= (uint8_t)(1U << (unsigned)(handler_id % 8));
+    am_bitmap_set(hub->sub[si].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
 }
 
 void am_event_sync_unsubscribe(
@@ -104,8 +103,7 @@ void am_event_sync_unsubscribe(
     int si = event_id - AM_EVT_USER;
     AM_ASSERT(si < hub->nsub);
 
-    int li = handler_id / 8;
-    hub->sub[si].list[li] &= (uint8_t)~(1U << (unsigned)(handler_id % 8));
+    am_bitmap_clear(hub->sub[si].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
 }
 
 void am_event_sync_unsubscribe_all(
@@ -118,11 +116,8 @@ void am_event_sync_unsubscribe_all(
     AM_ASSERT(handler_id < AM_EVT_HANDLERS_NUM_MAX);
     AM_ASSERT(hub->handlers[handler_id].fn);
 
-    int li = handler_id / 8;
-    unsigned clear_mask = ~(1U << (unsigned)(handler_id % 8));
-
     for (int i = 0; i < hub->nsub; ++i) {
-        hub->sub[i].list[li] &= (uint8_t)clear_mask;
+        am_bitmap_clear(hub->sub[i].list, AM_EVT_HANDLERS_NUM_MAX, handler_id);
     }
 }
 
@@ -227,21 +222,18 @@ bool am_event_sync_publish_request(
     AM_ASSERT(si < hub->nsub);
 
     struct am_event_subscribe_list sub = hub->sub[si];
-    for (int i = 0; i < AM_COUNTOF(sub.list); ++i) {
-        while (sub.list[i]) {
-            int msb = am_bit_u8_msb(sub.list[i]);
-            sub.list[i] &= (uint8_t)~(1U << (unsigned)msb);
-
-            int handler_id = (8 * i) + msb;
+    const int nbits = AM_EVT_HANDLERS_NUM_MAX;
+    while (!am_bitmap_is_empty(sub.list, nbits)) {
+        int handler_id = am_bitmap_msb(sub.list, nbits);
+        am_bitmap_clear(sub.list, nbits, handler_id);
 
-            hub->observer_cb(handler_id, event);
+        hub->observer_cb(handler_id, event);
 
-            struct am_event_sync_handler* handler = &hub->handlers[handler_id];
+        struct am_event_sync_handler* handler = &hub->handlers[handler_id];
 
-            AM_ASSERT(handler->fn);
-            if (!handler->fn(handler->ctx, event, out, out_size)) {
-                all_published = false;
-            }
+        AM_ASSERT(handler->fn);
+        if (!handler->fn(handler->ctx, event, out, out_size)) {
+            all_published = false;
         }
     }
 
@@ -29,6 +29,7 @@
  * Event allocation unit tests.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -74,7 +75,9 @@ static void test_allocate(
     am_event_free(alloc, e);
 }
 
-static void test_am_event_queue(const int capacity, const int rdwr_num) {
+static void test_am_event_queue(
+    const int capacity, const int rdwr_num, const bool mpsc
+) {
     struct am_event_alloc alloc;
     am_event_alloc_init(&alloc);
     am_event_alloc_add_pool(
@@ -85,6 +88,9 @@ static void test_am_event_queue(const int capacity, const int rdwr_num) {
 
     struct am_event_queue q;
     am_event_queue_init(&q, pool, capacity, &alloc);
+    if (mpsc) {
+        am_event_queue_set_mpsc(&q);
+    }
     AM_ASSERT(am_event_queue_is_empty(&q));
 
     if (!rdwr_num) {
@@ -132,6 +138,622 @@ static void test_am_event_queue(const int capacity, const int rdwr_num) {
     AM_ASSERT(am_event_queue_is_empty(&q));
 }
 
+static void test_am_event_queue_margin(const bool mpsc) {
+    struct am_event_alloc alloc;
+    am_event_alloc_init(&alloc);
+    am_event_alloc_add_pool(
+        &alloc, &buf1, sizeof(buf1), sizeof(buf1), AM_ALIGNOF(am_event_t)
+    );
+
+    const struct am_event* pool[4];
+
+    struct am_event_queue q;
+    am_event_queue_init(&q, pool, AM_COUNTOF(pool), &alloc);
+    if (mpsc) {
+        am_event_queue_set_mpsc(&q);
+    }
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 4);
+
+    struct am_event events[4];
+    memset(events, 0, sizeof(events));
+
+    struct am_event_queue_policy policy = {.margin = 2};
+    enum am_rc rc = am_event_queue_push(&q, &events[0], policy);
+    AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+    rc = am_event_queue_push(&q, &events[1], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    rc = am_event_queue_push(&q, &events[2], policy);
+    AM_ASSERT(AM_RC_ERR == rc);
+    AM_ASSERT(am_event_queue_get_nbusy_unsafe(&q) == 2);
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 2);
+
+    policy.lifo = 1;
+    policy.margin = 0;
+    rc = am_event_queue_push(&q, &events[2], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 1);
+
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[2]);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[0]);
+
+    /* wrap the read index around */
+    rc = am_event_queue_push(&q, &events[3], AM_EVENT_QUEUE_POLICY_DEFAULT);
+    AM_ASSERT(AM_RC_OK == rc);
+    rc = am_event_queue_push_unsafe(&q, &events[0], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 1);
+
+    AM_ASSERT(am_event_queue_pop_front_unsafe(&q) == &events[0]);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[1]);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[3]);
+    AM_ASSERT(NULL == am_event_queue_pop_front(&q));
+    AM_ASSERT(am_event_queue_is_empty(&q));
+
+    rc = am_event_queue_push_back(&q, &events[1]);
+    AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+    AM_ASSERT(am_event_queue_flush(&q) == 1);
+
+    am_event_queue_deinit(&q);
+}
+
+static void test_am_event_queue_mpsc_is_empty(void) {
+    const struct am_event* pool[2];
+
+    struct am_event_queue q;
+    am_event_queue_init(&q, pool, AM_COUNTOF(pool), /*alloc=*/NULL);
+    am_event_queue_set_mpsc(&q);
+    AM_ASSERT(am_event_queue_is_empty(&q));
+
+    /* a producer reserved the slot, but did not place the event yet */
+    --q.nfree;
+    AM_ASSERT(!am_event_queue_is_empty(&q));
+    AM_ASSERT(!am_event_queue_is_empty_unsafe(&q));
+    /* only the pop of the consumer marks it as stalled */
+    AM_ASSERT(0 == q.stalled);
+    AM_ASSERT(NULL == am_event_queue_pop_front(&q));
+    AM_ASSERT(1 == q.stalled);
+    ++q.nfree;
+
+    struct am_event event;
+    memset(&event, 0, sizeof(event));
+    event.id = AM_EVT_USER;
+    enum am_rc rc = am_event_queue_push_back(&q, &event);
+    AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+    AM_ASSERT(0 == q.stalled);
+    AM_ASSERT(!am_event_queue_is_empty(&q));
+    AM_ASSERT(am_event_queue_pop_front(&q) == &event);
+    AM_ASSERT(am_event_queue_is_empty(&q));
+
+    am_event_queue_deinit(&q);
+}
+
+static uint32_t m_now;
+
+static uint32_t test_get_time(void) { return ++m_now; }
+
+static void test_am_event_queue_stamps(const bool mpsc) {
+    const struct am_event* pool[3];
+    uint32_t stamps[AM_COUNTOF(pool)];
+
+    struct am_event_queue q;
+    am_event_queue_init(&q, pool, AM_COUNTOF(pool), /*alloc=*/NULL);
+    if (mpsc) {
+        am_event_queue_set_mpsc(&q);
+    }
+    am_event_queue_set_stamps(&q, stamps, AM_COUNTOF(stamps), test_get_time);
+
+    struct am_event events[3];
+    memset(events, 0, sizeof(events));
+
+    m_now = 0;
+    for (int round = 0; round < 2; ++round) {
+        const uint32_t now = m_now;
+        enum am_rc rc = am_event_queue_push_back(&q, &events[0]);
+        AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+        rc = am_event_queue_push_back(&q, &events[1]);
+        AM_ASSERT(AM_RC_OK == rc);
+        rc = am_event_queue_push_front(&q, &events[2]);
+        AM_ASSERT(AM_RC_OK == rc);
+
+        AM_ASSERT(am_event_queue_pop_front(&q) == &events[2]);
+        AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == (now + 3));
+        AM_ASSERT(am_event_queue_pop_front(&q) == &events[0]);
+        AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == (now + 1));
+        AM_ASSERT(am_event_queue_pop_front_unsafe(&q) == &events[1]);
+        AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == (now + 2));
+        AM_ASSERT(am_event_queue_is_empty(&q));
+    }
+
+    am_event_queue_deinit(&q);
+}
+
+static void test_am_event_queue_coalesce(struct am_event_alloc* alloc) {
+    const struct am_event* pool[2];
+    uint32_t stamps[AM_COUNTOF(pool)];
+
+    struct am_event_queue q;
+    am_event_queue_init(&q, pool, AM_COUNTOF(pool), alloc);
+    am_event_queue_set_stamps(&q, stamps, AM_COUNTOF(stamps), test_get_time);
+
+    const int nfree = am_event_alloc_get_nfree(alloc, /*index=*/0);
+    struct am_event_queue_policy policy = {.coalesce = 1};
+
+    m_now = 0;
+    const struct am_event* e1 =
+        am_event_allocate(alloc, AM_EVT_USER, sizeof(struct am_event));
+    enum am_rc rc = am_event_queue_push(&q, e1, policy);
+    AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+    const struct am_event* e2 =
+        am_event_allocate(alloc, AM_EVT_USER + 1, sizeof(struct am_event));
+    rc = am_event_queue_push(&q, e2, policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_alloc_get_nfree(alloc, /*index=*/0) == (nfree - 2));
+
+    /* the queue is full: the queued events are replaced in place */
+    for (int i = 0; i < 3; ++i) {
+        const struct am_event* e =
+            am_event_allocate(alloc, AM_EVT_USER, sizeof(struct am_event));
+        rc = am_event_queue_push(&q, e, policy);
+        AM_ASSERT(AM_RC_OK == rc);
+        AM_ASSERT(am_event_queue_get_nbusy_unsafe(&q) == 2);
+        AM_ASSERT(am_event_alloc_get_nfree(alloc, /*index=*/0) == (nfree - 2));
+        e1 = e;
+    }
+    const struct am_event* e3 =
+        am_event_allocate(alloc, AM_EVT_USER + 1, sizeof(struct am_event));
+    policy.lifo = 1;
+    rc = am_event_queue_push_unsafe(&q, e3, policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 0);
+
+    /* the order and the time stamps of the replaced events are retained */
+    AM_ASSERT(am_event_queue_pop_front(&q) == e1);
+    AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == 1);
+    am_event_free(alloc, e1);
+    AM_ASSERT(am_event_queue_pop_front(&q) == e3);
+    AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == 2);
+    am_event_free(alloc, e3);
+    AM_ASSERT(am_event_queue_is_empty(&q));
+    AM_ASSERT(am_event_alloc_get_nfree(alloc, /*index=*/0) == nfree);
+
+    am_event_queue_deinit(&q);
+}
+
+static void test_am_event_queue_many(const bool mpsc) {
+    struct am_event_alloc alloc;
+    am_event_alloc_init(&alloc);
+    am_event_alloc_add_pool(
+        &alloc, &buf1, sizeof(buf1), sizeof(buf1), AM_ALIGNOF(am_event_t)
+    );
+
+    const struct am_event* pool[5];
+
+    struct am_event_queue q;
+    am_event_queue_init(&q, pool, AM_COUNTOF(pool), &alloc);
+    if (mpsc) {
+        am_event_queue_set_mpsc(&q);
+    }
+
+    struct am_event events[4];
+    memset(events, 0, sizeof(events));
+    const struct am_event* pevents[AM_COUNTOF(events)];
+    for (int i = 0; i < AM_COUNTOF(events); ++i) {
+        events[i].id = (uint16_t)(AM_EVT_USER + i);
+        pevents[i] = &events[i];
+    }
+
+    struct am_event_queue_policy policy = {.margin = 1};
+    int npushed = 0;
+    enum am_rc rc = am_event_queue_push_many(&q, pevents, 2, policy, &npushed);
+    AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+    AM_ASSERT(2 == npushed);
+
+    /* only two of the four events fit with one free slot remaining */
+    policy.all_or_none = 1;
+    rc = am_event_queue_push_many(&q, pevents, 4, policy, &npushed);
+    AM_ASSERT(AM_RC_ERR == rc);
+    AM_ASSERT(0 == npushed);
+    AM_ASSERT(am_event_queue_get_nbusy_unsafe(&q) == 2);
+
+    /* the non-pushed dynamic event is freed */
+    const struct am_event* e =
+        am_event_allocate(&alloc, AM_EVT_USER, sizeof(struct am_event));
+    const struct am_event* mixed[] = {e, &events[0], &events[1]};
+    rc = am_event_queue_push_many(&q, mixed, 3, policy, &npushed);
+    AM_ASSERT(AM_RC_ERR == rc);
+    AM_ASSERT(0 == npushed);
+    AM_ASSERT(am_event_alloc_get_nfree(&alloc, /*index=*/0) == 1);
+
+    e = am_event_allocate(&alloc, AM_EVT_USER, sizeof(struct am_event));
+    rc = am_event_queue_push_many(&q, &e, 1, policy, /*npushed=*/NULL);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_alloc_get_nfree(&alloc, /*index=*/0) == 0);
+
+    /* the events keep their order at the front of the queue */
+    policy.all_or_none = 0;
+    policy.lifo = 1;
+    policy.margin = 0;
+    rc = am_event_queue_push_many(&q, &pevents[2], 2, policy, &npushed);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(2 == npushed);
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 0);
+
+    const struct am_event* popped[AM_COUNTOF(pool) + 1];
+    int n = am_event_queue_pop_many(&q, popped, 3);
+    AM_ASSERT(3 == n);
+    AM_ASSERT(popped[0] == &events[2]);
+    AM_ASSERT(popped[1] == &events[3]);
+    AM_ASSERT(popped[2] == &events[0]);
+
+    n = am_event_queue_pop_many(&q, popped, AM_COUNTOF(popped));
+    AM_ASSERT(2 == n);
+    AM_ASSERT(popped[0] == &events[1]);
+    AM_ASSERT(popped[1] == e);
+    am_event_free(&alloc, e);
+    AM_ASSERT(am_event_alloc_get_nfree(&alloc, /*index=*/0) == 1);
+
+    AM_ASSERT(0 == am_event_queue_pop_many(&q, popped, AM_COUNTOF(popped)));
+
+    am_event_queue_deinit(&q);
+}
+
+static void test_am_event_queue_lanes(void) {
+    const struct am_event* pool[6];
+    uint32_t stamps[AM_COUNTOF(pool)];
+    struct am_event_queue_lane lanes[3];
+    const int nevents[AM_COUNTOF(lanes)] = {3, 1, 2};
+
+    struct am_event_queue q;
+    am_event_queue_init(&q, pool, AM_COUNTOF(pool), /*alloc=*/NULL);
+    am_event_queue_set_lanes(&q, lanes, nevents, AM_COUNTOF(lanes));
+    am_event_queue_set_stamps(&q, stamps, AM_COUNTOF(stamps), test_get_time);
+
+    struct am_event events[6];
+    memset(events, 0, sizeof(events));
+    for (int i = 0; i < AM_COUNTOF(events); ++i) {
+        events[i].id = (uint16_t)(AM_EVT_USER + i);
+    }
+
+    m_now = 0;
+    struct am_event_queue_policy policy = {.lane = 0};
+    enum am_rc rc = am_event_queue_push(&q, &events[0], policy);
+    AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+    rc = am_event_queue_push(&q, &events[1], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+
+    /* the lane 1 has one slot only */
+    policy.lane = 1;
+    policy.margin = 1;
+    rc = am_event_queue_push(&q, &events[2], policy);
+    AM_ASSERT(AM_RC_ERR == rc);
+    policy.margin = 0;
+    rc = am_event_queue_push(&q, &events[2], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_queue_get_lane_nfree_unsafe(&q, /*lane=*/1) == 0);
+
+    /* the lane is clamped to the highest lane */
+    policy.lane = 7;
+    rc = am_event_queue_push(&q, &events[3], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    policy.lifo = 1;
+    rc = am_event_queue_push_unsafe(&q, &events[4], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_queue_get_lane_nfree_unsafe(&q, /*lane=*/2) == 0);
+    AM_ASSERT(am_event_queue_get_nbusy_unsafe(&q) == 5);
+
+    /* the coalescing is done within the lane */
+    policy.lifo = 0;
+    policy.coalesce = 1;
+    policy.lane = 0;
+    rc = am_event_queue_push(&q, &events[3], policy);
+    AM_ASSERT(AM_RC_OK == rc);
+    AM_ASSERT(am_event_queue_get_lane_nfree_unsafe(&q, /*lane=*/0) == 0);
+
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[4]);
+    AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == 5);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[3]);
+    AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == 4);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[2]);
+    AM_ASSERT(am_event_queue_pop_front_unsafe(&q) == &events[0]);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[1]);
+    AM_ASSERT(am_event_queue_pop_front(&q) == &events[3]);
+    AM_ASSERT(am_event_queue_get_stamp_unsafe(&q) == 6);
+    AM_ASSERT(NULL == am_event_queue_pop_front(&q));
+    AM_ASSERT(am_event_queue_is_empty(&q));
+
+    AM_ASSERT(am_event_queue_get_lane_nfree_min(&q, /*lane=*/0) == 0);
+    AM_ASSERT(am_event_queue_get_lane_nfree_min(&q, /*lane=*/1) == 0);
+    AM_ASSERT(am_event_queue_get_lane_nfree_min(&q, /*lane=*/2) == 0);
+    AM_ASSERT(am_event_queue_get_nfree_min(&q) == 0);
+
+    /* the lanes wrap around */
+    for (int i = 0; i < 6; ++i) {
+        policy = (struct am_event_queue_policy){.lane = i % 3};
+        rc = am_event_queue_push(&q, &events[i], policy);
+        AM_ASSERT(AM_RC_QUEUE_WAS_EMPTY == rc);
+        AM_ASSERT(am_event_queue_pop_front(&q) == &events[i]);
+    }
+
+    am_event_queue_deinit(&q);
+}
+
+static bool test_async_handler(
+    void* ctx, const struct am_event* event, struct am_event_queue_policy policy
+) {
+    enum am_rc rc = am_event_queue_push_unsafe(ctx, event, policy);
+    return AM_RC_ERR != rc;
+}
+
+static bool test_async_check(void* ctx, struct am_event_queue_policy policy) {
+    const struct am_event_queue* q = ctx;
+    int nfree =
+        am_event_queue_get_capacity(q) - am_event_queue_get_nbusy_unsafe(q);
+    return nfree > policy.margin;
+}
+
+static void test_am_event_async_all_or_none(struct am_event_alloc* alloc) {
+    struct am_event_subscribe_list sub[1];
+    am_event_async_global_init(sub, AM_COUNTOF(sub), alloc);
+
+    const struct am_event* events1[3];
+    const struct am_event* events2[2];
+    struct am_event_queue q1;
+    struct am_event_queue q2;
+    am_event_queue_init(&q1, events1, AM_COUNTOF(events1), alloc);
+    am_event_queue_init(&q2, events2, AM_COUNTOF(events2), alloc);
+
+    am_event_async_register_with_id_x(
+        test_async_handler, test_async_check, &q1, /*handler_id=*/0
+    );
+    am_event_async_register_with_id_x(
+        test_async_handler, test_async_check, &q2, /*handler_id=*/1
+    );
+    am_event_async_subscribe(/*handler_id=*/0, AM_EVT_USER);
+    am_event_async_subscribe(/*handler_id=*/1, AM_EVT_USER);
+
+    struct am_event_queue_policy policy = {
+        .all_or_none = 1, .margin = 1, .exclude_id = AM_EVENT_PUBLISHER_ID_NONE
+    };
+    const int size = (int)sizeof(struct am_event);
+    const int nfree = am_event_alloc_get_nfree(alloc, /*index=*/0);
+    const struct am_event* e = am_event_allocate(alloc, AM_EVT_USER, size);
+    AM_ASSERT(am_event_async_publish(e, policy));
+    AM_ASSERT(1 == am_event_queue_get_nbusy_unsafe(&q1));
+    AM_ASSERT(1 == am_event_queue_get_nbusy_unsafe(&q2));
+
+    /* q2 has no room for the event with the margin */
+    e = am_event_allocate(alloc, AM_EVT_USER, size);
+    AM_ASSERT(!am_event_async_publish(e, policy));
+    AM_ASSERT(1 == am_event_queue_get_nbusy_unsafe(&q1));
+    AM_ASSERT(1 == am_event_queue_get_nbusy_unsafe(&q2));
+    AM_ASSERT((nfree - 1) == am_event_alloc_get_nfree(alloc, /*index=*/0));
+
+    /* q2 is excluded */
+    policy.exclude_id = 1;
+    e = am_event_allocate(alloc, AM_EVT_USER, size);
+    AM_ASSERT(am_event_async_publish(e, policy));
+    AM_ASSERT(2 == am_event_queue_get_nbusy_unsafe(&q1));
+
+    /* best effort delivery */
+    policy.all_or_none = 0;
+    policy.margin = 0;
+    policy.exclude_id = AM_EVENT_PUBLISHER_ID_NONE;
+    e = am_event_allocate(alloc, AM_EVT_USER, size);
+    AM_ASSERT(am_event_async_publish(e, policy));
+    AM_ASSERT(3 == am_event_queue_get_nbusy_unsafe(&q1));
+    AM_ASSERT(2 == am_event_queue_get_nbusy_unsafe(&q2));
+
+    for (int i = 0; i < 3; ++i) {
+        am_event_free(alloc, am_event_queue_pop_front(&q1));
+    }
+    for (int i = 0; i < 2; ++i) {
+        am_event_free(alloc, am_event_queue_pop_front(&q2));
+    }
+    AM_ASSERT(nfree == am_event_alloc_get_nfree(alloc, /*index=*/0));
+
+    am_event_async_unregister(/*handler_id=*/0);
+    am_event_async_unregister(/*handler_id=*/1);
+    am_event_queue_deinit(&q1);
+    am_event_queue_deinit(&q2);
+}
+
+static void test_am_event_ref_cnt(struct am_event_alloc* alloc) {
+#ifdef AM_EVENT_REF_COUNTER_ATOMIC
+    /* not limited by the event reference counter bit field */
+    const int nrefs = 1000;
+#else
+    const int nrefs = (int)AM_EVENT_REF_COUNTER_MAX;
+#endif
+    const int nfree = am_event_alloc_get_nfree(alloc, /*index=*/0);
+    const struct am_event* e =
+        am_event_allocate(alloc, AM_EVT_USER, (int)sizeof(struct am_event));
+    AM_ASSERT(0 == am_event_get_ref_cnt(alloc, e));
+
+    for (int i = 0; i < nrefs; ++i) {
+        am_event_inc_ref_cnt(e);
+    }
+    AM_ASSERT(nrefs == am_event_get_ref_cnt(alloc, e));
+
+    for (int i = 0; i < (nrefs - 1); ++i) {
+        am_event_dec_ref_cnt(alloc, e);
+    }
+    AM_ASSERT(1 == am_event_get_ref_cnt(alloc, e));
+    AM_ASSERT((nfree - 1) == am_event_alloc_get_nfree(alloc, /*index=*/0));
+
+    am_event_dec_ref_cnt(alloc, e);
+    AM_ASSERT(nfree == am_event_alloc_get_nfree(alloc, /*index=*/0));
+}
+
+static void test_am_event_alloc_pools_max(void) {
+    static uint64_t pools[AM_EVENT_POOLS_NUM_MAX][AM_EVENT_SIZE_LUT_MAX / 4];
+    const int align = AM_ALIGNOF(am_event_t);
+    /* the biggest memory blocks are about 2 * AM_EVENT_SIZE_LUT_MAX bytes */
+    const int step =
+        (2 * AM_EVENT_SIZE_LUT_MAX) / AM_EVENT_POOLS_NUM_MAX / 8 * 8;
+    AM_ASSERT((step * AM_EVENT_POOLS_NUM_MAX) > AM_EVENT_SIZE_LUT_MAX);
+    AM_ASSERT((step * AM_EVENT_POOLS_NUM_MAX) <= (int)sizeof(pools[0]));
+
+    struct am_event_alloc ea;
+    am_event_alloc_init(&ea);
+    for (int i = 0; i < AM_EVENT_POOLS_NUM_MAX; ++i) {
+        int block_size = step * (i + 1);
+        am_event_alloc_add_pool(&ea, pools[i], block_size, block_size, align);
+    }
+    AM_ASSERT(AM_EVENT_POOLS_NUM_MAX == am_event_alloc_get_num(&ea));
+
+    /*
+     * The event sizes up to AM_EVENT_SIZE_LUT_MAX are served by
+     * the lookup table and the bigger ones by binary search
+     */
+    const int size_max = step * AM_EVENT_POOLS_NUM_MAX;
+    for (int size = (int)sizeof(struct am_event); size <= size_max; ++size) {
+        int pool_index_plus_one = (size + step - 1) / step;
+        test_allocate(&ea, size, pool_index_plus_one);
+    }
+}
+
+static void test_am_event_alloc_advise(void) {
+    static uint64_t pool_small[8 * 16];
+    static uint64_t pool_big[64 * 2];
+    const int align = AM_ALIGNOF(am_event_t);
+
+    struct am_event_alloc ea;
+    am_event_alloc_init(&ea);
+    am_event_alloc_add_pool(
+        &ea, pool_small, sizeof(pool_small), sizeof(pool_small) / 16, align
+    );
+    am_event_alloc_add_pool(
+        &ea, pool_big, sizeof(pool_big), sizeof(pool_big) / 2, align
+    );
+    struct am_event_alloc_stats stats;
+    am_event_alloc_set_stats(&ea, &stats);
+
+    /* the workload: 4 small, 2 medium and 1 big event at a time */
+    const struct am_event* e[7];
+    for (int i = 0; i < 4; ++i) {
+        e[i] = am_event_allocate(&ea, AM_EVT_USER, /*size=*/8);
+    }
+    e[4] = am_event_allocate(&ea, AM_EVT_USER, /*size=*/40);
+    e[5] = am_event_allocate(&ea, AM_EVT_USER, /*size=*/40);
+    e[6] = am_event_allocate(&ea, AM_EVT_USER, /*size=*/300);
+    for (int i = 0; i < AM_COUNTOF(e); ++i) {
+        am_event_free(&ea, e[i]);
+    }
+
+    struct am_event_alloc_stats snapshot;
+    am_event_alloc_get_stats(&ea, &snapshot);
+    AM_ASSERT(4 == snapshot.nallocs[(8 - 1) / AM_EVENT_SIZE_LUT_GRANULE]);
+    AM_ASSERT(2 == snapshot.nallocs[(40 - 1) / AM_EVENT_SIZE_LUT_GRANULE]);
+    AM_ASSERT(1 == snapshot.nallocs_big);
+    AM_ASSERT(300 == snapshot.size_max);
+    AM_ASSERT(0 == snapshot.nfailed[0]);
+
+    struct am_event_pool_advice advice[3];
+    int n = am_event_alloc_advise(&ea, &snapshot, align, advice, 3);
+    AM_ASSERT(3 == n);
+    AM_ASSERT((8 == advice[0].block_size) && (4 == advice[0].nblocks));
+    AM_ASSERT((40 == advice[1].block_size) && (2 == advice[1].nblocks));
+    AM_ASSERT((304 == advice[2].block_size) && (1 == advice[2].nblocks));
+
+    n = am_event_alloc_advise(&ea, &snapshot, align, advice, 2);
+    AM_ASSERT(2 == n);
+    AM_ASSERT((40 == advice[0].block_size) && (6 == advice[0].nblocks));
+    AM_ASSERT((304 == advice[1].block_size) && (1 == advice[1].nblocks));
+
+    n = am_event_alloc_advise(&ea, &snapshot, align, advice, 1);
+    AM_ASSERT(1 == n);
+    AM_ASSERT((304 == advice[0].block_size) && (7 == advice[0].nblocks));
+
+    /* the failed allocations are counted per event pool */
+    AM_ASSERT(!am_event_allocate_x(&ea, AM_EVT_USER, /*size=*/300, 2));
+    am_event_alloc_get_stats(&ea, &snapshot);
+    AM_ASSERT(1 == snapshot.nfailed[1]);
+    AM_ASSERT(2 == snapshot.nallocs_big);
+
+    am_event_alloc_reset_stats(&ea);
+    am_event_alloc_get_stats(&ea, &snapshot);
+    AM_ASSERT(0 == snapshot.nallocs_big);
+    AM_ASSERT(0 == am_event_alloc_advise(&ea, &snapshot, align, advice, 1));
+}
+
+static struct am_event_cache m_event_cache[2];
+static struct am_event_cache* m_event_cache_cur;
+
+static struct am_event_cache* test_get_event_cache(void) {
+    return m_event_cache_cur;
+}
+
+static void test_am_event_cache(struct am_event_alloc* alloc) {
+    const int nblocks = am_event_alloc_get_nblocks(alloc, /*index=*/0);
+    const int size = (int)sizeof(struct am_event);
+    const int batch = AM_EVENT_CACHE_SIZE / 2;
+    const struct am_event* events[16];
+    AM_ASSERT(AM_COUNTOF(events) == nblocks);
+    AM_ASSERT(nblocks >= (2 * AM_EVENT_CACHE_SIZE));
+
+    am_event_alloc_set_cache_fn(alloc, test_get_event_cache);
+    am_event_cache_init(alloc, &m_event_cache[0]);
+    am_event_cache_init(alloc, &m_event_cache[1]);
+
+    /* the event cache is refilled in batches */
+    m_event_cache_cur = &m_event_cache[0];
+    events[0] = am_event_allocate(alloc, AM_EVT_USER, size);
+    AM_ASSERT((nblocks - batch) == am_onesize_get_nfree(&alloc->pools[0]));
+    AM_ASSERT((nblocks - 1) == am_event_alloc_get_nfree(alloc, /*index=*/0));
+    AM_ASSERT((nblocks - 1) == am_event_alloc_get_nfree_min(alloc, 0));
+    /* the event cache is refilled, when it runs empty */
+    for (int i = 1; i < batch; ++i) {
+        events[i] = am_event_allocate(alloc, AM_EVT_USER, size);
+    }
+    AM_ASSERT(
+        (nblocks - 2 * batch) == am_onesize_get_nfree(&alloc->pools[0])
+    );
+    AM_ASSERT(batch == m_event_cache[0].mags[0].nblocks);
+
+    /* the margin is checked against all free blocks */
+    int nfree = am_event_alloc_get_nfree(alloc, /*index=*/0);
+    AM_ASSERT((nblocks - batch) == nfree);
+    AM_ASSERT(!am_event_allocate_x(alloc, AM_EVT_USER, size, nfree));
+    for (int i = batch; i < nblocks; ++i) {
+        events[i] = am_event_allocate_x(alloc, AM_EVT_USER, size, 0);
+        AM_ASSERT(events[i]);
+    }
+    AM_ASSERT(0 == am_event_alloc_get_nfree(alloc, /*index=*/0));
+    AM_ASSERT(0 == am_event_alloc_get_nfree_min(alloc, /*index=*/0));
+    AM_ASSERT(!am_event_allocate_x(alloc, AM_EVT_USER, size, 0));
+
+    /* the event cache is flushed in batches */
+    for (int i = 0; i < nblocks; ++i) {
+        am_event_free(alloc, events[i]);
+        int ncached = m_event_cache[0].mags[0].nblocks;
+        AM_ASSERT(ncached <= AM_EVENT_CACHE_SIZE);
+        AM_ASSERT(
+            (i + 1 - ncached) == am_onesize_get_nfree(&alloc->pools[0])
+        );
+    }
+    AM_ASSERT(nblocks == am_event_alloc_get_nfree(alloc, /*index=*/0));
+
+    /* the blocks cached by one task are not available to other tasks */
+    m_event_cache_cur = &m_event_cache[1];
+    int ncached = m_event_cache[0].mags[0].nblocks;
+    AM_ASSERT(ncached > 0);
+    for (int i = 0; i < (nblocks - ncached); ++i) {
+        events[i] = am_event_allocate(alloc, AM_EVT_USER, size);
+    }
+    AM_ASSERT(ncached == am_event_alloc_get_nfree(alloc, /*index=*/0));
+    AM_ASSERT(!am_event_allocate_x(alloc, AM_EVT_USER, size, 0));
+    for (int i = 0; i < (nblocks - ncached); ++i) {
+        am_event_free(alloc, events[i]);
+    }
+
+    am_event_cache_deinit(alloc, &m_event_cache[1]);
+    m_event_cache_cur = &m_event_cache[0];
+    am_event_cache_deinit(alloc, &m_event_cache[0]);
+    AM_ASSERT(nblocks == am_onesize_get_nfree(&alloc->pools[0]));
+    AM_ASSERT(NULL == alloc->caches);
+    am_event_alloc_set_cache_fn(alloc, /*fn=*/NULL);
+}
+
 int main(void) {
     const int align = AM_ALIGNOF(am_event_t);
     {
@@ -144,6 +766,29 @@ int main(void) {
         test_allocate(&ea, sizeof(buf1), /*pool_index_plus_one=*/1);
         test_allocate(&ea, sizeof(buf1) - 1, /*pool_index_plus_one=*/1);
     }
+    {
+        static struct buf1 pool[4];
+        struct am_event_alloc ea;
+        am_event_alloc_init(&ea);
+        am_event_alloc_add_pool(
+            &ea, pool, sizeof(pool), sizeof(pool[0]), align
+        );
+
+        test_am_event_async_all_or_none(&ea);
+        test_am_event_ref_cnt(&ea);
+        test_am_event_queue_coalesce(&ea);
+    }
+    {
+        static struct buf1 pool[16];
+        struct am_event_alloc ea;
+        am_event_alloc_init(&ea);
+        am_event_alloc_add_pool(
+            &ea, pool, sizeof(pool), sizeof(pool[0]), align
+        );
+
+        test_am_event_cache(&ea);
+        test_am_event_ref_cnt(&ea);
+    }
     {
         struct am_event_alloc ea;
         am_event_alloc_init(&ea);
@@ -221,10 +866,20 @@ int main(void) {
         test_allocate(&ea, sizeof(buf5), /*pool_index_plus_one=*/5);
     }
 
-    test_am_event_queue(/*capacity=*/1, /*rdwr_num=*/0);
-    test_am_event_queue(/*capacity=*/1, /*rdwr_num=*/1);
-    test_am_event_queue(/*capacity=*/2, /*rdwr_num=*/1);
-    test_am_event_queue(/*capacity=*/3, /*rdwr_num=*/3);
+    test_am_event_alloc_pools_max();
+    test_am_event_alloc_advise();
+
+    for (int mpsc = 0; mpsc < 2; ++mpsc) {
+        test_am_event_queue(/*capacity=*/1, /*rdwr_num=*/0, mpsc);
+        test_am_event_queue(/*capacity=*/1, /*rdwr_num=*/1, mpsc);
+        test_am_event_queue(/*capacity=*/2, /*rdwr_num=*/1, mpsc);
+        test_am_event_queue(/*capacity=*/3, /*rdwr_num=*/3, mpsc);
+        test_am_event_queue_margin(mpsc);
+        test_am_event_queue_stamps(mpsc);
+        test_am_event_queue_many(mpsc);
+    }
+    test_am_event_queue_mpsc_is_empty();
+    test_am_event_queue_lanes();
 
     return 0;
 }
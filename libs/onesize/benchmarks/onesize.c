@@ -0,0 +1,142 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Onesize allocator benchmark.
+ *
+ * Several tasks allocate and free memory blocks concurrently.
+ * Run with argument 0 to use the onesize allocator protected by
+ * critical section and with argument 1 to use the lock-free
+ * onesize allocator.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "common/alignment.h"
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "onesize/onesize.h"
+#include "pal/pal.h"
+
+/** The number of allocating tasks */
+#define BENCH_NTASKS 4
+/** The number of memory blocks allocated by a task before freeing them */
+#define BENCH_BURST 4
+/** The number of bursts per task */
+#define BENCH_NBURSTS 200000
+
+static struct am_onesize m_onesize;
+static struct am_onesize_lf m_onesize_lf;
+static uint64_t m_pool[BENCH_NTASKS * BENCH_BURST * 2];
+static bool m_lockfree;
+static int m_ndone;
+
+static void* bench_allocate(void) {
+    if (m_lockfree) {
+        return am_onesize_lf_allocate(&m_onesize_lf);
+    }
+    am_crit_enter();
+    void* ptr = am_onesize_allocate(&m_onesize);
+    am_crit_exit();
+    return ptr;
+}
+
+static void bench_free(const void* ptr) {
+    if (m_lockfree) {
+        am_onesize_lf_free(&m_onesize_lf, ptr);
+        return;
+    }
+    am_crit_enter();
+    am_onesize_free(&m_onesize, ptr);
+    am_crit_exit();
+}
+
+static void bench_task(void* param) {
+    (void)param;
+
+    void* blocks[BENCH_BURST];
+    for (int i = 0; i < BENCH_NBURSTS; ++i) {
+        for (int j = 0; j < BENCH_BURST; ++j) {
+            blocks[j] = bench_allocate();
+        }
+        for (int j = 0; j < BENCH_BURST; ++j) {
+            bench_free(blocks[j]);
+        }
+    }
+    AM_ATOMIC_FETCH_ADD(&m_ndone, 1);
+}
+
+int main(int argc, char* argv[]) {
+    AM_ASSERT(2 == argc);
+    m_lockfree = (0 != atoi(argv[1]));
+
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_onesize_cfg cfg = {
+        .pool = {.ptr = m_pool, .size = (int)sizeof(m_pool)},
+        .block_size = (int)sizeof(m_pool[0]),
+        .alignment = AM_ALIGNOF(am_slist_item_t)
+    };
+    am_onesize_init(&m_onesize, &cfg);
+    am_onesize_lf_init(&m_onesize_lf, &cfg);
+
+    for (int i = 0; i < BENCH_NTASKS; ++i) {
+        am_task_create(
+            "onesize",
+            /*prio=*/i,
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*init=*/NULL,
+            /*entry=*/bench_task,
+            /*flags=*/AM_TASK_FLAG_DETACH | AM_TASK_FLAG_WAIT_INIT,
+            /*arg=*/NULL
+        );
+    }
+
+    uint32_t start_ms = am_time_get_ms();
+    am_task_init_wait();
+    while (AM_ATOMIC_LOAD_N(&m_ndone) < BENCH_NTASKS) {
+        am_sleep_ms(1);
+    }
+    uint32_t elapsed_ms = am_time_get_ms() - start_ms;
+
+    const uint64_t nallocs =
+        (uint64_t)BENCH_NTASKS * BENCH_NBURSTS * BENCH_BURST;
+    am_printf(
+        "lockfree=%d ntasks=%d: %u ns/allocation\n",
+        m_lockfree,
+        BENCH_NTASKS,
+        (unsigned)(elapsed_ms * 1000000ULL / nallocs)
+    );
+
+    am_pal_global_deinit();
+
+    return 0;
+}
@@ -31,22 +31,37 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "common/compiler.h"
 #include "common/macros.h"
 #include "common/alignment.h"
 #include "common/types.h"
 #include "slist/slist.h"
 #include "onesize/onesize.h"
 
-static void am_assert_memptr_validity(
-    const struct am_onesize* hnd, const void* ptr
+/** Lock-free free list head index bit mask. */
+#define AM_ONESIZE_LF_INDEX_MASK 0xFFFFFFFFULL
+
+/** Lock-free free list head modification tag increment. */
+#define AM_ONESIZE_LF_TAG_ONE (AM_ONESIZE_LF_INDEX_MASK + 1ULL)
+
+static void am_assert_memptr_validity_x(
+    const void* pool_beg, const void* pool_end, int block_size, const void* ptr
 ) {
     uintptr_t p = (uintptr_t)ptr;
-    uintptr_t beg = (uintptr_t)hnd->pool_beg;
-    uintptr_t end = (uintptr_t)hnd->pool_end;
+    uintptr_t beg = (uintptr_t)pool_beg;
+    uintptr_t end = (uintptr_t)pool_end;
 
     AM_ASSERT(p >= beg);
     AM_ASSERT(p < end);
-    AM_ASSERT(((p - beg) % (uintptr_t)hnd->block_size) == 0);
+    AM_ASSERT(((p - beg) % (uintptr_t)block_size) == 0);
+}
+
+static void am_assert_memptr_validity(
+    const struct am_onesize* hnd, const void* ptr
+) {
+    am_assert_memptr_validity_x(
+        hnd->pool_beg, hnd->pool_end, hnd->block_size, ptr
+    );
 }
 
 void* am_onesize_allocate_x(struct am_onesize* hnd, int margin) {
@@ -163,8 +178,14 @@ int am_onesize_get_nblocks(const struct am_onesize* hnd) {
     return hnd->ntotal;
 }
 
-void am_onesize_init(struct am_onesize* hnd, const struct am_onesize_cfg* cfg) {
-    AM_ASSERT(hnd);
+/**
+ * Check onesize configuration and return the memory block size.
+ *
+ * @param cfg  configuration
+ *
+ * @return the memory block size [bytes]
+ */
+static int am_onesize_get_cfg_block_size(const struct am_onesize_cfg* cfg) {
     AM_ASSERT(cfg);
     AM_ASSERT(cfg->pool.ptr);
     AM_ASSERT(cfg->pool.size > 0);
@@ -176,13 +197,21 @@ void am_onesize_init(struct am_onesize* hnd, const struct am_onesize_cfg* cfg) {
     int alignment = AM_MAX(cfg->alignment, AM_ALIGNOF(am_slist_item_t));
     AM_ASSERT(AM_ALIGNOF_PTR(cfg->pool.ptr) >= alignment);
 
-    memset(hnd, 0, sizeof(*hnd));
+    int block_size = AM_MAX(cfg->block_size, (int)sizeof(struct am_slist_item));
+    block_size = AM_ALIGN_SIZE(block_size, alignment);
+    AM_ASSERT(cfg->pool.size >= block_size);
 
-    hnd->block_size =
-        AM_MAX(cfg->block_size, (int)sizeof(struct am_slist_item));
-    hnd->block_size = AM_ALIGN_SIZE(hnd->block_size, alignment);
+    return block_size;
+}
+
+void am_onesize_init(struct am_onesize* hnd, const struct am_onesize_cfg* cfg) {
+    AM_ASSERT(hnd);
 
-    AM_ASSERT(cfg->pool.size >= hnd->block_size);
+    int block_size = am_onesize_get_cfg_block_size(cfg);
+
+    memset(hnd, 0, sizeof(*hnd));
+
+    hnd->block_size = block_size;
     hnd->ntotal = cfg->pool.size / hnd->block_size;
     hnd->nfree = hnd->nfree_min = hnd->ntotal;
     hnd->pool_beg = cfg->pool.ptr;
@@ -191,3 +220,179 @@ void am_onesize_init(struct am_onesize* hnd, const struct am_onesize_cfg* cfg) {
 
     am_slist_init(&hnd->fl);
 }
+
+/**
+ * Get memory block of lock-free allocator by its index.
+ *
+ * @param hnd    the allocator
+ * @param index  the memory block index
+ *
+ * @return the memory block
+ */
+static uint32_t* am_onesize_lf_get_block(
+    const struct am_onesize_lf* hnd, uint32_t index
+) {
+    char* ptr = (char*)hnd->pool_beg + ((size_t)hnd->block_size * index);
+    return AM_CAST(uint32_t*, ptr);
+}
+
+/**
+ * Get the next modification tag of lock-free free list head.
+ *
+ * @param head  the free list head
+ *
+ * @return the incremented modification tag with zero index
+ */
+static uint64_t am_onesize_lf_next_tag(uint64_t head) {
+    return (head & ~AM_ONESIZE_LF_INDEX_MASK) + AM_ONESIZE_LF_TAG_ONE;
+}
+
+/**
+ * Pop memory block from lock-free free list.
+ *
+ * @param hnd  the allocator
+ *
+ * @return the memory block or NULL, if the free list is empty
+ */
+static void* am_onesize_lf_pop(struct am_onesize_lf* hnd) {
+    uint64_t head = AM_ATOMIC_LOAD_N(&hnd->head);
+    for (;;) {
+        uint32_t top = (uint32_t)(head & AM_ONESIZE_LF_INDEX_MASK);
+        if (0 == top) {
+            return NULL;
+        }
+        uint32_t* block = am_onesize_lf_get_block(hnd, top - 1U);
+        /*
+         * The block might be popped and overwritten concurrently.
+         * Then the free list head tag is changed and the below
+         * compare and exchange fails.
+         */
+        uint32_t next = AM_ATOMIC_LOAD_N(block);
+        uint64_t tag = am_onesize_lf_next_tag(head);
+        if (AM_ATOMIC_COMPARE_EXCHANGE_N(&hnd->head, &head, tag | next)) {
+            return block;
+        }
+    }
+}
+
+/**
+ * Push memory block to lock-free free list.
+ *
+ * @param hnd  the allocator
+ * @param ptr  the memory block
+ */
+static void am_onesize_lf_push(struct am_onesize_lf* hnd, void* ptr) {
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)hnd->pool_beg;
+    uint32_t top = (uint32_t)(offset / (uintptr_t)hnd->block_size) + 1U;
+    uint32_t* block = AM_CAST(uint32_t*, ptr);
+
+    uint64_t head = AM_ATOMIC_LOAD_N(&hnd->head);
+    uint64_t desired = 0;
+    do {
+        AM_ATOMIC_STORE_N(block, (uint32_t)(head & AM_ONESIZE_LF_INDEX_MASK));
+        uint64_t tag = am_onesize_lf_next_tag(head);
+        desired = tag | top;
+    } while (!AM_ATOMIC_COMPARE_EXCHANGE_N(&hnd->head, &head, desired));
+}
+
+void* am_onesize_lf_allocate_x(struct am_onesize_lf* hnd, int margin) {
+    AM_ASSERT(hnd);
+    AM_ASSERT(margin >= 0);
+
+    /* reserve one free memory block */
+    int nfree = AM_ATOMIC_LOAD_N(&hnd->nfree);
+    do {
+        if (nfree <= margin) {
+            return NULL;
+        }
+    } while (!AM_ATOMIC_COMPARE_EXCHANGE_N(&hnd->nfree, &nfree, nfree - 1));
+
+    --nfree;
+    int nfree_min = AM_ATOMIC_LOAD_N(&hnd->nfree_min);
+    while (nfree < nfree_min) {
+        if (AM_ATOMIC_COMPARE_EXCHANGE_N(&hnd->nfree_min, &nfree_min, nfree)) {
+            break;
+        }
+    }
+
+    /*
+     * The reserved memory block is either in the free list or
+     * not bump allocated yet. The free list can look empty temporarily,
+     * if the memory block is being freed concurrently.
+     */
+    for (;;) {
+        void* ptr = am_onesize_lf_pop(hnd);
+        if (ptr) {
+            am_assert_memptr_validity_x(
+                hnd->pool_beg, hnd->pool_end, hnd->block_size, ptr
+            );
+            return ptr;
+        }
+        int nbump = AM_ATOMIC_LOAD_N(&hnd->nbump);
+        while (nbump < hnd->ntotal) {
+            if (AM_ATOMIC_COMPARE_EXCHANGE_N(&hnd->nbump, &nbump, nbump + 1)) {
+                return am_onesize_lf_get_block(hnd, (uint32_t)nbump);
+            }
+        }
+    }
+}
+
+void* am_onesize_lf_allocate(struct am_onesize_lf* hnd) {
+    void* ptr = am_onesize_lf_allocate_x(hnd, /*margin=*/0);
+    AM_ASSERT(ptr);
+    return ptr;
+}
+
+void am_onesize_lf_free(struct am_onesize_lf* hnd, const void* ptr) {
+    AM_ASSERT(hnd);
+    AM_ASSERT(ptr);
+
+    /* make sure the provided pointer is valid */
+    am_assert_memptr_validity_x(
+        hnd->pool_beg, hnd->pool_end, hnd->block_size, ptr
+    );
+
+    /*
+     * Push the memory block first and only then release it.
+     * So, the reserved memory blocks are always available.
+     */
+    am_onesize_lf_push(hnd, AM_CAST(void*, ptr));
+    int nfree = AM_ATOMIC_FETCH_ADD(&hnd->nfree, 1);
+    AM_ASSERT(nfree < hnd->ntotal); /* double free? */
+}
+
+int am_onesize_lf_get_nfree(const struct am_onesize_lf* hnd) {
+    AM_ASSERT(hnd);
+    return AM_ATOMIC_LOAD_N(&hnd->nfree);
+}
+
+int am_onesize_lf_get_nfree_min(const struct am_onesize_lf* hnd) {
+    AM_ASSERT(hnd);
+    return AM_ATOMIC_LOAD_N(&hnd->nfree_min);
+}
+
+int am_onesize_lf_get_block_size(const struct am_onesize_lf* hnd) {
+    AM_ASSERT(hnd);
+    return hnd->block_size;
+}
+
+int am_onesize_lf_get_nblocks(const struct am_onesize_lf* hnd) {
+    AM_ASSERT(hnd);
+    return hnd->ntotal;
+}
+
+void am_onesize_lf_init(
+    struct am_onesize_lf* hnd, const struct am_onesize_cfg* cfg
+) {
+    AM_ASSERT(hnd);
+
+    int block_size = am_onesize_get_cfg_block_size(cfg);
+
+    memset(hnd, 0, sizeof(*hnd));
+
+    hnd->block_size = block_size;
+    hnd->ntotal = cfg->pool.size / hnd->block_size;
+    hnd->nfree = hnd->nfree_min = hnd->ntotal;
+    hnd->pool_beg = cfg->pool.ptr;
+    hnd->pool_end = (char*)cfg->pool.ptr + (hnd->ntotal * hnd->block_size);
+}
@@ -32,6 +32,8 @@
 #ifndef AM_ONESIZE_H_INCLUDED
 #define AM_ONESIZE_H_INCLUDED
 
+#include <stdint.h>
+
 #include "common/alignment.h"
 #include "common/macros.h"
 #include "common/types.h"
@@ -52,6 +54,30 @@ struct am_onesize {
     int nbump;     /**< bump index */
 };
 
+/**
+ * Lock-free onesize memory allocator descriptor.
+ *
+ * The free list is a Treiber stack of memory block indices.
+ * The free list head packs the index of the top memory block and
+ * a modification tag into one 64 bit word. The tag is incremented
+ * on every free list update, which prevents the ABA problem.
+ */
+struct am_onesize_lf {
+    void* pool_beg; /**< the pool memory begin  */
+    void* pool_end; /**< the pool memory end */
+    int block_size; /**< maximum size of allocated block [bytes] */
+    int ntotal;     /**< total number of blocks */
+    /**
+     * Free list head.
+     * Modification tag (high 32 bits) and the top memory block
+     * index plus one (low 32 bits). Zero index means empty free list.
+     */
+    uint64_t head;
+    int nfree;     /**< current number of free blocks */
+    int nfree_min; /**< minimum free blocks observed since initialization */
+    int nbump;     /**< bump index */
+};
+
 /** Onesize configuration. */
 struct am_onesize_cfg {
     /** The memory pool. */
@@ -190,6 +216,95 @@ int am_onesize_get_block_size(const struct am_onesize* hnd);
  */
 int am_onesize_get_nblocks(const struct am_onesize* hnd);
 
+/**
+ * Initialize a new lock-free onesize allocator.
+ *
+ * Same as am_onesize_init(), but the allocator can be used from
+ * several tasks and interrupts concurrently without critical section.
+ *
+ * Requires lock-free 64 bit atomic operations.
+ *
+ * @param hnd  the allocator
+ * @param cfg  configuration
+ */
+void am_onesize_lf_init(
+    struct am_onesize_lf* hnd, const struct am_onesize_cfg* cfg
+);
+
+/**
+ * Allocate memory block of configured block size (eXtended version).
+ *
+ * Checks if there are more free memory blocks available than @p margin.
+ * If not, then returns NULL. Otherwise allocates memory block and returns it.
+ *
+ * Thread safe. Lock-free.
+ *
+ * @param hnd     the allocator
+ * @param margin  free memory blocks to remain available after the allocation
+ *
+ * @return the allocated memory or NULL, if allocation failed
+ */
+void* am_onesize_lf_allocate_x(struct am_onesize_lf* hnd, int margin);
+
+/**
+ * Allocate one memory block of configured block size.
+ *
+ * Asserts, if no free memory block is available.
+ *
+ * Thread safe. Lock-free.
+ *
+ * @param hnd  the allocator
+ *
+ * @return the allocated memory
+ */
+void* am_onesize_lf_allocate(struct am_onesize_lf* hnd);
+
+/**
+ * Free a memory block.
+ *
+ * Thread safe. Lock-free.
+ *
+ * @param hnd  the allocator
+ * @param ptr  memory block to free
+ */
+void am_onesize_lf_free(struct am_onesize_lf* hnd, const void* ptr);
+
+/**
+ * Return the number of free blocks available for allocation.
+ *
+ * @param hnd  the allocator
+ *
+ * @return the number of free blocks
+ */
+int am_onesize_lf_get_nfree(const struct am_onesize_lf* hnd);
+
+/**
+ * The minimum number of free memory blocks observed so far.
+ *
+ * @param hnd  the allocator
+ *
+ * @return the minimum number of free memory blocks observed so far
+ */
+int am_onesize_lf_get_nfree_min(const struct am_onesize_lf* hnd);
+
+/**
+ * Return the memory block size.
+ *
+ * @param hnd  the allocator
+ *
+ * @return the block size [bytes]
+ */
+int am_onesize_lf_get_block_size(const struct am_onesize_lf* hnd);
+
+/**
+ * Get total number of memory blocks - the total capacity of the allocator.
+ *
+ * @param hnd  the allocator
+ *
+ * @return the total number of memory blocks
+ */
+int am_onesize_lf_get_nblocks(const struct am_onesize_lf* hnd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,7 +33,54 @@
 #include "common/alignment.h"
 #include "onesize/onesize.h"
 
+static void test_am_onesize_lf(void) {
+    struct am_onesize_lf ma;
+    static struct test_lf {
+        int a;
+        unsigned* b;
+    } test_arr[3];
+
+    struct am_onesize_cfg cfg = {
+        .pool = {.ptr = &test_arr[0], .size = sizeof(test_arr)},
+        .block_size = sizeof(struct test_lf),
+        .alignment = AM_ALIGN_MAX
+    };
+    am_onesize_lf_init(&ma, &cfg);
+
+    AM_ASSERT(am_onesize_lf_get_nblocks(&ma) == 3);
+    AM_ASSERT(am_onesize_lf_get_nfree(&ma) == 3);
+
+    const void* ptr1 = am_onesize_lf_allocate(&ma);
+    AM_ASSERT(ptr1 == &test_arr[0]);
+    const void* ptr2 = am_onesize_lf_allocate_x(&ma, /*margin=*/1);
+    AM_ASSERT(ptr2 == &test_arr[1]);
+    AM_ASSERT(!am_onesize_lf_allocate_x(&ma, /*margin=*/1));
+    AM_ASSERT(am_onesize_lf_get_nfree(&ma) == 1);
+
+    /* the freed memory blocks are reused in LIFO order */
+    am_onesize_lf_free(&ma, ptr1);
+    am_onesize_lf_free(&ma, ptr2);
+    AM_ASSERT(am_onesize_lf_get_nfree(&ma) == 3);
+    AM_ASSERT(am_onesize_lf_allocate(&ma) == ptr2);
+    AM_ASSERT(am_onesize_lf_allocate(&ma) == ptr1);
+
+    const void* ptr3 = am_onesize_lf_allocate(&ma);
+    AM_ASSERT(ptr3 == &test_arr[2]);
+    AM_ASSERT(!am_onesize_lf_allocate_x(&ma, /*margin=*/0));
+    AM_ASSERT(am_onesize_lf_get_nfree(&ma) == 0);
+
+    am_onesize_lf_free(&ma, ptr3);
+    AM_ASSERT(am_onesize_lf_allocate(&ma) == ptr3);
+    am_onesize_lf_free(&ma, ptr1);
+    am_onesize_lf_free(&ma, ptr2);
+    am_onesize_lf_free(&ma, ptr3);
+    AM_ASSERT(am_onesize_lf_get_nfree(&ma) == 3);
+    AM_ASSERT(am_onesize_lf_get_nfree_min(&ma) == 0);
+}
+
 int main(void) {
+    test_am_onesize_lf();
+
     struct am_onesize ma;
     struct test {
         int a;
@@ -0,0 +1,126 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Lock-free onesize allocator stress test.
+ *
+ * Several tasks allocate and free memory blocks of one small lock-free
+ * onesize allocator concurrently. Each task marks its memory blocks
+ * and checks the marks before freeing the memory blocks. So, a memory
+ * block allocated to two tasks at the same time is detected.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/alignment.h"
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "onesize/onesize.h"
+#include "pal/pal.h"
+
+/** The number of allocating tasks */
+#define TEST_NTASKS 4
+/** The number of memory blocks allocated by a task before freeing them */
+#define TEST_BURST 3
+/** The number of bursts per task */
+#define TEST_NBURSTS 300000
+
+struct test_block {
+    uint32_t owner;
+    uint32_t seq;
+};
+
+static struct am_onesize_lf m_onesize;
+static struct test_block m_pool[TEST_NTASKS * 2];
+static int m_ndone;
+
+static void test_task(void* param) {
+    uint32_t owner = (uint32_t)(uintptr_t)param;
+
+    struct test_block* blocks[TEST_BURST];
+    for (uint32_t i = 0; i < TEST_NBURSTS; ++i) {
+        int n = 0;
+        for (; n < TEST_BURST; ++n) {
+            blocks[n] = am_onesize_lf_allocate_x(&m_onesize, /*margin=*/0);
+            if (!blocks[n]) {
+                break;
+            }
+            blocks[n]->owner = owner;
+            blocks[n]->seq = i;
+        }
+        for (int j = 0; j < n; ++j) {
+            AM_ASSERT(owner == blocks[j]->owner);
+            AM_ASSERT(i == blocks[j]->seq);
+            am_onesize_lf_free(&m_onesize, blocks[j]);
+        }
+    }
+    AM_ATOMIC_FETCH_ADD(&m_ndone, 1);
+}
+
+int main(void) {
+    am_pal_global_init(/*arg=*/NULL);
+
+    struct am_onesize_cfg cfg = {
+        .pool = {.ptr = m_pool, .size = (int)sizeof(m_pool)},
+        .block_size = (int)sizeof(m_pool[0]),
+        .alignment = AM_ALIGNOF(am_slist_item_t)
+    };
+    am_onesize_lf_init(&m_onesize, &cfg);
+    const int nblocks = am_onesize_lf_get_nblocks(&m_onesize);
+
+    for (int i = 0; i < TEST_NTASKS; ++i) {
+        am_task_create(
+            "stress",
+            /*prio=*/i,
+            /*stack=*/NULL,
+            /*stack_size=*/0,
+            /*init=*/NULL,
+            /*entry=*/test_task,
+            /*flags=*/AM_TASK_FLAG_DETACH | AM_TASK_FLAG_WAIT_INIT,
+            /*arg=*/(void*)(uintptr_t)(i + 1)
+        );
+    }
+    am_task_init_wait();
+    while (AM_ATOMIC_LOAD_N(&m_ndone) < TEST_NTASKS) {
+        am_sleep_ms(1);
+    }
+
+    AM_ASSERT(nblocks == am_onesize_lf_get_nfree(&m_onesize));
+    AM_ASSERT(am_onesize_lf_get_nfree_min(&m_onesize) >= 0);
+
+    /* all memory blocks are in the free list and none is lost */
+    for (int i = 0; i < nblocks; ++i) {
+        AM_ASSERT(am_onesize_lf_allocate(&m_onesize));
+    }
+    AM_ASSERT(!am_onesize_lf_allocate_x(&m_onesize, /*margin=*/0));
+
+    am_pal_global_deinit();
+
+    return 0;
+}
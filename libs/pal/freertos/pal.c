@@ -131,6 +131,16 @@ void am_task_wait(int task_id) {
     }
 }
 
+bool am_task_wait_timeout(int task_id, uint32_t timeout_ms) {
+    (void)task_id;
+    AM_ASSERT(!xPortIsInsideInterrupt());
+    uint32_t cnt = ulTaskNotifyTake(
+        /*xClearCountOnExit=*/pdTRUE,
+        /*xTicksToWait=*/pdMS_TO_TICKS(timeout_ms)
+    );
+    return cnt > 0;
+}
+
 uint32_t am_time_get_ms(void) {
     uint32_t ticks = am_time_get_ticks();
     return ticks * portTICK_PERIOD_MS;
@@ -144,6 +154,15 @@ uint32_t am_time_get_ticks(int timebase) {
     return (uint32_t)xTaskGetTickCount();
 }
 
+uint64_t am_time_get_ticks64(int timebase) {
+    return am_time_get_ticks(timebase);
+}
+
+uint64_t am_time_get_ns_from_ticks(int timebase, uint64_t ticks) {
+    AM_ASSERT(AM_TIMEBASE_DEFAULT == timebase);
+    return ticks * portTICK_PERIOD_MS * 1000000;
+}
+
 uint32_t am_time_get_ticks_from_ms(int timebase, uint32_t ms) {
     (void)timebase;
     if (0 == ms) {
@@ -81,11 +81,6 @@ struct am_mutex {
 static uv_loop_t* loop_;
 static uv_mutex_t crit_section_;
 
-/** Maximum number of mutexes */
-#ifndef AM_PAL_MUTEX_NUM_MAX
-#define AM_PAL_MUTEX_NUM_MAX 2
-#endif
-
 static struct am_mutex mutexes_[AM_PAL_MUTEX_NUM_MAX];
 
 static struct am_task task_main_ = {0};
@@ -332,6 +327,25 @@ void am_task_wait(int task_id) {
     uv_sem_wait(&t->semaphore);
 }
 
+bool am_task_wait_timeout(int task_id, uint32_t timeout_ms) {
+    if (AM_TASK_ID_NONE == task_id) {
+        task_id = am_task_get_own_id();
+    }
+    AM_ASSERT(task_id != AM_TASK_ID_NONE);
+
+    /* libuv semaphores have no timed wait */
+    struct am_task* t = am_task_get_hnd(task_id);
+    for (uint32_t ms = 0;; ++ms) {
+        if (0 == uv_sem_trywait(&t->semaphore)) {
+            return true;
+        }
+        if (ms >= timeout_ms) {
+            return false;
+        }
+        uv_sleep(/*msec=*/1);
+    }
+}
+
 int am_task_get_own_id(void) {
     uv_thread_t thread = uv_thread_self();
     if (task_main_.thread == thread) {
@@ -348,30 +362,66 @@ int am_task_get_own_id(void) {
     return AM_TASK_ID_NONE;
 }
 
+/**
+ * Get the number of nanoseconds per tick of timebase.
+ *
+ * @param timebase  the timebase
+ *
+ * @return the number of nanoseconds per tick
+ */
+static uint32_t am_timebase_get_ns(int timebase) {
+    switch (timebase) {
+    case AM_TIMEBASE_DEFAULT:
+        return 1000000;
+    case AM_TIMEBASE_US:
+        return 1000;
+    case AM_TIMEBASE_NS:
+        return 1;
+    default:
+        AM_ASSERT(0);
+    }
+    return 0;
+}
+
 uint32_t am_time_get_ms(void) {
     uv_update_time(loop_);
     return (uint32_t)uv_now(loop_);
 }
 
+uint64_t am_time_get_ticks64(int timebase) {
+    if (AM_TIMEBASE_DEFAULT == timebase) {
+        uv_update_time(loop_);
+        return uv_now(loop_);
+    }
+    return uv_hrtime() / am_timebase_get_ns(timebase);
+}
+
 uint32_t am_time_get_ticks(int timebase) {
-    (void)timebase;
-    return am_time_get_ms();
+    return (uint32_t)am_time_get_ticks64(timebase);
+}
+
+uint64_t am_time_get_ns_from_ticks(int timebase, uint64_t ticks) {
+    return ticks * am_timebase_get_ns(timebase);
 }
 
 uint32_t am_time_get_ticks_from_ms(int timebase, uint32_t ms) {
-    (void)timebase;
-    return ms;
+    uint64_t ns = (uint64_t)ms * 1000000;
+    uint64_t ticks = ns / am_timebase_get_ns(timebase);
+    /* saturates for sub-millisecond timebases */
+    return (uint32_t)AM_MIN(ticks, UINT32_MAX);
 }
 
 uint32_t am_time_get_ms_from_ticks(int timebase, uint32_t ticks) {
-    (void)timebase;
-    return ticks;
+    uint64_t ns = am_time_get_ns_from_ticks(timebase, ticks);
+    return (uint32_t)(ns / 1000000);
 }
 
 void am_sleep_ticks(int timebase, uint32_t ticks) {
-    (void)timebase;
-    AM_ASSERT(ticks <= UINT_MAX);
-    uv_sleep((unsigned)ticks);
+    /* libuv sleeps with millisecond resolution */
+    uint64_t ns = am_time_get_ns_from_ticks(timebase, ticks);
+    uint64_t ms = AM_DIV_CEIL(ns, 1000000);
+    AM_ASSERT(ms <= UINT_MAX);
+    uv_sleep((unsigned)ms);
 }
 
 void am_sleep_till_ticks(int timebase, uint32_t ticks) {
@@ -541,7 +591,10 @@ static void am_ticker_task(void* arg) {
             break;
         }
 
-        if (ticker->cfg.ticker_cb != NULL) {
+        if (ticker->cfg.tickless_cb != NULL) {
+            /* no tickless mode support: tick every tick */
+            (void)ticker->cfg.tickless_cb(ticker->cfg.ctx, /*ticks=*/1);
+        } else if (ticker->cfg.ticker_cb != NULL) {
             ticker->cfg.ticker_cb(ticker->cfg.ctx);
         }
     }
@@ -549,7 +602,7 @@ static void am_ticker_task(void* arg) {
 
 int am_ticker_create(const struct am_ticker_cfg* cfg) {
     AM_ASSERT(cfg);
-    AM_ASSERT(cfg->ticker_cb);
+    AM_ASSERT(cfg->ticker_cb || cfg->tickless_cb);
 
     struct am_ticker* ticker = &tickers[0];
 
@@ -559,7 +612,7 @@ int am_ticker_create(const struct am_ticker_cfg* cfg) {
     ticker->busy = true;
     ticker->cfg = *cfg;
     ticker->period_ns =
-        (long)(NSEC_PER_MSEC * am_time_get_ms_from_ticks(cfg->timebase, 1));
+        (long)am_time_get_ns_from_ticks(cfg->timebase, /*ticks=*/1);
     AM_ASSERT(ticker->period_ns > 0);
 
     return am_pal_id_from_index(0);
@@ -603,3 +656,5 @@ void am_ticker_stop(int ticker_id) {
 
     ticker->task_id = AM_TASK_ID_NONE;
 }
+
+void am_ticker_notify(int ticker_id) { (void)ticker_id; }
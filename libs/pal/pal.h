@@ -37,8 +37,20 @@
 #include <stdarg.h>
 #include <stdbool.h>
 
+#ifndef AM_TASK_NUM_MAX
 /** Maximum number of PAL tasks. */
 #define AM_TASK_NUM_MAX 64
+#endif
+
+#ifndef AM_PAL_MUTEX_NUM_MAX
+/**
+ * Maximum number of PAL mutexes.
+ *
+ * PAL uses one mutex. Cooperative port of active objects uses one
+ * mutex per scheduler thread, if there are several of them.
+ */
+#define AM_PAL_MUTEX_NUM_MAX 32
+#endif
 
 /** Invalid task ID. */
 #define AM_TASK_ID_NONE 0
@@ -58,6 +70,18 @@
 /** Default timebase. */
 #define AM_TIMEBASE_DEFAULT 0
 
+/**
+ * Microsecond timebase.
+ * Supported by posix, libuv and stubs PALs.
+ */
+#define AM_TIMEBASE_US 1
+
+/**
+ * Nanosecond timebase.
+ * Supported by posix, libuv and stubs PALs.
+ */
+#define AM_TIMEBASE_NS 2
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -178,6 +202,17 @@ void am_task_notify(int task_id);
  */
 void am_task_wait(int task_id);
 
+/**
+ * Block PAL task till am_task_notify() is called or timeout expires.
+ *
+ * @param task_id     the task ID returned by am_task_create()
+ * @param timeout_ms  the timeout [ms]
+ *
+ * @retval true   the task was notified
+ * @retval false  the timeout expired
+ */
+bool am_task_wait_timeout(int task_id, uint32_t timeout_ms);
+
 /**
  * Return task own ID.
  *
@@ -208,13 +243,42 @@ uint32_t am_time_get_ms(void);
  *
  * @param timebase  timebase
  *
- * @return current time [tick]
+ * @return current time [tick]. The lower 32 bits of am_time_get_ticks64().
  */
 uint32_t am_time_get_ticks(int timebase);
 
+/**
+ * Get current time in ticks as 64 bit value.
+ *
+ * The 32 bit ticks of the microsecond and nanosecond timebases
+ * wrap around in about 71 minutes and 4 seconds respectively.
+ * The 64 bit ticks do not wrap around in practice.
+ *
+ * @param timebase  timebase
+ *
+ * @return current time [tick]
+ */
+uint64_t am_time_get_ticks64(int timebase);
+
+/**
+ * Convert ticks from the given timebase to nanoseconds.
+ *
+ * Used to configure tickers of sub-millisecond timebases.
+ *
+ * @param timebase  timebase
+ * @param ticks     ticks to convert
+ *
+ * @return time [ns]
+ */
+uint64_t am_time_get_ns_from_ticks(int timebase, uint64_t ticks);
+
 /**
  * Convert ms to ticks for the given ticker identifier.
  *
+ * The result saturates to UINT32_MAX, if it does not fit 32 bits.
+ * This happens for #AM_TIMEBASE_NS above 4294 ms and for
+ * #AM_TIMEBASE_US above 4294967 ms.
+ *
  * @param timebase  timebase [0, INT_MAX[
  * @param ms      milliseconds to convert
  *
@@ -337,13 +401,40 @@ int am_get_cpu_count(void);
 
 /** Ticker configuration */
 struct am_ticker_cfg {
-    /** ticker timebase */
+    /**
+     * ticker timebase.
+     * The ticker ticks once per tick of the timebase.
+     * Sub-millisecond timebases (#AM_TIMEBASE_US, #AM_TIMEBASE_NS)
+     * are best used with tickless ticker (see am_ticker_cfg::tickless_cb).
+     */
     int timebase;
     /**
      * ticker callback
      * @param ctx  callback context
      */
     void (*ticker_cb)(void* ctx);
+    /**
+     * Tickless ticker callback (optional).
+     *
+     * If set, the ticker does not tick periodically and
+     * am_ticker_cfg::ticker_cb is not used. Instead the ticker sleeps
+     * till the next deadline returned by the callback or
+     * till am_ticker_notify() is called, whichever comes first.
+     * Then the callback is called with the number of ticks elapsed
+     * since the previous call.
+     *
+     * The PALs with no tickless ticker support call the callback
+     * every tick with one tick elapsed.
+     *
+     * @param ctx    callback context
+     * @param ticks  the number of ticks elapsed since the previous call.
+     *               0 for the first call and if am_ticker_notify() was
+     *               called within the same tick.
+     *
+     * @return the number of ticks till the next deadline or 0,
+     *         if there is no deadline
+     */
+    uint32_t (*tickless_cb)(void* ctx, uint32_t ticks);
     /** ticker context */
     void* ctx;
     /** ticker thread platform specific priority hint (optional) */
@@ -373,6 +464,18 @@ void am_ticker_start(int ticker_id);
  */
 void am_ticker_stop(int ticker_id);
 
+/**
+ * Wake up tickless ticker.
+ *
+ * The tickless ticker calls am_ticker_cfg::tickless_cb() to get
+ * the new next deadline.
+ * To be called, when a timer event was armed (see am_timer_register_arm_cb()).
+ * Does nothing for periodic tickers.
+ *
+ * @param ticker_id  ticker ID returned by am_ticker_create()
+ */
+void am_ticker_notify(int ticker_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -90,6 +90,14 @@ struct am_task {
 
 static struct am_task task_main_ = {0};
 static struct am_task am_tasks_[AM_TASK_NUM_MAX] = {0};
+/** The task of the calling thread (see am_task_get_own_id()) */
+static pthread_key_t am_task_key_;
+static pthread_once_t am_task_key_once_ = PTHREAD_ONCE_INIT;
+
+static void am_task_key_create(void) {
+    int rc = pthread_key_create(&am_task_key_, /*destructor=*/NULL);
+    AM_ASSERT(0 == rc);
+}
 static int init_complete_mutex_;
 static int init_complete_mutex_acquired_;
 
@@ -101,11 +109,6 @@ struct am_mutex {
     bool valid;
 };
 
-/** Maximum number of mutexes */
-#ifndef AM_PAL_MUTEX_NUM_MAX
-#define AM_PAL_MUTEX_NUM_MAX 2
-#endif
-
 static struct am_mutex am_mutexes_[AM_PAL_MUTEX_NUM_MAX] = {0};
 
 static int am_pal_index_from_id(int id) {
@@ -141,6 +144,9 @@ static void* thread_entry_wrapper(void* arg) {
     struct am_task* task = (struct am_task*)arg;
     AM_ASSERT(task->entry);
 
+    int rc = pthread_setspecific(am_task_key_, task);
+    AM_ASSERT(0 == rc);
+
     AM_ATOMIC_STORE_N(&task->running, true);
 
     if (task->init) {
@@ -152,7 +158,7 @@ static void* thread_entry_wrapper(void* arg) {
 
     task->entry(task->arg);
 
-    int rc = pthread_mutex_destroy(&task->mutex);
+    rc = pthread_mutex_destroy(&task->mutex);
     AM_ASSERT(0 == rc);
 
     if (!AM_ATOMIC_LOAD_N(&task->joinable)) {
@@ -182,6 +188,14 @@ void am_crit_exit(void) {
 }
 
 int am_task_get_own_id(void) {
+    const struct am_task* task = pthread_getspecific(am_task_key_);
+    if (task == &task_main_) {
+        return AM_TASK_ID_MAIN;
+    }
+    if (task) {
+        return am_pal_id_from_index((int)(task - am_tasks_));
+    }
+    /* the thread was not created by am_task_create() */
     pthread_t thread = pthread_self();
     if (task_main_.thread == thread) {
         return AM_TASK_ID_MAIN;
@@ -197,6 +211,7 @@ int am_task_get_own_id(void) {
 }
 
 static void am_mutex_init(pthread_mutex_t* me);
+static void am_cond_init(pthread_cond_t* me);
 
 int am_task_create(
     const char* name,
@@ -226,12 +241,10 @@ int am_task_create(
     AM_ASSERT(index >= 0);
 
     am_mutex_init(&task->mutex);
-
-    int ret = pthread_cond_init(&task->cond, /*attr=*/NULL);
-    AM_ASSERT(0 == ret);
+    am_cond_init(&task->cond);
 
     pthread_attr_t attr;
-    ret = pthread_attr_init(&attr);
+    int ret = pthread_attr_init(&attr);
     AM_ASSERT(0 == ret);
 
     ret = pthread_attr_setstacksize(
@@ -303,6 +316,53 @@ void am_task_wait(int task_id) {
     pthread_mutex_unlock(&t->mutex);
 }
 
+bool am_task_wait_timeout(int task_id, uint32_t timeout_ms) {
+    if (AM_TASK_ID_NONE == task_id) {
+        task_id = am_task_get_own_id();
+    }
+    AM_ASSERT(task_id != AM_TASK_ID_NONE);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += (time_t)(timeout_ms / 1000U);
+    deadline.tv_nsec += (long)(timeout_ms % 1000U) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_nsec -= 1000000000L;
+        ++deadline.tv_sec;
+    }
+
+    struct am_task* t = am_task_get_hnd(task_id);
+    pthread_mutex_lock(&t->mutex);
+    int rc = 0;
+    while (!AM_ATOMIC_LOAD_N(&t->notified) && (ETIMEDOUT != rc)) {
+        rc = pthread_cond_timedwait(&t->cond, &t->mutex, &deadline);
+    }
+    bool notified = AM_ATOMIC_EXCHANGE_N(&t->notified, false);
+    pthread_mutex_unlock(&t->mutex);
+
+    return notified;
+}
+
+/**
+ * Initialize task condition variable.
+ *
+ * The condition variable uses monotonic clock for timed waits.
+ *
+ * @param me  the condition variable
+ */
+static void am_cond_init(pthread_cond_t* me) {
+    AM_ASSERT(me);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+    int rc = pthread_cond_init(me, &attr);
+    AM_ASSERT(0 == rc);
+
+    pthread_condattr_destroy(&attr);
+}
+
 static void am_mutex_init(pthread_mutex_t* me) {
     AM_ASSERT(me);
 
@@ -359,34 +419,72 @@ void am_mutex_destroy(int mutex) {
     am_mutexes_[mutex].valid = false;
 }
 
+#define NSEC_PER_SEC 1000000000L
+#define NSEC_PER_MSEC 1000000L
+
+/**
+ * Get the number of nanoseconds per tick of timebase.
+ *
+ * @param timebase  the timebase
+ *
+ * @return the number of nanoseconds per tick
+ */
+static uint32_t am_timebase_get_ns(int timebase) {
+    switch (timebase) {
+    case AM_TIMEBASE_DEFAULT:
+        return NSEC_PER_MSEC;
+    case AM_TIMEBASE_US:
+        return 1000;
+    case AM_TIMEBASE_NS:
+        return 1;
+    default:
+        AM_ASSERT(0);
+    }
+    return 0;
+}
+
 uint32_t am_time_get_ms(void) {
+    return (uint32_t)am_time_get_ticks64(AM_TIMEBASE_DEFAULT);
+}
+
+uint64_t am_time_get_ticks64(int timebase) {
+    const uint32_t ns_per_tick = am_timebase_get_ns(timebase);
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    long ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-    return (uint32_t)ms;
+    uint64_t ns = (uint64_t)ts.tv_sec * NSEC_PER_SEC + (uint64_t)ts.tv_nsec;
+    return ns / ns_per_tick;
 }
 
 uint32_t am_time_get_ticks(int timebase) {
-    AM_ASSERT(AM_TIMEBASE_DEFAULT == timebase);
-    return am_time_get_ms();
+    return (uint32_t)am_time_get_ticks64(timebase);
+}
+
+uint64_t am_time_get_ns_from_ticks(int timebase, uint64_t ticks) {
+    return ticks * am_timebase_get_ns(timebase);
 }
 
 uint32_t am_time_get_ticks_from_ms(int timebase, uint32_t ms) {
-    AM_ASSERT(AM_TIMEBASE_DEFAULT == timebase);
-    return ms;
+    uint64_t ns = (uint64_t)ms * NSEC_PER_MSEC;
+    uint64_t ticks = ns / am_timebase_get_ns(timebase);
+    /* saturates for sub-millisecond timebases */
+    return (uint32_t)AM_MIN(ticks, UINT32_MAX);
 }
 
 uint32_t am_time_get_ms_from_ticks(int timebase, uint32_t ticks) {
-    AM_ASSERT(AM_TIMEBASE_DEFAULT == timebase);
-    return ticks;
+    uint64_t ns = am_time_get_ns_from_ticks(timebase, ticks);
+    return (uint32_t)(ns / NSEC_PER_MSEC);
 }
 
 void am_sleep_ticks(int timebase, uint32_t ticks) {
-    AM_ASSERT(AM_TIMEBASE_DEFAULT == timebase);
     if (0 == ticks) {
         return;
     }
-    am_sleep_ms(ticks);
+    uint64_t ns = am_time_get_ns_from_ticks(timebase, ticks);
+    struct timespec ts = {
+        .tv_sec = (time_t)(ns / NSEC_PER_SEC),
+        .tv_nsec = (long)(ns % NSEC_PER_SEC)
+    };
+    nanosleep(&ts, /*rmtp=*/NULL);
 }
 
 void am_sleep_ms(uint32_t ms) {
@@ -415,8 +513,7 @@ void am_sleep_till_ticks(int timebase, uint32_t ticks) {
     if ((0 == sleep_ticks) || (sleep_ticks > UINT32_MAX / 2)) {
         return;
     }
-    useconds_t us = (useconds_t)sleep_ticks * 1000UL;
-    usleep(us);
+    am_sleep_ticks(timebase, sleep_ticks);
 }
 
 int am_vprintf(const char* fmt, va_list args) {
@@ -473,11 +570,14 @@ void* am_pal_global_init(void* arg) {
 
     task->thread = pthread_self();
     am_mutex_init(&task->mutex);
-
-    int ret = pthread_cond_init(&task->cond, /*attr=*/NULL);
-    AM_ASSERT(0 == ret);
+    am_cond_init(&task->cond);
     AM_ATOMIC_STORE_N(&task->running, true);
 
+    int rc = pthread_once(&am_task_key_once_, am_task_key_create);
+    AM_ASSERT(0 == rc);
+    rc = pthread_setspecific(am_task_key_, task);
+    AM_ASSERT(0 == rc);
+
     init_complete_mutex_ = am_mutex_create();
     am_mutex_lock(init_complete_mutex_);
     init_complete_mutex_acquired_ = true;
@@ -564,8 +664,6 @@ void am_task_init_wait(void) {
     am_mutex_unlock(init_complete_mutex_);
 }
 
-#define NSEC_PER_SEC 1000000000L
-
 /** Ticker handler */
 struct am_ticker {
     /** ticker identifier */
@@ -591,9 +689,67 @@ static void timespec_add_ns(struct timespec* ts, long ns) {
     }
 }
 
+/**
+ * Tickless ticker thread.
+ *
+ * Sleeps till the next deadline returned by am_ticker_cfg::tickless_cb()
+ * or till am_ticker_notify() call.
+ * The elapsed ticks are counted from the tick boundaries, so the ticks
+ * do not drift regardless of the wake up times.
+ *
+ * @param ticker  the ticker
+ */
+static void am_ticker_task_tickless(struct am_ticker* ticker) {
+    struct am_task* task = am_task_get_hnd(am_task_get_own_id());
+    const int64_t period_ns = ticker->period_ns;
+
+    struct timespec last;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+    uint32_t ticks = 0;
+
+    while (AM_ATOMIC_LOAD_N(&ticker->running)) {
+        uint32_t deadline = ticker->cfg.tickless_cb(ticker->cfg.ctx, ticks);
+
+        struct timespec till = last;
+        int64_t sleep_ns = (int64_t)deadline * period_ns;
+        till.tv_sec += (time_t)(sleep_ns / NSEC_PER_SEC);
+        timespec_add_ns(&till, (long)(sleep_ns % NSEC_PER_SEC));
+
+        pthread_mutex_lock(&task->mutex);
+        int rc = 0;
+        while (!AM_ATOMIC_LOAD_N(&task->notified) && (ETIMEDOUT != rc) &&
+               AM_ATOMIC_LOAD_N(&ticker->running)) {
+            if (deadline) {
+                rc = pthread_cond_timedwait(&task->cond, &task->mutex, &till);
+            } else {
+                rc = pthread_cond_wait(&task->cond, &task->mutex);
+            }
+        }
+        AM_ATOMIC_STORE_N(&task->notified, false);
+        pthread_mutex_unlock(&task->mutex);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t elapsed_ns = (int64_t)(now.tv_sec - last.tv_sec);
+        elapsed_ns = elapsed_ns * NSEC_PER_SEC + (now.tv_nsec - last.tv_nsec);
+        int64_t elapsed = AM_MAX(elapsed_ns, 0) / period_ns;
+        elapsed = AM_MIN(elapsed, (int64_t)UINT32_MAX);
+        ticks = (uint32_t)elapsed;
+
+        int64_t passed_ns = elapsed * period_ns;
+        last.tv_sec += (time_t)(passed_ns / NSEC_PER_SEC);
+        timespec_add_ns(&last, (long)(passed_ns % NSEC_PER_SEC));
+    }
+}
+
 static void am_ticker_task(void* arg) {
     struct am_ticker* ticker = arg;
 
+    if (ticker->cfg.tickless_cb != NULL) {
+        am_ticker_task_tickless(ticker);
+        return;
+    }
+
     struct timespec next;
     clock_gettime(CLOCK_MONOTONIC, &next);
 
@@ -617,7 +773,7 @@ static void am_ticker_task(void* arg) {
 
 int am_ticker_create(const struct am_ticker_cfg* cfg) {
     AM_ASSERT(cfg);
-    AM_ASSERT(cfg->ticker_cb);
+    AM_ASSERT(cfg->ticker_cb || cfg->tickless_cb);
 
     struct am_ticker* ticker = &tickers[0];
 
@@ -627,7 +783,7 @@ int am_ticker_create(const struct am_ticker_cfg* cfg) {
     ticker->busy = true;
     ticker->cfg = *cfg;
     ticker->period_ns =
-        1000000 * am_time_get_ms_from_ticks(cfg->timebase, /*ticks=*/1);
+        (long)am_time_get_ns_from_ticks(cfg->timebase, /*ticks=*/1);
 
     return am_pal_id_from_index(0);
 }
@@ -660,6 +816,9 @@ void am_ticker_stop(int ticker_id) {
     AM_ASSERT(was_running);
 
     AM_ASSERT(am_task_id_is_valid(ticker->task_id));
+    if (ticker->cfg.tickless_cb != NULL) {
+        am_task_notify(ticker->task_id);
+    }
     const int task_index = am_pal_index_from_id(ticker->task_id);
     struct am_task* task = &am_tasks_[task_index];
     AM_ASSERT(task);
@@ -673,3 +832,16 @@ void am_ticker_stop(int ticker_id) {
         AM_ASSERT(0 == rc);
     }
 }
+
+void am_ticker_notify(int ticker_id) {
+    struct am_ticker* ticker = &tickers[am_pal_index_from_id(ticker_id)];
+    AM_ASSERT(ticker->busy);
+
+    if (ticker->cfg.tickless_cb == NULL) {
+        return;
+    }
+    int task_id = AM_ATOMIC_LOAD_N(&ticker->task_id);
+    if (AM_ATOMIC_LOAD_N(&ticker->running) && am_task_id_is_valid(task_id)) {
+        am_task_notify(task_id);
+    }
+}
@@ -72,6 +72,12 @@ void am_task_notify(int task_id) { (void)task_id; }
 
 void am_task_wait(int task_id) { (void)task_id; }
 
+bool am_task_wait_timeout(int task_id, uint32_t timeout_ms) {
+    (void)task_id;
+    (void)timeout_ms;
+    return false;
+}
+
 int am_mutex_create(void) { return 0; }
 
 void am_mutex_lock(int mutex) { (void)mutex; }
@@ -89,6 +95,17 @@ uint32_t am_time_get_ticks(int timebase) {
     return 0;
 }
 
+uint64_t am_time_get_ticks64(int timebase) {
+    (void)timebase;
+    return 0;
+}
+
+uint64_t am_time_get_ns_from_ticks(int timebase, uint64_t ticks) {
+    (void)timebase;
+    (void)ticks;
+    return 0;
+}
+
 uint32_t am_time_get_ticks_from_ms(int timebase, uint32_t ms) {
     (void)timebase;
     (void)ms;
@@ -164,3 +181,5 @@ int am_ticker_create(const struct am_ticker_cfg* cfg) {
 void am_ticker_start(int ticker) { (void)ticker; }
 
 void am_ticker_stop(int ticker) { (void)ticker; }
+
+void am_ticker_notify(int ticker) { (void)ticker; }
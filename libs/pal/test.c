@@ -0,0 +1,64 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Source: https://github.com/adel-mamin/amast
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file
+ * PAL unit tests.
+ */
+
+#include <stdint.h>
+
+#include "common/macros.h"
+#include "pal/pal.h"
+
+static void test_time_get_ticks_from_ms(void) {
+    AM_ASSERT(0 == am_time_get_ticks_from_ms(AM_TIMEBASE_DEFAULT, 0));
+    AM_ASSERT(1 == am_time_get_ticks_from_ms(AM_TIMEBASE_DEFAULT, 1));
+    AM_ASSERT(
+        UINT32_MAX == am_time_get_ticks_from_ms(AM_TIMEBASE_DEFAULT, UINT32_MAX)
+    );
+
+    AM_ASSERT(
+        4294967000U == am_time_get_ticks_from_ms(AM_TIMEBASE_US, 4294967)
+    );
+    AM_ASSERT(UINT32_MAX == am_time_get_ticks_from_ms(AM_TIMEBASE_US, 4294968));
+
+    /* the largest ms value, which fits 32 bit nanosecond ticks */
+    AM_ASSERT(
+        4294000000U == am_time_get_ticks_from_ms(AM_TIMEBASE_NS, 4294)
+    );
+    /* saturates instead of wrapping around */
+    AM_ASSERT(UINT32_MAX == am_time_get_ticks_from_ms(AM_TIMEBASE_NS, 4295));
+    AM_ASSERT(
+        UINT32_MAX == am_time_get_ticks_from_ms(AM_TIMEBASE_NS, UINT32_MAX)
+    );
+}
+
+int main(void) {
+    test_time_get_ticks_from_ms();
+
+    return 0;
+}
@@ -39,11 +39,6 @@ static k_spinlock_key_t am_pal_spinlock_key_;
 static char am_crit_entered_ = 0;
 static int init_complete_mutex_;
 
-/** Maximum number of mutexes */
-#ifndef AM_PAL_MUTEX_NUM_MAX
-#define AM_PAL_MUTEX_NUM_MAX 2
-#endif
-
 /** PAL mutex descriptor */
 struct am_mutex {
     /** Zephyr mutex */
@@ -243,6 +238,12 @@ void am_task_notify(int task_id) {
 
 void am_task_wait(int task_id) { k_sleep(K_FOREVER); }
 
+bool am_task_wait_timeout(int task_id, uint32_t timeout_ms) {
+    (void)task_id;
+    /* k_sleep() returns the remaining time, if woken up by k_wakeup() */
+    return k_sleep(K_MSEC(timeout_ms)) > 0;
+}
+
 int am_task_get_own_id(void) {
     k_tid_t tid = k_current_get();
     if (task_main_.tid == tid) {
@@ -262,6 +263,12 @@ uint32_t am_time_get_ms(void) { return k_uptime_get_32(); }
 
 uint32_t am_time_get_ticks(int timebase) { return k_cycle_get_32(); }
 
+uint64_t am_time_get_ticks64(int timebase) { return k_cycle_get_64(); }
+
+uint64_t am_time_get_ns_from_ticks(int timebase, uint64_t ticks) {
+    return k_cyc_to_ns_floor64(ticks);
+}
+
 uint32_t am_time_get_ticks_from_ms(int timebase, uint32_t ms) {
     return k_ms_to_ticks_ceil32(ms);
 }
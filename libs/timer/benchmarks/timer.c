@@ -0,0 +1,200 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Timer benchmark.
+ *
+ * Arms 1k to 1M timer events with mixed one shot and periodic intervals
+ * and measures arming, disarming, ticking and firing throughput and
+ * the latency distribution of the ticker callback.
+ *
+ * The ticker callback is the one of apps/examples/watchdog/main.c.
+ * The fired timer events are handed over to a sink instead of being
+ * posted to active objects, so that only the timer library is measured.
+ *
+ * Run with argument list, wheel or heap to select the timer backend.
+ * The results are printed one line per number of timer events
+ * as space separated key=value pairs.
+ */
+
+/* amast-pragma: verbatim-include-std-on */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* amast-pragma: verbatim-include-std-off */
+
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "timer/timer.h"
+#include "pal/pal.h"
+
+/** The maximum number of timer events */
+#define BENCH_NTIMERS_MAX 1000000
+/** The number of ticks per run */
+#define BENCH_NTICKS 1000
+/** One shot timer events are due in [1, BENCH_ONESHOT_MAX] ticks */
+#define BENCH_ONESHOT_MAX 4096
+/** Periodic timer events have intervals in [1, BENCH_INTERVAL_MAX] ticks */
+#define BENCH_INTERVAL_MAX 1024
+
+static struct am_timer_event_x m_events[BENCH_NTIMERS_MAX];
+static struct am_timer_event* m_heap[BENCH_NTIMERS_MAX];
+static struct am_timer_wheel m_wheel;
+static uint64_t m_latency_ns[BENCH_NTICKS];
+
+/** The fired timer events sink */
+static struct {
+    void* owner;
+    uint32_t nfired;
+} m_sink;
+
+static uint32_t m_rand = 1;
+
+static uint32_t bench_rand(void) {
+    m_rand = m_rand * 1103515245U + 12345U;
+    return m_rand >> 8;
+}
+
+static uint64_t bench_get_ns(void) {
+    return am_time_get_ticks64(AM_TIMEBASE_NS);
+}
+
+static int bench_cmp(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void ticker_cb(void* param) {
+    struct am_timer* timer = param;
+
+    am_timer_tick_iterator_init(timer);
+    struct am_timer_event* fired = NULL;
+    while ((fired = am_timer_tick_iterator_next(timer)) != NULL) {
+        void* owner = AM_CAST(struct am_timer_event_x*, fired)->ctx;
+        /* am_ao_post_fifo(owner, &fired->event) in the example */
+        m_sink.owner = owner;
+        ++m_sink.nfired;
+    }
+}
+
+/**
+ * Let timer place armed timer events or remove disarmed ones.
+ *
+ * @param timer  the timer state
+ */
+static void bench_sync(struct am_timer* timer) {
+    am_timer_tick_iterator_init_x(timer, /*ticks=*/0);
+    AM_ASSERT(NULL == am_timer_tick_iterator_next(timer));
+}
+
+static void bench_run(const char* backend, int ntimers) {
+    struct am_timer timer;
+    if (0 == strcmp(backend, "wheel")) {
+        am_timer_init_wheel(&timer, &m_wheel);
+    } else if (0 == strcmp(backend, "heap")) {
+        am_timer_init_heap(&timer, m_heap, ntimers);
+    } else {
+        AM_ASSERT(0 == strcmp(backend, "list"));
+        am_timer_init(&timer);
+    }
+    am_timer_register_cbs(&timer, am_crit_enter, am_crit_exit);
+
+    for (int i = 0; i < ntimers; ++i) {
+        m_events[i] = am_timer_event_create_x(AM_EVT_USER, &m_sink);
+    }
+
+    /* every fourth timer event is periodic */
+    uint64_t start_ns = bench_get_ns();
+    for (int i = 0; i < ntimers; ++i) {
+        uint32_t ticks = 1 + bench_rand() % BENCH_ONESHOT_MAX;
+        uint32_t interval = 0;
+        if (0 == (i % 4)) {
+            interval = ticks = 1 + bench_rand() % BENCH_INTERVAL_MAX;
+        }
+        am_timer_arm(&timer, &m_events[i].event, ticks, interval);
+    }
+    bench_sync(&timer);
+    const uint64_t arm_ns = bench_get_ns() - start_ns;
+
+    m_sink.nfired = 0;
+    uint64_t tick_ns = 0;
+    for (int i = 0; i < BENCH_NTICKS; ++i) {
+        start_ns = bench_get_ns();
+        ticker_cb(&timer);
+        m_latency_ns[i] = bench_get_ns() - start_ns;
+        tick_ns += m_latency_ns[i];
+    }
+    const uint32_t nfired = m_sink.nfired;
+    AM_ASSERT(nfired > 0);
+
+    start_ns = bench_get_ns();
+    for (int i = 0; i < ntimers; ++i) {
+        am_timer_disarm(&timer, &m_events[i].event);
+    }
+    bench_sync(&timer);
+    const uint64_t disarm_ns = bench_get_ns() - start_ns;
+    AM_ASSERT(am_timer_is_empty_unsafe(&timer));
+
+    qsort(m_latency_ns, BENCH_NTICKS, sizeof(m_latency_ns[0]), bench_cmp);
+
+    am_printf(
+        "timer backend=%s ntimers=%d ticks=%d nfired=%u"
+        " arm_ns=%u disarm_ns=%u tick_ns=%u fire_ns=%u"
+        " cb_p50_ns=%u cb_p99_ns=%u cb_p999_ns=%u cb_max_ns=%u\n",
+        backend,
+        ntimers,
+        BENCH_NTICKS,
+        (unsigned)nfired,
+        (unsigned)(arm_ns / (uint64_t)ntimers),
+        (unsigned)(disarm_ns / (uint64_t)ntimers),
+        (unsigned)(tick_ns / BENCH_NTICKS),
+        (unsigned)(tick_ns / nfired),
+        (unsigned)m_latency_ns[BENCH_NTICKS * 50 / 100],
+        (unsigned)m_latency_ns[BENCH_NTICKS * 99 / 100],
+        (unsigned)m_latency_ns[BENCH_NTICKS * 999 / 1000],
+        (unsigned)m_latency_ns[BENCH_NTICKS - 1]
+    );
+}
+
+int main(int argc, char* argv[]) {
+    AM_ASSERT(2 == argc);
+
+    am_pal_global_init(/*arg=*/NULL);
+
+    for (int ntimers = 1000; ntimers <= BENCH_NTIMERS_MAX; ntimers *= 10) {
+        bench_run(argv[1], ntimers);
+    }
+
+    am_pal_global_deinit();
+
+    return 0;
+}
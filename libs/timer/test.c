@@ -29,7 +29,10 @@
  * Timer unit tests.
  */
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 
 #include "common/macros.h"
 #include "event/event_common.h"
@@ -80,7 +83,287 @@ static void test_arm(void) {
     AM_ASSERT(am_timer_is_empty_unsafe(&timer));
 }
 
+/** the number of timer events of the timing wheel test */
+#define TEST_NEVENTS 64
+
+static uint32_t m_rand = 1;
+
+static uint32_t test_rand(void) {
+    m_rand = m_rand * 1103515245U + 12345U;
+    return m_rand >> 8;
+}
+
+/*
+ * The timing wheel and min-heap are expected to behave exactly
+ * as the list of events
+ */
+static void test_wheel(void) {
+    static struct am_timer_wheel wheel;
+    static struct am_timer_event* heap[TEST_NEVENTS];
+    struct am_timer timers[3];
+    am_timer_init(&timers[0]);
+    am_timer_init_wheel(&timers[1], &wheel);
+    am_timer_init_heap(&timers[2], heap, AM_COUNTOF(heap));
+
+    static struct am_timer_event events[3][TEST_NEVENTS];
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        events[0][i] = events[1][i] = events[2][i] =
+            am_timer_event_create(EVT_TEST);
+    }
+
+    for (int tick = 0; tick < 20000; ++tick) {
+        const int i = (int)(test_rand() % TEST_NEVENTS);
+        const uint32_t r = test_rand() % 16;
+        if (r < 4) {
+            /* one shot and periodic events, some beyond the level 0 */
+            uint32_t ticks = test_rand() % ((r & 1) ? 10000 : 70);
+            uint32_t interval = (r & 2) ? (1 + test_rand() % 300) : 0;
+            for (int t = 0; t < 3; ++t) {
+                am_timer_arm(&timers[t], &events[t][i], ticks, interval);
+            }
+        } else if (r < 6) {
+            bool armed = am_timer_disarm(&timers[0], &events[0][i]);
+            for (int t = 1; t < 3; ++t) {
+                AM_ASSERT(armed == am_timer_disarm(&timers[t], &events[t][i]));
+            }
+        }
+
+        bool fired[3][TEST_NEVENTS] = {{false}};
+        for (int t = 0; t < 3; ++t) {
+            am_timer_tick_iterator_init(&timers[t]);
+            struct am_timer_event* e = NULL;
+            while ((e = am_timer_tick_iterator_next(&timers[t])) != NULL) {
+                fired[t][e - events[t]] = true;
+            }
+        }
+        for (int j = 0; j < TEST_NEVENTS; ++j) {
+            for (int t = 1; t < 3; ++t) {
+                AM_ASSERT(fired[0][j] == fired[t][j]);
+                AM_ASSERT(
+                    am_timer_is_armed(&timers[0], &events[0][j]) ==
+                    am_timer_is_armed(&timers[t], &events[t][j])
+                );
+                AM_ASSERT(
+                    am_timer_get_ticks(&timers[0], &events[0][j]) ==
+                    am_timer_get_ticks(&timers[t], &events[t][j])
+                );
+            }
+        }
+    }
+}
+
+/* the event due beyond the timing wheel span fires in time */
+static void test_wheel_span(void) {
+    static struct am_timer_wheel wheel;
+    struct am_timer timer;
+    am_timer_init_wheel(&timer, &wheel);
+
+    struct am_timer_event event = am_timer_event_create(EVT_TEST);
+    const uint32_t span = (uint32_t)1
+                          << (AM_TIMER_WHEEL_SLOT_BITS * AM_TIMER_WHEEL_LEVELS);
+    const uint32_t ticks = span + span / 3;
+
+    am_timer_arm(&timer, &event, ticks, /*interval=*/0);
+    for (uint32_t i = 1; i <= ticks; ++i) {
+        am_timer_tick_iterator_init(&timer);
+        struct am_timer_event* e = am_timer_tick_iterator_next(&timer);
+        AM_ASSERT((i == ticks) == (e == &event));
+    }
+    AM_ASSERT(am_timer_is_empty_unsafe(&timer));
+}
+
+/**
+ * Collect fired timer events.
+ *
+ * @param timer   the timer state
+ * @param events  the timer events of the timer state
+ * @param ticks   the number of ticks to advance the timer by
+ * @param fired   the fired timer events flags
+ *
+ * @return the number of fired timer events
+ */
+static int test_advance(
+    struct am_timer* timer,
+    struct am_timer_event* events,
+    uint32_t ticks,
+    bool fired[TEST_NEVENTS]
+) {
+    int n = 0;
+    am_timer_tick_iterator_init_x(timer, ticks);
+    struct am_timer_event* e = NULL;
+    while ((e = am_timer_tick_iterator_next(timer)) != NULL) {
+        AM_ASSERT(!fired[e - events]);
+        fired[e - events] = true;
+        ++n;
+    }
+    return n;
+}
+
+/*
+ * The tickless timers sleeping till the next deadline are expected
+ * to behave exactly as the timer ticked every tick.
+ */
+static void test_tickless(void) {
+    static struct am_timer_wheel wheel;
+    static struct am_timer_event* heap[TEST_NEVENTS];
+    struct am_timer timers[4];
+    am_timer_init(&timers[0]); /* ticked every tick */
+    am_timer_init(&timers[1]);
+    am_timer_init_wheel(&timers[2], &wheel);
+    am_timer_init_heap(&timers[3], heap, AM_COUNTOF(heap));
+
+    static struct am_timer_event events[4][TEST_NEVENTS];
+    for (int i = 0; i < TEST_NEVENTS; ++i) {
+        events[0][i] = events[1][i] = events[2][i] = events[3][i] =
+            am_timer_event_create(EVT_TEST);
+    }
+
+    for (int round = 0; round < 3000; ++round) {
+        for (int k = (int)(test_rand() % 4); k > 0; --k) {
+            const int i = (int)(test_rand() % TEST_NEVENTS);
+            const uint32_t r = test_rand() % 8;
+            if (r < 6) {
+                uint32_t ticks = test_rand() % ((r & 1) ? 10000 : 70);
+                uint32_t interval = (r & 2) ? (1 + test_rand() % 300) : 0;
+                for (int t = 0; t < 4; ++t) {
+                    am_timer_arm(&timers[t], &events[t][i], ticks, interval);
+                }
+            } else {
+                bool armed = am_timer_disarm(&timers[0], &events[0][i]);
+                for (int t = 1; t < 4; ++t) {
+                    AM_ASSERT(
+                        armed == am_timer_disarm(&timers[t], &events[t][i])
+                    );
+                }
+            }
+        }
+        /* the tickless timers start counting the armed timer events */
+        for (int t = 1; t < 4; ++t) {
+            bool fired[TEST_NEVENTS] = {false};
+            AM_ASSERT(0 == test_advance(&timers[t], events[t], 0, fired));
+        }
+
+        uint32_t deadline = am_timer_get_next_deadline(&timers[1]);
+        uint32_t deadline_wheel = am_timer_get_next_deadline(&timers[2]);
+        AM_ASSERT(deadline == am_timer_get_next_deadline(&timers[0]));
+        AM_ASSERT(deadline == am_timer_get_next_deadline(&timers[3]));
+        AM_ASSERT((0 == deadline) == (0 == deadline_wheel));
+        AM_ASSERT(deadline_wheel <= deadline);
+
+        uint32_t ticks = 1 + test_rand() % 1000;
+        if (deadline_wheel) {
+            ticks = 1 + test_rand() % deadline_wheel;
+        }
+
+        bool fired[4][TEST_NEVENTS] = {{false}};
+        for (uint32_t tick = 1; tick <= ticks; ++tick) {
+            int n = test_advance(&timers[0], events[0], 1, fired[0]);
+            AM_ASSERT((0 == n) || (tick == deadline));
+        }
+        for (int t = 1; t < 4; ++t) {
+            test_advance(&timers[t], events[t], ticks, fired[t]);
+        }
+        for (int j = 0; j < TEST_NEVENTS; ++j) {
+            for (int t = 1; t < 4; ++t) {
+                AM_ASSERT(fired[0][j] == fired[t][j]);
+                AM_ASSERT(
+                    am_timer_is_armed(&timers[0], &events[0][j]) ==
+                    am_timer_is_armed(&timers[t], &events[t][j])
+                );
+                AM_ASSERT(
+                    am_timer_get_ticks(&timers[0], &events[0][j]) ==
+                    am_timer_get_ticks(&timers[t], &events[t][j])
+                );
+            }
+        }
+    }
+}
+
+/* the periodic timer events keep their phase, when advanced past it */
+static void test_tickless_periodic(void) {
+    static struct am_timer_wheel wheel;
+    static struct am_timer_event* heap[2];
+    struct am_timer timers[3];
+    am_timer_init(&timers[0]);
+    am_timer_init_wheel(&timers[1], &wheel);
+    am_timer_init_heap(&timers[2], heap, AM_COUNTOF(heap));
+
+    for (int t = 0; t < 3; ++t) {
+        struct am_timer* timer = &timers[t];
+        struct am_timer_event events[2] = {
+            am_timer_event_create(EVT_TEST), am_timer_event_create(EVT_TEST2)
+        };
+        am_timer_arm(timer, &events[0], /*ticks=*/10, /*interval=*/10);
+        am_timer_arm(timer, &events[1], /*ticks=*/5, /*interval=*/0);
+        AM_ASSERT(5 == am_timer_get_next_deadline(timer));
+
+        bool fired[TEST_NEVENTS] = {false};
+        AM_ASSERT(0 == test_advance(timer, events, 0, fired));
+        AM_ASSERT(2 == test_advance(timer, events, 35, fired));
+        AM_ASSERT(fired[0] && fired[1]);
+        AM_ASSERT(am_timer_is_armed(timer, &events[0]));
+        AM_ASSERT(!am_timer_is_armed(timer, &events[1]));
+        AM_ASSERT(5 == am_timer_get_ticks(timer, &events[0]));
+        AM_ASSERT(5 == am_timer_get_next_deadline(timer));
+
+        /* armed without the following 0 ticks advance */
+        am_timer_arm(timer, &events[1], /*ticks=*/3, /*interval=*/0);
+        AM_ASSERT(3 == am_timer_get_next_deadline(timer));
+
+        /* counted as armed during the last of the ticks */
+        memset(fired, 0, sizeof(fired));
+        AM_ASSERT(0 == test_advance(timer, events, 2, fired));
+        AM_ASSERT(2 == am_timer_get_ticks(timer, &events[1]));
+        AM_ASSERT(2 == am_timer_get_next_deadline(timer));
+
+        AM_ASSERT(am_timer_disarm(timer, &events[0]));
+        AM_ASSERT(am_timer_disarm(timer, &events[1]));
+        memset(fired, 0, sizeof(fired));
+        AM_ASSERT(0 == test_advance(timer, events, 0, fired));
+        AM_ASSERT(0 == am_timer_get_next_deadline(timer));
+        AM_ASSERT(am_timer_is_empty_unsafe(timer));
+    }
+}
+
+/* the min-heap has no limit on the ticks the events are due in */
+static void test_heap_far(void) {
+    static struct am_timer_event* heap[3];
+    struct am_timer timer;
+    am_timer_init_heap(&timer, heap, AM_COUNTOF(heap));
+
+    struct am_timer_event events[3] = {
+        am_timer_event_create(EVT_TEST),
+        am_timer_event_create(EVT_TEST),
+        am_timer_event_create(EVT_TEST2)
+    };
+    am_timer_arm(&timer, &events[0], /*ticks=*/UINT32_MAX, /*interval=*/0);
+    am_timer_arm(&timer, &events[1], /*ticks=*/UINT32_MAX / 2, /*interval=*/0);
+    am_timer_arm(&timer, &events[2], /*ticks=*/3, /*interval=*/0);
+
+    bool fired[TEST_NEVENTS] = {false};
+    AM_ASSERT(0 == test_advance(&timer, events, 0, fired));
+    AM_ASSERT(3 == am_timer_get_next_deadline(&timer));
+    AM_ASSERT(am_timer_disarm(&timer, &events[2]));
+    AM_ASSERT(UINT32_MAX / 2 == am_timer_get_next_deadline(&timer));
+
+    AM_ASSERT(0 == test_advance(&timer, events, UINT32_MAX / 2 - 1, fired));
+    AM_ASSERT(1 == test_advance(&timer, events, 1, fired));
+    AM_ASSERT(fired[1]);
+
+    uint32_t ticks = UINT32_MAX - UINT32_MAX / 2;
+    AM_ASSERT(ticks == am_timer_get_next_deadline(&timer));
+    AM_ASSERT(ticks == am_timer_get_ticks(&timer, &events[0]));
+    AM_ASSERT(1 == test_advance(&timer, events, ticks, fired));
+    AM_ASSERT(fired[0]);
+    AM_ASSERT(am_timer_is_empty_unsafe(&timer));
+}
+
 int main(void) {
     test_arm();
+    test_wheel();
+    test_wheel_span();
+    test_tickless();
+    test_tickless_periodic();
+    test_heap_far();
     return 0;
 }
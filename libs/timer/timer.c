@@ -33,9 +33,26 @@
 #include <stdint.h>
 
 #include "common/macros.h"
-#include "slist/slist.h"
+#include "dlist/dlist.h"
 #include "timer/timer.h"
 
+#if (AM_TIMER_WHEEL_SLOT_BITS * AM_TIMER_WHEEL_LEVELS) >= 32
+#error "The timing wheel must cover less than 2^32 ticks"
+#endif
+
+/** The number of ticks covered by timing wheel */
+#define AM_TIMER_WHEEL_SPAN \
+    ((uint32_t)1 << (AM_TIMER_WHEEL_SLOT_BITS * AM_TIMER_WHEEL_LEVELS))
+
+/** Timing wheel slot index mask */
+#define AM_TIMER_WHEEL_MASK ((uint32_t)AM_TIMER_WHEEL_SLOTS - 1)
+
+/**
+ * The number of children of min-heap nodes.
+ * Unsigned, as are the min-heap node indices.
+ */
+#define AM_TIMER_HEAP_ARITY 4U
+
 static void timer_crit_stub(void) {}
 
 void am_timer_init(struct am_timer* timer) {
@@ -44,8 +61,36 @@ void am_timer_init(struct am_timer* timer) {
     memset(timer, 0, sizeof(*timer));
     timer->crit_enter = timer->crit_exit = timer_crit_stub;
 
-    am_slist_init(&timer->events);
-    am_slist_init(&timer->events_pend);
+    am_dlist_init(&timer->events);
+    am_dlist_init(&timer->events_pend);
+    am_dlist_init(&timer->fired);
+}
+
+void am_timer_init_wheel(struct am_timer* timer, struct am_timer_wheel* wheel) {
+    AM_ASSERT(timer);
+    AM_ASSERT(wheel);
+
+    am_timer_init(timer);
+
+    for (int level = 0; level < AM_TIMER_WHEEL_LEVELS; ++level) {
+        for (int slot = 0; slot < AM_TIMER_WHEEL_SLOTS; ++slot) {
+            am_dlist_init(&wheel->slots[level][slot]);
+        }
+    }
+    timer->wheel = wheel;
+}
+
+void am_timer_init_heap(
+    struct am_timer* timer, struct am_timer_event* heap[], int capacity
+) {
+    AM_ASSERT(timer);
+    AM_ASSERT(heap);
+    AM_ASSERT(capacity > 0);
+
+    am_timer_init(timer);
+
+    timer->heap.events = heap;
+    timer->heap.capacity = capacity;
 }
 
 void am_timer_register_cbs(
@@ -59,6 +104,308 @@ void am_timer_register_cbs(
     timer->crit_exit = crit_exit;
 }
 
+void am_timer_register_arm_cb(
+    struct am_timer* timer, void (*arm_cb)(void* ctx), void* ctx
+) {
+    AM_ASSERT(timer);
+
+    timer->arm_cb = arm_cb;
+    timer->arm_ctx = ctx;
+}
+
+/**
+ * Place timer event to timing wheel.
+ *
+ * The timer event is placed to the lowest timing wheel level, which
+ * covers the number of ticks till the timer event is due.
+ * The timer events due beyond the timing wheel span are placed
+ * to the last level slot handled last.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event with the tick it is due at
+ *               in event->oneshot_ticks
+ */
+static void am_timer_wheel_place(
+    struct am_timer* timer, struct am_timer_event* event
+) {
+    uint32_t due = event->oneshot_ticks;
+    const uint32_t delta = due - timer->tick;
+
+    unsigned level = 0;
+    while ((level < (AM_TIMER_WHEEL_LEVELS - 1U)) &&
+           (delta >> (AM_TIMER_WHEEL_SLOT_BITS * (level + 1U)))) {
+        ++level;
+    }
+    if (delta >= AM_TIMER_WHEEL_SPAN) {
+        /* re-placed, when the slot is cascaded */
+        due = timer->tick + AM_TIMER_WHEEL_SPAN - 1;
+    }
+    uint32_t slot =
+        (due >> (AM_TIMER_WHEEL_SLOT_BITS * level)) & AM_TIMER_WHEEL_MASK;
+
+    am_dlist_push_back(&timer->wheel->slots[level][slot], &event->item);
+}
+
+/**
+ * Move timer events of the current slot of timing wheel level
+ * to lower levels.
+ *
+ * @param timer  the timer state
+ * @param level  the timing wheel level
+ *
+ * @return the current slot index of the level
+ */
+static uint32_t am_timer_wheel_cascade(
+    struct am_timer* timer, unsigned level
+) {
+    uint32_t slot = (timer->tick >> (AM_TIMER_WHEEL_SLOT_BITS * level)) &
+                    AM_TIMER_WHEEL_MASK;
+    struct am_dlist events;
+    am_dlist_init(&events);
+    am_dlist_append(&events, &timer->wheel->slots[level][slot]);
+
+    struct am_dlist_item* p = NULL;
+    while ((p = am_dlist_pop_front(&events)) != NULL) {
+        am_timer_wheel_place(
+            timer, AM_CONTAINER_OF(p, struct am_timer_event, item)
+        );
+    }
+    return slot;
+}
+
+/**
+ * Check if min-heap timer event is due before another one.
+ *
+ * @param timer  the timer state
+ * @param a      the first timer event
+ * @param b      the second timer event
+ *
+ * @retval true   the timer event a is due before the timer event b
+ * @retval false  the timer event a is not due before the timer event b
+ */
+static bool am_timer_heap_is_before(
+    const struct am_timer* timer,
+    const struct am_timer_event* a,
+    const struct am_timer_event* b
+) {
+    /* all timer events in the heap are due at or after timer->tick */
+    return (a->oneshot_ticks - timer->tick) < (b->oneshot_ticks - timer->tick);
+}
+
+/**
+ * Put timer event to min-heap node.
+ *
+ * @param timer  the timer state
+ * @param index  the min-heap node index
+ * @param event  the timer event
+ */
+static void am_timer_heap_set(
+    struct am_timer* timer, unsigned index, struct am_timer_event* event
+) {
+    timer->heap.events[index] = event;
+    event->heap_index = (int)index;
+}
+
+/**
+ * Move min-heap timer event up till its parent is due before it.
+ *
+ * @param timer  the timer state
+ * @param index  the min-heap node index of the timer event
+ */
+static void am_timer_heap_sift_up(struct am_timer* timer, unsigned index) {
+    struct am_timer_event* event = timer->heap.events[index];
+    while (index > 0) {
+        unsigned parent = (index - 1) / AM_TIMER_HEAP_ARITY;
+        struct am_timer_event* p = timer->heap.events[parent];
+        if (!am_timer_heap_is_before(timer, event, p)) {
+            break;
+        }
+        am_timer_heap_set(timer, index, p);
+        index = parent;
+    }
+    am_timer_heap_set(timer, index, event);
+}
+
+/**
+ * Move min-heap timer event down till it is due before its children.
+ *
+ * @param timer  the timer state
+ * @param index  the min-heap node index of the timer event
+ */
+static void am_timer_heap_sift_down(
+    struct am_timer* timer, unsigned index
+) {
+    struct am_timer_event** events = timer->heap.events;
+    const unsigned nevents = (unsigned)timer->heap.nevents;
+    struct am_timer_event* event = events[index];
+    for (;;) {
+        unsigned first = index * AM_TIMER_HEAP_ARITY + 1;
+        if (first >= nevents) {
+            break;
+        }
+        unsigned last = AM_MIN(first + AM_TIMER_HEAP_ARITY, nevents);
+        unsigned min = first;
+        for (unsigned i = first + 1; i < last; ++i) {
+            if (am_timer_heap_is_before(timer, events[i], events[min])) {
+                min = i;
+            }
+        }
+        if (!am_timer_heap_is_before(timer, events[min], event)) {
+            break;
+        }
+        am_timer_heap_set(timer, index, events[min]);
+        index = min;
+    }
+    am_timer_heap_set(timer, index, event);
+}
+
+/**
+ * Add timer event to min-heap.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event with the tick it is due at
+ *               in event->oneshot_ticks
+ */
+static void am_timer_heap_push(
+    struct am_timer* timer, struct am_timer_event* event
+) {
+    AM_ASSERT(timer->heap.nevents < timer->heap.capacity);
+
+    unsigned index = (unsigned)timer->heap.nevents++;
+    am_timer_heap_set(timer, index, event);
+    am_timer_heap_sift_up(timer, index);
+}
+
+/**
+ * Check if timer event is in min-heap.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event
+ *
+ * @retval true   the timer event is in the min-heap
+ * @retval false  the timer event is not in the min-heap
+ */
+static bool am_timer_heap_has(
+    const struct am_timer* timer, const struct am_timer_event* event
+) {
+    const int index = event->heap_index;
+    return timer->heap.events && (index >= 0) &&
+           (index < timer->heap.nevents) &&
+           (timer->heap.events[index] == event);
+}
+
+/**
+ * Remove timer event from min-heap.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event
+ */
+static void am_timer_heap_remove(
+    struct am_timer* timer, struct am_timer_event* event
+) {
+    AM_ASSERT(am_timer_heap_has(timer, event));
+
+    const unsigned index = (unsigned)event->heap_index;
+    const unsigned last = (unsigned)--timer->heap.nevents;
+    if (index == last) {
+        return;
+    }
+    struct am_timer_event* moved = timer->heap.events[last];
+    am_timer_heap_set(timer, index, moved);
+    /* wraps around for the root node, but is not used then */
+    const unsigned parent = (index - 1) / AM_TIMER_HEAP_ARITY;
+    if ((index > 0) &&
+        am_timer_heap_is_before(timer, moved, timer->heap.events[parent])) {
+        am_timer_heap_sift_up(timer, index);
+    } else {
+        am_timer_heap_sift_down(timer, index);
+    }
+}
+
+/**
+ * Advance min-heap by the given number of ticks.
+ *
+ * Moves the timer events due during the ticks to the list of
+ * fired timer events.
+ *
+ * @param timer  the timer state
+ * @param ticks  the number of ticks
+ */
+static void am_timer_heap_advance(struct am_timer* timer, uint32_t ticks) {
+    while (timer->heap.nevents > 0) {
+        struct am_timer_event* event = timer->heap.events[0];
+        if ((event->oneshot_ticks - timer->tick) >= ticks) {
+            break;
+        }
+        am_timer_heap_remove(timer, event);
+        am_dlist_push_back(&timer->fired, &event->item);
+    }
+    timer->tick += ticks;
+}
+
+/**
+ * Check if timer keeps the ticks the timer events are due at.
+ *
+ * This is the case for the timing wheel and the min-heap.
+ *
+ * @param timer  the timer state
+ *
+ * @retval true   the timer keeps the ticks the timer events are due at
+ * @retval false  the timer keeps the ticks till the timer events are due
+ */
+static bool am_timer_is_due_tick(const struct am_timer* timer) {
+    return (timer->wheel != NULL) || (timer->heap.events != NULL);
+}
+
+/**
+ * Place timer event to timing wheel or min-heap.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event with the tick it is due at
+ *               in event->oneshot_ticks
+ */
+static void am_timer_place(
+    struct am_timer* timer, struct am_timer_event* event
+) {
+    if (timer->wheel) {
+        am_timer_wheel_place(timer, event);
+    } else {
+        am_timer_heap_push(timer, event);
+    }
+}
+
+/**
+ * Check if timer event is in any timer list or in min-heap.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event
+ *
+ * @retval true   the timer event is queued
+ * @retval false  the timer event is not queued
+ */
+static bool am_timer_is_queued(
+    const struct am_timer* timer, const struct am_timer_event* event
+) {
+    return am_dlist_item_is_linked(&event->item) ||
+           am_timer_heap_has(timer, event);
+}
+
+/**
+ * Remove timer event from any timer list or from min-heap.
+ *
+ * @param timer  the timer state
+ * @param event  the timer event
+ */
+static void am_timer_unqueue(
+    struct am_timer* timer, struct am_timer_event* event
+) {
+    if (am_dlist_item_is_linked(&event->item)) {
+        am_dlist_pop(&event->item);
+    } else {
+        am_timer_heap_remove(timer, event);
+    }
+}
+
 void am_timer_arm(
     struct am_timer* timer,
     struct am_timer_event* event,
@@ -77,12 +424,29 @@ void am_timer_arm(
     event->disarm_pending = 0;
     event->owner = timer;
 
-    if (!am_slist_item_is_linked(&event->item)) {
-        am_slist_push_back(&timer->events_pend, &event->item);
+    if (am_timer_is_due_tick(timer)) {
+        if (am_timer_is_queued(timer, event)) {
+            am_timer_unqueue(timer, event);
+        } else {
+            ++timer->nevents.running;
+            AM_ASSERT(
+                !timer->heap.events ||
+                (timer->nevents.running <= timer->heap.capacity)
+            );
+        }
+        event->oneshot_ticks += timer->tick - 1;
+        /* placed in next am_timer_tick_iterator_init_x() */
+        am_dlist_push_back(&timer->events_pend, &event->item);
+    } else if (!am_dlist_item_is_linked(&event->item)) {
+        am_dlist_push_back(&timer->events_pend, &event->item);
         ++timer->nevents.pend;
     }
 
     timer->crit_exit();
+
+    if (timer->arm_cb) {
+        timer->arm_cb(timer->arm_ctx);
+    }
 }
 
 bool am_timer_disarm(struct am_timer* timer, struct am_timer_event* event) {
@@ -95,7 +459,14 @@ bool am_timer_disarm(struct am_timer* timer, struct am_timer_event* event) {
     bool was_armed = (event->owner == timer) && !event->disarm_pending;
     if (event->owner == timer) {
         event->oneshot_ticks = event->interval_ticks = 0;
-        event->disarm_pending = 1;
+        if (am_timer_is_due_tick(timer)) {
+            am_timer_unqueue(timer, event);
+            event->owner = NULL;
+            AM_ASSERT(timer->nevents.running > 0);
+            --timer->nevents.running;
+        } else {
+            event->disarm_pending = 1;
+        }
     }
 
     timer->crit_exit();
@@ -112,8 +483,8 @@ bool am_timer_is_armed(
 
     timer->crit_enter();
 
-    bool is_linked = am_slist_item_is_linked(&event->item);
-    bool armed = is_linked && (event->owner == timer);
+    bool is_queued = am_timer_is_queued(timer, event);
+    bool armed = is_queued && (event->owner == timer);
     bool disarm_pending = event->disarm_pending;
 
     timer->crit_exit();
@@ -121,15 +492,173 @@ bool am_timer_is_armed(
     return armed && !disarm_pending;
 }
 
+/**
+ * Tick timing wheel.
+ *
+ * Moves the timer events due at the current tick to the list of
+ * fired timer events.
+ *
+ * Must be called from critical section.
+ *
+ * @param timer  the timer state
+ */
+static void am_timer_wheel_tick(struct am_timer* timer) {
+    uint32_t slot = timer->tick & AM_TIMER_WHEEL_MASK;
+    for (unsigned level = 1; !slot && (level < AM_TIMER_WHEEL_LEVELS);
+         ++level) {
+        slot = am_timer_wheel_cascade(timer, level);
+    }
+    slot = timer->tick & AM_TIMER_WHEEL_MASK;
+    am_dlist_append(&timer->fired, &timer->wheel->slots[0][slot]);
+    ++timer->tick;
+}
+
+/**
+ * Get number of ticks till the first non-empty timing wheel slot is handled.
+ *
+ * The level 0 slot holds the timer events due at the tick the slot is
+ * handled at. The higher level slots are handled, when their timer events
+ * are moved to lower levels, which is never later than the timer events
+ * are due.
+ *
+ * Must be called from critical section.
+ *
+ * @param timer  the timer state
+ *
+ * @return the number of ticks or 0, if the timing wheel is empty
+ */
+static uint32_t am_timer_wheel_get_next_deadline(const struct am_timer* timer) {
+    const uint32_t tick = timer->tick;
+    uint32_t deadline = 0;
+
+    for (uint32_t i = 0; i < (uint32_t)AM_TIMER_WHEEL_SLOTS; ++i) {
+        uint32_t slot = (tick + i) & AM_TIMER_WHEEL_MASK;
+        if (!am_dlist_is_empty(&timer->wheel->slots[0][slot])) {
+            deadline = i + 1;
+            break;
+        }
+    }
+    for (int level = 1; level < AM_TIMER_WHEEL_LEVELS; ++level) {
+        const int shift = AM_TIMER_WHEEL_SLOT_BITS * level;
+        /* the slots of the blocks up to this one are moved already */
+        const uint32_t block = (tick - 1) >> shift;
+        for (uint32_t i = 1; i <= (uint32_t)AM_TIMER_WHEEL_SLOTS; ++i) {
+            uint32_t slot = (block + i) & AM_TIMER_WHEEL_MASK;
+            if (am_dlist_is_empty(&timer->wheel->slots[level][slot])) {
+                continue;
+            }
+            uint32_t ticks = ((block + i) << shift) - tick + 1;
+            if (!deadline || (ticks < deadline)) {
+                deadline = ticks;
+            }
+            break;
+        }
+    }
+    return deadline;
+}
+
+/**
+ * Advance timing wheel by the given number of ticks.
+ *
+ * The ticks with no timing wheel slots to handle are skipped.
+ *
+ * Must be called from critical section.
+ *
+ * @param timer  the timer state
+ * @param ticks  the number of ticks
+ */
+static void am_timer_wheel_advance(struct am_timer* timer, uint32_t ticks) {
+    while (ticks) {
+        uint32_t deadline = am_timer_wheel_get_next_deadline(timer);
+        uint32_t skip = deadline ? AM_MIN(deadline - 1, ticks) : ticks;
+        timer->tick += skip;
+        ticks -= skip;
+        if (ticks) {
+            am_timer_wheel_tick(timer);
+            --ticks;
+        }
+    }
+}
+
+/**
+ * Advance timing wheel or min-heap by the given number of ticks.
+ *
+ * Must be called from critical section.
+ *
+ * @param timer  the timer state
+ * @param ticks  the number of ticks
+ */
+static void am_timer_advance(struct am_timer* timer, uint32_t ticks) {
+    if (!timer->wheel) {
+        am_timer_heap_advance(timer, ticks);
+    } else if (1 == ticks) {
+        am_timer_wheel_tick(timer);
+    } else {
+        am_timer_wheel_advance(timer, ticks);
+    }
+}
+
+/**
+ * Place the armed pending timer events to timing wheel or min-heap.
+ *
+ * Must be called from critical section.
+ *
+ * @param timer  the timer state
+ * @param ticks  the number of ticks the timer events were armed before
+ */
+static void am_timer_place_pend(struct am_timer* timer, uint32_t ticks) {
+    struct am_dlist_item* p = NULL;
+    while ((p = am_dlist_pop_front(&timer->events_pend)) != NULL) {
+        struct am_timer_event* event =
+            AM_CONTAINER_OF(p, struct am_timer_event, item);
+        event->oneshot_ticks += ticks;
+        am_timer_place(timer, event);
+    }
+}
+
 void am_timer_tick_iterator_init(struct am_timer* timer) {
+    am_timer_tick_iterator_init_x(timer, /*ticks=*/1);
+}
+
+void am_timer_tick_iterator_init_x(struct am_timer* timer, uint32_t ticks) {
     AM_ASSERT(timer);
 
-    am_slist_iterator_init(&timer->events, &timer->it);
+    /* the armed pending timer events count the last tick only */
+    const uint32_t ticks_pend = ticks ? (ticks - 1) : 0;
+
+    if (am_timer_is_due_tick(timer)) {
+        timer->crit_enter();
+
+        if (ticks_pend) {
+            am_timer_advance(timer, ticks_pend);
+        }
+        am_timer_place_pend(timer, ticks_pend);
+        if (ticks) {
+            am_timer_advance(timer, /*ticks=*/1);
+        }
+
+        timer->crit_exit();
+        return;
+    }
+
+    am_dlist_iterator_init(&timer->events, &timer->it, AM_DLIST_FORWARD);
 
     timer->crit_enter();
 
-    if (!am_slist_is_empty(&timer->events_pend)) {
-        am_slist_append(&timer->events, &timer->events_pend);
+    timer->nticks = ticks;
+    if (!am_dlist_is_empty(&timer->events_pend)) {
+        if (ticks_pend) {
+            struct am_dlist_iterator it;
+            am_dlist_iterator_init(&timer->events_pend, &it, AM_DLIST_FORWARD);
+            struct am_dlist_item* p = NULL;
+            while ((p = am_dlist_iterator_next(&it)) != NULL) {
+                struct am_timer_event* event =
+                    AM_CONTAINER_OF(p, struct am_timer_event, item);
+                uint32_t left = UINT32_MAX - event->oneshot_ticks;
+                event->oneshot_ticks += AM_MIN(ticks_pend, left);
+            }
+        }
+        am_dlist_append(&timer->events, &timer->events_pend);
         timer->nevents.running += timer->nevents.pend;
         timer->nevents.pend = 0;
     }
@@ -137,23 +666,60 @@ void am_timer_tick_iterator_init(struct am_timer* timer) {
     timer->crit_exit();
 }
 
+/**
+ * Iterate tick of timing wheel or min-heap to next fired timer event.
+ *
+ * @param timer  the timer state
+ *
+ * @return fired timer event or NULL
+ */
+static struct am_timer_event* am_timer_fired_next(struct am_timer* timer) {
+    timer->crit_enter();
+
+    struct am_timer_event* event = NULL;
+    struct am_dlist_item* p = am_dlist_pop_front(&timer->fired);
+    if (p) {
+        event = AM_CONTAINER_OF(p, struct am_timer_event, item);
+        if (event->interval_ticks) {
+            /* the ticks passed since the event was due */
+            uint32_t late = timer->tick - 1 - event->oneshot_ticks;
+            uint32_t interval = event->interval_ticks;
+            event->oneshot_ticks += interval * (late / interval + 1);
+            am_timer_place(timer, event);
+        } else {
+            event->owner = NULL;
+            AM_ASSERT(timer->nevents.running > 0);
+            --timer->nevents.running;
+        }
+    }
+
+    timer->crit_exit();
+
+    return event;
+}
+
 struct am_timer_event* am_timer_tick_iterator_next(struct am_timer* timer) {
     AM_ASSERT(timer);
 
+    if (am_timer_is_due_tick(timer)) {
+        return am_timer_fired_next(timer);
+    }
+
     timer->crit_enter();
 
     int nevents = timer->nevents.running;
 
-    struct am_slist_item* p = NULL;
+    struct am_dlist_item* p = NULL;
     struct am_timer_event* event = NULL;
-    while ((p = am_slist_iterator_next(&timer->it)) != NULL) {
+    /* the iterator is exhausted, if the current item is NULL */
+    while (timer->it.cur && (p = am_dlist_iterator_next(&timer->it))) {
         event = AM_CONTAINER_OF(p, struct am_timer_event, item);
 
         AM_ASSERT(nevents > 0);
         --nevents;
 
         if (event->disarm_pending) {
-            am_slist_iterator_pop(&timer->it);
+            am_dlist_iterator_pop(&timer->it);
             event->disarm_pending = 0;
             event->owner = NULL;
             AM_ASSERT(timer->nevents.running > 0);
@@ -163,15 +729,18 @@ struct am_timer_event* am_timer_tick_iterator_next(struct am_timer* timer) {
         }
 
         AM_ASSERT(event->oneshot_ticks);
-        --event->oneshot_ticks;
-        if (event->oneshot_ticks) {
+        if (event->oneshot_ticks > timer->nticks) {
+            event->oneshot_ticks -= timer->nticks;
             event = NULL;
             continue;
         }
         if (event->interval_ticks) {
-            event->oneshot_ticks = event->interval_ticks;
+            /* the ticks passed since the event was due */
+            uint32_t late = timer->nticks - event->oneshot_ticks;
+            uint32_t interval = event->interval_ticks;
+            event->oneshot_ticks = interval - late % interval;
         } else {
-            am_slist_iterator_pop(&timer->it);
+            am_dlist_iterator_pop(&timer->it);
             event->owner = NULL;
             AM_ASSERT(timer->nevents.running > 0);
             --timer->nevents.running;
@@ -187,8 +756,12 @@ struct am_timer_event* am_timer_tick_iterator_next(struct am_timer* timer) {
 bool am_timer_is_empty_unsafe(const struct am_timer* timer) {
     AM_ASSERT(timer);
 
-    bool empty = am_slist_is_empty(&timer->events);
-    bool empty_pend = am_slist_is_empty(&timer->events_pend);
+    if (am_timer_is_due_tick(timer)) {
+        return !timer->nevents.running;
+    }
+
+    bool empty = am_dlist_is_empty(&timer->events);
+    bool empty_pend = am_dlist_is_empty(&timer->events_pend);
 
     return empty && empty_pend;
 }
@@ -201,8 +774,76 @@ uint32_t am_timer_get_ticks(
     AM_ASSERT((event->owner == NULL) || (event->owner == timer));
 
     timer->crit_enter();
-    uint32_t ticks = (event->owner == timer) ? event->oneshot_ticks : 0;
+    uint32_t ticks = 0;
+    if (event->owner == timer) {
+        ticks = event->oneshot_ticks;
+        if (am_timer_is_due_tick(timer)) {
+            ticks = ticks + 1 - timer->tick;
+        }
+    }
     timer->crit_exit();
 
     return ticks;
 }
+
+/**
+ * Get number of ticks till the earliest timer event of the list is sent.
+ *
+ * Must be called from critical section.
+ *
+ * @param timer     the timer state
+ * @param events    the list of armed timer events
+ * @param deadline  the number of ticks to compare with or 0
+ *
+ * @return the smaller of the number of ticks and @p deadline
+ *         or 0, if both are not available
+ */
+static uint32_t am_timer_get_list_deadline(
+    const struct am_timer* timer,
+    const struct am_dlist* events,
+    uint32_t deadline
+) {
+    struct am_dlist_iterator it;
+    am_dlist_iterator_init(
+        AM_CAST(struct am_dlist*, events), &it, AM_DLIST_FORWARD
+    );
+    struct am_dlist_item* p = NULL;
+    while ((p = am_dlist_iterator_next(&it)) != NULL) {
+        const struct am_timer_event* event =
+            AM_CONTAINER_OF(p, struct am_timer_event, item);
+        if (event->disarm_pending) {
+            continue;
+        }
+        uint32_t ticks = event->oneshot_ticks;
+        if (am_timer_is_due_tick(timer)) {
+            ticks = ticks + 1 - timer->tick;
+        }
+        if (!deadline || (ticks < deadline)) {
+            deadline = ticks;
+        }
+    }
+    return deadline;
+}
+
+uint32_t am_timer_get_next_deadline(const struct am_timer* timer) {
+    AM_ASSERT(timer);
+
+    timer->crit_enter();
+
+    uint32_t deadline = 0;
+    if (timer->wheel) {
+        deadline = am_timer_wheel_get_next_deadline(timer);
+    } else if (timer->heap.events) {
+        if (timer->heap.nevents > 0) {
+            const struct am_timer_event* event = timer->heap.events[0];
+            deadline = event->oneshot_ticks + 1 - timer->tick;
+        }
+    } else {
+        deadline = am_timer_get_list_deadline(timer, &timer->events, deadline);
+    }
+    deadline = am_timer_get_list_deadline(timer, &timer->events_pend, deadline);
+
+    timer->crit_exit();
+
+    return deadline;
+}
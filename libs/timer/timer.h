@@ -38,12 +38,46 @@
 
 #include "common/alignment.h"
 #include "event/event_common.h"
-#include "slist/slist.h"
+#include "dlist/dlist.h"
+
+#ifndef AM_TIMER_WHEEL_SLOT_BITS
+/**
+ * Each timing wheel level has 2^AM_TIMER_WHEEL_SLOT_BITS slots
+ * (see am_timer_init_wheel()).
+ */
+#define AM_TIMER_WHEEL_SLOT_BITS 6
+#endif
+
+#ifndef AM_TIMER_WHEEL_LEVELS
+/**
+ * The number of timing wheel levels (see am_timer_init_wheel()).
+ *
+ * The timing wheel covers
+ * 2^(AM_TIMER_WHEEL_SLOT_BITS * AM_TIMER_WHEEL_LEVELS) ticks.
+ * The timer events armed further ahead are placed to the last level
+ * and re-placed, when the last level slot is reached.
+ */
+#define AM_TIMER_WHEEL_LEVELS 4
+#endif
+
+/** The number of timing wheel slots per level. */
+#define AM_TIMER_WHEEL_SLOTS (1 << AM_TIMER_WHEEL_SLOT_BITS)
+
+/** Hierarchical timing wheel (see am_timer_init_wheel()). */
+struct am_timer_wheel {
+    /**
+     * Armed timer events.
+     * The level L slot holds the timer events due in
+     * [2^(AM_TIMER_WHEEL_SLOT_BITS * L), 2^(AM_TIMER_WHEEL_SLOT_BITS * (L+1)))
+     * ticks counted from the moment the timer events were placed to the slot.
+     */
+    struct am_dlist slots[AM_TIMER_WHEEL_LEVELS][AM_TIMER_WHEEL_SLOTS];
+};
 
 /** Timer state. */
 struct am_timer {
     /** A list of armed timer events. */
-    struct am_slist events;
+    struct am_dlist events;
     /**
      * List of armed pending timer events.
      * Each armed timer event is first placed into this list
@@ -53,8 +87,11 @@ struct am_timer {
      * This is done to limit the armed timer events list operations
      * exclusively to am_timer_tick_iterator_init() call to avoid race
      * conditions between timer event owners the ticker task/ISR.
+     *
+     * The timing wheel keeps the armed pending timer events here too
+     * till they are placed to the timing wheel slots.
      */
-    struct am_slist events_pend;
+    struct am_dlist events_pend;
     /** number of timer events */
     struct {
         int pend;    /**< armed pending timer events count */
@@ -62,10 +99,40 @@ struct am_timer {
     } nevents;
 
     /** Armed events iterator. */
-    struct am_slist_iterator it;
+    struct am_dlist_iterator it;
+    /** the number of ticks handled by the current tick iteration */
+    uint32_t nticks;
+
+    /** timing wheel or NULL (see am_timer_init_wheel()) */
+    struct am_timer_wheel* wheel;
+    /**
+     * timer events fired on the current tick
+     * (timing wheel and min-heap only)
+     */
+    struct am_dlist fired;
+    /**
+     * the number of the tick to be handled next
+     * (timing wheel and min-heap only)
+     */
+    uint32_t tick;
+
+    /** min-heap of armed timer events (see am_timer_init_heap()) */
+    struct {
+        /** the heap storage or NULL */
+        struct am_timer_event** events;
+        /** the number of timer events in the heap */
+        int nevents;
+        /** the heap storage capacity */
+        int capacity;
+    } heap;
 
     void (*crit_enter)(void); /**< Enter critical section. */
     void (*crit_exit)(void);  /**< Exit critical section. */
+
+    /** timer event arming callback (see am_timer_register_arm_cb()) */
+    void (*arm_cb)(void* ctx);
+    /** timer event arming callback context */
+    void* arm_ctx;
 };
 
 /** Timer event. */
@@ -74,14 +141,21 @@ struct am_timer_event {
     struct am_event event;
 
     /** to link timer events together */
-    struct am_slist_item item;
+    struct am_dlist_item item;
 
     /** the timer event owner */
     struct am_timer* owner;
 
-    /** the timer event is sent after this many ticks */
+    /**
+     * The timer event is sent after this many ticks.
+     * The timing wheel and min-heap keep the number of the tick,
+     * at which the timer event is to be sent, here instead.
+     */
     uint32_t oneshot_ticks;
 
+    /** the timer event index in min-heap (see am_timer_init_heap()) */
+    int heap_index;
+
     /** the timer event is re-sent after this many ticks */
     uint32_t interval_ticks : 31;
 
@@ -116,6 +190,65 @@ extern "C" {
  */
 void am_timer_init(struct am_timer* timer);
 
+/**
+ * Timer state initialization with hierarchical timing wheel.
+ *
+ * By default the armed timer events are kept in a list, which is walked
+ * every tick. So, the tick takes O(number of armed timer events).
+ * This is fine for a small number of timer events.
+ *
+ * The timing wheel keeps the armed timer events in the lists (slots)
+ * of @p wheel instead. The timer events are placed to the slots by
+ * the ticks they are due at. Arming and disarming take O(1).
+ * Every tick only handles one slot of the timing wheel, so the tick
+ * takes O(number of fired timer events). The timer events due in more than
+ * 2^AM_TIMER_WHEEL_SLOT_BITS ticks are moved to lower levels
+ * of the timing wheel once per 2^AM_TIMER_WHEEL_SLOT_BITS ticks of
+ * the lower level, which amortizes to O(1) per tick.
+ *
+ * Armed timer events are placed to the timing wheel slots
+ * in next am_timer_tick_iterator_init() call.
+ * Disarmed timer events are removed from the timing wheel immediately.
+ *
+ * The timer API is the same for both cases.
+ *
+ * @param timer  the timer state
+ * @param wheel  the timing wheel storage.
+ *               Must remain valid for the lifetime of the timer state.
+ */
+void am_timer_init_wheel(struct am_timer* timer, struct am_timer_wheel* wheel);
+
+/**
+ * Timer state initialization with min-heap.
+ *
+ * An alternative to the timing wheel (see am_timer_init_wheel())
+ * for sparse and widely spread deadlines.
+ *
+ * The armed timer events are kept in intrusive 4-ary min-heap
+ * ordered by the ticks they are due at. Arming and disarming take
+ * O(log(number of armed timer events)). The earliest deadline
+ * is always at the top of the heap, so a tick only handles the
+ * timer events fired on the tick and am_timer_get_next_deadline()
+ * takes O(1) plus O(number of armed pending timer events).
+ * There is no per tick walk over armed timer events and no limit
+ * on the number of ticks the timer events are due in.
+ *
+ * Armed timer events are placed to the heap in next
+ * am_timer_tick_iterator_init() call.
+ * Disarmed timer events are removed from the heap immediately.
+ *
+ * The timer API is the same for all cases.
+ *
+ * @param timer     the timer state
+ * @param heap      the heap storage.
+ *                  Must remain valid for the lifetime of the timer state.
+ * @param capacity  the heap storage capacity.
+ *                  The maximum number of armed timer events.
+ */
+void am_timer_init_heap(
+    struct am_timer* timer, struct am_timer_event* heap[], int capacity
+);
+
 /**
  * Timer event constructor.
  *
@@ -155,16 +288,63 @@ void am_timer_register_cbs(
     struct am_timer* timer, void (*crit_enter)(void), void (*crit_exit)(void)
 );
 
+/**
+ * Register timer event arming callback.
+ *
+ * The callback is called by am_timer_arm() every time a timer event
+ * is armed. The callback is called outside of critical section.
+ *
+ * Used to wake up tickless ticker (see am_ticker_cfg::tickless_cb),
+ * so that it re-reads the next deadline with am_timer_get_next_deadline(),
+ * if a sooner timer event was armed. For example, by calling
+ * am_ticker_notify() from the callback.
+ *
+ * @param timer   the timer state
+ * @param arm_cb  the callback
+ * @param ctx     the callback context
+ */
+void am_timer_register_arm_cb(
+    struct am_timer* timer, void (*arm_cb)(void* ctx), void* ctx
+);
+
 /**
  * Initialize tick iterator.
  *
  * Must be called exactly once every ticks and must precede
  * am_timer_tick_iterator_next() calls.
  *
+ * Same as am_timer_tick_iterator_init_x(timer, 1).
+ *
  * @param timer  timer state
  */
 void am_timer_tick_iterator_init(struct am_timer* timer);
 
+/**
+ * Initialize tick iterator for several ticks at once.
+ *
+ * Advances the timer by the given number of ticks in one step.
+ * Used by tickless tickers, which sleep till the next deadline
+ * (see am_timer_get_next_deadline()) instead of ticking every tick.
+ *
+ * Must precede am_timer_tick_iterator_next() calls, which then return
+ * all timer events fired during the ticks.
+ *
+ * Each timer event fires at most once per iteration.
+ * The periodic timer events, which missed several intervals,
+ * keep their phase and fire next time at the first interval boundary
+ * after the ticks.
+ *
+ * The timer events armed since the previous iteration are counted
+ * as armed during the last of the ticks. So, tickless tickers should
+ * call this function with 0 ticks as soon as possible after timer events
+ * are armed (see am_timer_register_arm_cb()) to start counting them.
+ *
+ * @param timer  timer state
+ * @param ticks  the number of ticks to advance the timer by.
+ *               Can be 0, in which case no timer events fire.
+ */
+void am_timer_tick_iterator_init_x(struct am_timer* timer, uint32_t ticks);
+
 /**
  * Iterate tick to next timer event.
  *
@@ -214,6 +394,8 @@ void am_timer_arm(
  *
  * The disarmed event is only marked for removal with this function.
  * The actual removal happens on next tick.
+ * With timing wheel (see am_timer_init_wheel()) the disarmed event
+ * is removed immediately.
  * It is fine to disarm an already disarmed timer event.
  *
  * @param timer   the timer state
@@ -274,6 +456,29 @@ uint32_t am_timer_get_ticks(
     const struct am_timer* timer, const struct am_timer_event* event
 );
 
+/**
+ * Get number of ticks till the earliest armed timer event is sent.
+ *
+ * Tickless tickers sleep this number of ticks and then call
+ * am_timer_tick_iterator_init_x() with the number of the elapsed ticks.
+ *
+ * Takes O(number of armed timer events) without timing wheel or min-heap.
+ * The min-heap (see am_timer_init_heap()) takes O(1) for the timer events
+ * armed before the current tick iteration.
+ * The timing wheel (see am_timer_init_wheel()) only checks its slots.
+ * So, it may return the tick at which the earliest timer events
+ * are moved from higher timing wheel levels to lower levels instead.
+ * The returned value is never greater than the exact one.
+ *
+ * To be called after the tick iteration is complete.
+ *
+ * @param timer  the timer state
+ *
+ * @return the number of ticks till the earliest armed timer event is sent
+ *         or 0, if there are no armed timer events
+ */
+uint32_t am_timer_get_next_deadline(const struct am_timer* timer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,88 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Binary event trace unit tests.
+ */
+
+#include <stdint.h>
+
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "trace/trace.h"
+
+static uint32_t m_trace_now;
+
+static uint32_t test_trace_get_time(void) { return ++m_trace_now; }
+
+static void test_trace(void) {
+    struct am_trace_slot slots[4];
+    am_trace_init(slots, AM_COUNTOF(slots), test_trace_get_time);
+
+    struct am_event event = {.id = AM_EVT_USER, .pool_index_plus_one = 2};
+
+    struct am_trace_rec recs[8];
+    AM_ASSERT(0 == am_trace_drain(recs, AM_COUNTOF(recs)));
+
+    /* two laps over the trace buffer with one record dropped per lap */
+    for (int lap = 0; lap < 2; ++lap) {
+        for (int i = 0; i < 5; ++i) {
+            event.id = (uint16_t)(AM_EVT_USER + i);
+            am_trace_write(AM_TRACE_POST, /*prio=*/i, &event);
+        }
+        AM_ASSERT((unsigned)(lap + 1) == am_trace_get_dropped());
+
+        int n = am_trace_drain(recs, AM_COUNTOF(recs));
+        AM_ASSERT(4 == n);
+        for (int i = 0; i < n; ++i) {
+            const struct am_trace_rec* rec = &recs[i];
+            AM_ASSERT(AM_TRACE_POST == rec->type);
+            AM_ASSERT((AM_EVT_USER + i) == rec->id);
+            AM_ASSERT(i == rec->prio);
+            AM_ASSERT(2 == rec->pool);
+            AM_ASSERT((uint32_t)(lap * 4 + i + 1) == rec->time);
+        }
+    }
+
+    /* partial drain */
+    am_trace_write(AM_TRACE_ALLOCATE, AM_TRACE_PRIO_NONE, &event);
+    am_trace_write(AM_TRACE_FREE, AM_TRACE_PRIO_NONE, &event);
+    AM_ASSERT(1 == am_trace_drain(recs, /*nrecs=*/1));
+    AM_ASSERT(AM_TRACE_ALLOCATE == recs[0].type);
+    AM_ASSERT(AM_TRACE_PRIO_NONE == recs[0].prio);
+    AM_ASSERT(1 == am_trace_drain(recs, AM_COUNTOF(recs)));
+    AM_ASSERT(AM_TRACE_FREE == recs[0].type);
+
+    am_trace_stop();
+    am_trace_write(AM_TRACE_PUBLISH, AM_TRACE_PRIO_NONE, &event);
+    AM_ASSERT(0 == am_trace_drain(recs, AM_COUNTOF(recs)));
+}
+
+int main(void) {
+    test_trace();
+    return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Binary event trace API implementation.
+ *
+ * The trace buffer is a bounded lock-free multi-producer single-consumer
+ * queue of fixed size slots. Every slot has a sequence number telling
+ * writers and the reader, if the slot is free or holds a record.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "event/event_common.h"
+#include "trace/trace.h"
+
+/** Trace buffer state. */
+static struct am_trace {
+    struct am_trace_slot* slots; /**< the trace buffer */
+    uint32_t mask;               /**< the number of slots minus one */
+    uint32_t (*get_time)(void);  /**< the time source */
+    uint32_t wr;                 /**< the next write position */
+    uint32_t rd;                 /**< the next read position */
+    unsigned dropped;            /**< the number of dropped records */
+    bool enabled;                /**< the records are written */
+} am_trace_;
+
+void am_trace_init(
+    struct am_trace_slot slots[], int nslots, uint32_t (*get_time)(void)
+) {
+    AM_ASSERT(slots);
+    AM_ASSERT(nslots > 0);
+    AM_ASSERT(0 == (nslots & (nslots - 1)));
+    AM_ASSERT(get_time);
+
+    struct am_trace* me = &am_trace_;
+    AM_ATOMIC_STORE_N(&me->enabled, false);
+
+    memset(me, 0, sizeof(*me));
+    me->slots = slots;
+    me->mask = (uint32_t)nslots - 1;
+    me->get_time = get_time;
+    for (int i = 0; i < nslots; ++i) {
+        slots[i].seq = (uint32_t)i;
+    }
+
+    AM_ATOMIC_STORE_N(&me->enabled, true);
+}
+
+void am_trace_stop(void) { AM_ATOMIC_STORE_N(&am_trace_.enabled, false); }
+
+void am_trace_write(
+    enum am_trace_type type, int prio, const struct am_event* event
+) {
+    AM_ASSERT(event);
+    AM_ASSERT((prio >= 0) && (prio <= AM_TRACE_PRIO_NONE));
+
+    struct am_trace* me = &am_trace_;
+    if (!AM_ATOMIC_LOAD_N(&me->enabled)) {
+        return;
+    }
+
+    struct am_trace_slot* slot = NULL;
+    uint32_t pos = AM_ATOMIC_LOAD_N(&me->wr);
+    for (;;) {
+        slot = &me->slots[pos & me->mask];
+        uint32_t seq = AM_ATOMIC_LOAD_N(&slot->seq);
+        int32_t diff = (int32_t)(seq - pos);
+        if (0 == diff) {
+            /* the slot is free: try to take it */
+            if (AM_ATOMIC_COMPARE_EXCHANGE_N(&me->wr, &pos, pos + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* the slot is not drained yet: the buffer is full */
+            AM_ATOMIC_FETCH_ADD(&me->dropped, 1U);
+            return;
+        } else {
+            /* the slot was taken by another writer */
+            pos = AM_ATOMIC_LOAD_N(&me->wr);
+        }
+    }
+
+    struct am_trace_rec* rec = &slot->rec;
+    rec->time = me->get_time();
+    rec->id = (uint16_t)event->id;
+    rec->prio = (uint16_t)prio;
+    rec->type = (uint8_t)type;
+    rec->pool = (uint8_t)event->pool_index_plus_one;
+    rec->reserved = 0;
+
+    /* publish the record to the reader */
+    AM_ATOMIC_STORE_N(&slot->seq, pos + 1);
+}
+
+int am_trace_drain(struct am_trace_rec recs[], int nrecs) {
+    AM_ASSERT(recs);
+    AM_ASSERT(nrecs > 0);
+
+    struct am_trace* me = &am_trace_;
+    AM_ASSERT(me->slots);
+
+    int n = 0;
+    while (n < nrecs) {
+        struct am_trace_slot* slot = &me->slots[me->rd & me->mask];
+        if (AM_ATOMIC_LOAD_N(&slot->seq) != (me->rd + 1)) {
+            break; /* empty or the record is still being written */
+        }
+        recs[n++] = slot->rec;
+        /* free the slot for the writers of the next lap */
+        AM_ATOMIC_STORE_N(&slot->seq, me->rd + me->mask + 1);
+        ++me->rd;
+    }
+    return n;
+}
+
+unsigned am_trace_get_dropped(void) {
+    return AM_ATOMIC_LOAD_N(&am_trace_.dropped);
+}
@@ -0,0 +1,176 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Binary event trace API declaration.
+ */
+
+#ifndef AM_TRACE_H_INCLUDED
+#define AM_TRACE_H_INCLUDED
+
+#include <stdint.h>
+
+#include "common/macros.h"
+#include "event/event_common.h"
+
+/** No active object priority is associated with trace record. */
+#define AM_TRACE_PRIO_NONE 0xFFFF
+
+/** Trace record types. */
+enum am_trace_type {
+    /** event was posted to active object */
+    AM_TRACE_POST = 1,
+    /** event was published */
+    AM_TRACE_PUBLISH,
+    /** active object started to handle event */
+    AM_TRACE_DISPATCH_BEGIN,
+    /** active object finished to handle event */
+    AM_TRACE_DISPATCH_END,
+    /** event was allocated from event pool */
+    AM_TRACE_ALLOCATE,
+    /** event was returned to event pool */
+    AM_TRACE_FREE
+};
+
+/**
+ * Trace record.
+ *
+ * The binary format of trace records drained with am_trace_drain().
+ * Host byte order.
+ */
+struct am_trace_rec {
+    /** the time stamp (see am_trace_init()) */
+    uint32_t time;
+    /** event ID */
+    uint16_t id;
+    /** active object priority or #AM_TRACE_PRIO_NONE */
+    uint16_t prio;
+    /** record type (see enum am_trace_type) */
+    uint8_t type;
+    /** event pool index plus one or zero for static events */
+    uint8_t pool;
+    /** reserved */
+    uint16_t reserved;
+};
+
+AM_ASSERT_STATIC(sizeof(struct am_trace_rec) == 12);
+
+/**
+ * Trace buffer slot.
+ *
+ * Only exposed to allow trace users to allocate (possibly static) memory
+ * for trace buffer.
+ */
+struct am_trace_slot {
+    /** the slot sequence number */
+    uint32_t seq;
+    /** the trace record */
+    struct am_trace_rec rec;
+};
+
+#ifdef AM_TRACE_ENABLED
+/**
+ * Write trace record.
+ *
+ * Compiles to nothing, if AM_TRACE_ENABLED is not defined.
+ *
+ * @param type   the record type (see enum am_trace_type)
+ * @param prio   the active object priority or #AM_TRACE_PRIO_NONE
+ * @param event  the event
+ */
+#define AM_TRACE(type, prio, event) am_trace_write(type, prio, event)
+#else
+#define AM_TRACE(type, prio, event) (void)0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Initialize trace buffer.
+ *
+ * Trace records are only written after the initialization.
+ *
+ * @param slots     the trace buffer
+ * @param nslots    the number of slots in @p slots. Must be power of two.
+ * @param get_time  the time source of trace records
+ */
+void am_trace_init(
+    struct am_trace_slot slots[], int nslots, uint32_t (*get_time)(void)
+);
+
+/**
+ * Stop writing trace records.
+ *
+ * The records written so far can still be drained.
+ */
+void am_trace_stop(void);
+
+/**
+ * Write trace record.
+ *
+ * Thread safe and lock-free. Can be called by any number of writers
+ * in parallel. The record is dropped, if the trace buffer is full.
+ * Use AM_TRACE() macro instead to allow compiling the tracing out.
+ *
+ * @param type   the record type
+ * @param prio   the active object priority or #AM_TRACE_PRIO_NONE
+ * @param event  the event
+ */
+void am_trace_write(
+    enum am_trace_type type, int prio, const struct am_event* event
+);
+
+/**
+ * Drain trace records.
+ *
+ * Copies the oldest trace records from the trace buffer and
+ * frees their slots for writers.
+ *
+ * Lock-free. Must only be called by one reader, which is typically
+ * a background task writing the records to a file or a link.
+ *
+ * @param recs   the trace records are copied here
+ * @param nrecs  the maximum number of records to copy
+ *
+ * @return the number of copied records
+ */
+int am_trace_drain(struct am_trace_rec recs[], int nrecs);
+
+/**
+ * Get the number of dropped trace records.
+ *
+ * @return the number of records dropped due to full trace buffer
+ */
+unsigned am_trace_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AM_TRACE_H_INCLUDED */
@@ -0,0 +1,124 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Background task draining binary event trace API implementation.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "common/compiler.h"
+#include "common/macros.h"
+#include "pal/pal.h"
+#include "trace/trace.h"
+#include "trace/trace_drain.h"
+
+/** The number of trace records drained in one go. */
+#define AM_TRACE_DRAIN_NRECS 16
+
+/** Trace drain task state. */
+static struct am_trace_drain {
+    struct am_trace_drain_cfg cfg; /**< the task configuration */
+    int task_id;                   /**< the drain task */
+    int waiter_id;                 /**< the task waiting for the stop */
+    bool stop;                     /**< the drain task is to stop */
+    bool done;                     /**< the drain task has stopped */
+} am_trace_drain_;
+
+static void am_trace_drain_task(void* param) {
+    struct am_trace_drain* me = (struct am_trace_drain*)param;
+    const int task_id = am_task_get_own_id();
+    struct am_trace_rec recs[AM_TRACE_DRAIN_NRECS];
+    for (;;) {
+        /* the records written before the stop are drained below */
+        bool stop = AM_ATOMIC_LOAD_N(&me->stop);
+        int n = am_trace_drain(recs, AM_COUNTOF(recs));
+        if (n) {
+            me->cfg.write(me->cfg.ctx, recs, n);
+            continue;
+        }
+        if (stop) {
+            break;
+        }
+        (void)am_task_wait_timeout(task_id, me->cfg.period_ms);
+    }
+    AM_ATOMIC_STORE_N(&me->done, true);
+    am_task_notify(me->waiter_id);
+}
+
+void am_trace_drain_start(const struct am_trace_drain_cfg* cfg) {
+    AM_ASSERT(cfg);
+    AM_ASSERT(cfg->write);
+
+    struct am_trace_drain* me = &am_trace_drain_;
+    me->cfg = *cfg;
+    me->cfg.period_ms = AM_MAX(1U, cfg->period_ms);
+    me->waiter_id = AM_TASK_ID_NONE;
+    AM_ATOMIC_STORE_N(&me->stop, false);
+    AM_ATOMIC_STORE_N(&me->done, false);
+
+    me->task_id = am_task_create(
+        "trace_drain",
+        cfg->prio,
+        cfg->stack,
+        cfg->stack_size,
+        /*init=*/NULL,
+        /*entry=*/am_trace_drain_task,
+        /*flags=*/0,
+        /*arg=*/me
+    );
+}
+
+void am_trace_drain_stop(void) {
+    struct am_trace_drain* me = &am_trace_drain_;
+    AM_ASSERT(me->task_id != AM_TASK_ID_NONE);
+
+    am_trace_stop();
+
+    me->waiter_id = am_task_get_own_id();
+    AM_ATOMIC_STORE_N(&me->stop, true);
+    am_task_notify(me->task_id);
+    while (!AM_ATOMIC_LOAD_N(&me->done)) {
+        am_task_wait(me->waiter_id);
+    }
+    me->task_id = AM_TASK_ID_NONE;
+}
+
+void am_trace_drain_write_file(
+    void* ctx, const struct am_trace_rec recs[], int nrecs
+) {
+    AM_ASSERT(ctx);
+    AM_ASSERT(recs);
+    AM_ASSERT(nrecs > 0);
+
+    FILE* file = (FILE*)ctx;
+    size_t written = fwrite(recs, sizeof(recs[0]), (size_t)nrecs, file);
+    AM_ASSERT((size_t)nrecs == written);
+}
@@ -0,0 +1,109 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) Adel Mamin
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+ * @file
+ *
+ * Background task draining binary event trace API declaration.
+ */
+
+#ifndef AM_TRACE_DRAIN_H_INCLUDED
+#define AM_TRACE_DRAIN_H_INCLUDED
+
+#include <stdint.h>
+
+#include "trace/trace.h"
+
+/** Trace drain task configuration. */
+struct am_trace_drain_cfg {
+    /**
+     * Trace records sink.
+     *
+     * Called from the drain task with the drained records.
+     * am_trace_drain_write_file() writes them to a file.
+     *
+     * @param ctx    the sink context (am_trace_drain_cfg::ctx)
+     * @param recs   the drained records
+     * @param nrecs  the number of records in @p recs
+     */
+    void (*write)(void* ctx, const struct am_trace_rec recs[], int nrecs);
+    /** the sink context */
+    void* ctx;
+    /**
+     * The drain task polls the trace buffer with this period [ms],
+     * while the buffer is empty. 0 is same as 1.
+     */
+    uint32_t period_ms;
+    /** the drain task priority (see am_task_create()) */
+    int prio;
+    /** the drain task stack */
+    void* stack;
+    /** the drain task stack size [bytes] */
+    int stack_size;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start the trace drain task.
+ *
+ * The task drains trace records to the sink till am_trace_drain_stop()
+ * is called. Must be called after am_pal_global_init() and
+ * am_trace_init(). The task is the only reader of the trace buffer:
+ * am_trace_drain() must not be called by the application.
+ *
+ * @param cfg  the task configuration. Copied.
+ */
+void am_trace_drain_start(const struct am_trace_drain_cfg* cfg);
+
+/**
+ * Stop tracing and the trace drain task.
+ *
+ * Calls am_trace_stop() and blocks till the drain task passes
+ * the remaining trace records to the sink and exits.
+ */
+void am_trace_drain_stop(void);
+
+/**
+ * Trace records file sink.
+ *
+ * Writes the records to a file in the binary format
+ * of struct am_trace_rec.
+ *
+ * @param ctx    the file (FILE*) opened for binary writing
+ * @param recs   the records to write
+ * @param nrecs  the number of records in @p recs
+ */
+void am_trace_drain_write_file(
+    void* ctx, const struct am_trace_rec recs[], int nrecs
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AM_TRACE_DRAIN_H_INCLUDED */